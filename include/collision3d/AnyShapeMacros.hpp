@@ -5,15 +5,22 @@
 #pragma once
 
 #include "CollisionShapes_Primitives.hpp"
+#include "SpecialisedCollisionShapes.hpp"
 #include "CollisionShapes_HeightMap.hpp"
+#include "CollisionShapes_TriangleMesh.hpp"
+#include "CollisionShapes_ConvexHull.hpp"
 
 #define EACH_PRIMITIVE(CLASS, MACRO, CODE)                                     \
 	MACRO(CLASS, CODE, ., VertBox, vertBox, VERTBOX)                           \
 	MACRO(CLASS, CODE, ., Cylinder, cylinder, CYLINDER)                        \
 	MACRO(CLASS, CODE, ., Sphere, sphere, SPHERE)                              \
-	MACRO(CLASS, CODE, ., RampRectangle, rampRectangle, RAMP_RECTANGLE)
-// 	MACRO(CLASS, CODE, ., VerticalTriangle, vertTriangle, VERTICAL_TRIANGLE)   \
-// 	MACRO(CLASS, CODE, ., RampTriangle, rampTriangle, RAMP_TRIANGLE)
+	MACRO(CLASS, CODE, ., RampRectangle, rampRectangle, RAMP_RECTANGLE)        \
+	MACRO(CLASS, CODE, ., VerticalTriangle, vertTriangle, VERTICAL_TRIANGLE)   \
+	MACRO(CLASS, CODE, ., RampTriangle, rampTriangle, RAMP_TRIANGLE)           \
+	MACRO(CLASS, CODE, ., Triangle60, triangle60, TRIANGLE_60)                 \
+	MACRO(CLASS, CODE, ., Triangle90_45, triangle90_45, TRIANGLE_90_45)        \
+	MACRO(CLASS, CODE, ., VerticalCone, vertCone, VERTICAL_CONE)               \
+	MACRO(CLASS, CODE, ., VerticalCapsule, vertCapsule, VERTICAL_CAPSULE)
 
 #define SWITCH_CASES(CLASS, CODE, DEREF, SHAPE, NAME, INDEX)                   \
 	case CLASS::INDEX: {                                                       \
@@ -37,10 +44,10 @@ CLASS::CLASS(SHAPE &&NAME, Transform trans) \
 	}
 
 #define SIMPLE_CODE_DO_COPY(SHAPE, NAME, INDEX, DEREF)                         \
-	NAME = other.NAME;
+	new (&NAME) SHAPE(other.NAME);
 
 #define SIMPLE_CODE_DO_MOVE(SHAPE, NAME, INDEX, DEREF)                         \
-	NAME = std::move(other.NAME);
+	new (&NAME) SHAPE(std::move(other.NAME));
 
 #define SIMPLE_CODE_CALL_DESTRUCTOR(SHAPE, NAME, INDEX, DEREF)                 \
 	NAME.~SHAPE();
@@ -56,16 +63,67 @@ CLASS::CLASS(SHAPE &&NAME, Transform trans) \
 		return false;                                                          \
 	}
 
+#define CODE_OCCLUSION_TEST(SHAPE, NAME, INDEX, DEREF) \
+		return NAME DEREF OcclusionTest(trans * Transform{this->pos, this->rot}, ray);
+
+#define CODE_OVERLAP_TEST(SHAPE, NAME, INDEX, DEREF) \
+		return NAME DEREF OverlapTest(trans * Transform{this->pos, this->rot}, volume);
+
 #define CODE_CYLINDER_TEST_ON_GROUND(SHAPE, NAME, INDEX, DEREF) \
 		return NAME DEREF CylinderTestOnGround(trans * Transform{this->pos, this->rot}, cyl, pos, offsetHeight, onGroundNormal, isOnEdge);
 
 #define CODE_CYLINDER_TEST_MOVEMENT(SHAPE, NAME, INDEX, DEREF) \
 		return NAME DEREF CylinderTestMovement(trans * Transform{this->pos, this->rot}, validMovementFactor, cyl, movementRay, normal);
 
+#define CODE_SPHERE_TEST_MOVEMENT(SHAPE, NAME, INDEX, DEREF) \
+		return NAME DEREF SphereTestMovement(trans * Transform{this->pos, this->rot}, validMovementFactor, sph, movementRay, normal);
+
+#define CODE_RAY_TEST_MASKED(SHAPE, NAME, INDEX, DEREF)                        \
+	if (NAME DEREF RayTest(trans * Transform{this->pos, this->rot}, ray, near, \
+						   normal, queryMask)) {                               \
+		normal = (trans.rot + this->rot) * normal;                             \
+		return true;                                                           \
+	} else {                                                                   \
+		return false;                                                          \
+	}
+
+#define CODE_OCCLUSION_TEST_MASKED(SHAPE, NAME, INDEX, DEREF) \
+		return NAME DEREF OcclusionTest(trans * Transform{this->pos, this->rot}, ray, queryMask);
+
+#define CODE_OVERLAP_TEST_MASKED(SHAPE, NAME, INDEX, DEREF) \
+		return NAME DEREF OverlapTest(trans * Transform{this->pos, this->rot}, volume, queryMask);
+
+#define CODE_RAY_TEST_ALL_MASKED(SHAPE, NAME, INDEX, DEREF) \
+		NAME DEREF RayTestAll(trans * Transform{this->pos, this->rot}, ray, hits, queryMask); \
+		return;
+
+#define CODE_OVERLAP_ALL_MASKED(SHAPE, NAME, INDEX, DEREF) \
+		return NAME DEREF OverlapAll(trans * Transform{this->pos, this->rot}, volume, ids, maxIds, queryMask);
+
+#define CODE_CYLINDER_TEST_ON_GROUND_MASKED(SHAPE, NAME, INDEX, DEREF) \
+		return NAME DEREF CylinderTestOnGround(trans * Transform{this->pos, this->rot}, cyl, pos, offsetHeight, onGroundNormal, isOnEdge, queryMask);
+
+#define CODE_CYLINDER_TEST_MOVEMENT_MASKED(SHAPE, NAME, INDEX, DEREF) \
+		return NAME DEREF CylinderTestMovement(trans * Transform{this->pos, this->rot}, validMovementFactor, cyl, movementRay, normal, queryMask);
+
+#define CODE_SPHERE_TEST_MOVEMENT_MASKED(SHAPE, NAME, INDEX, DEREF) \
+		return NAME DEREF SphereTestMovement(trans * Transform{this->pos, this->rot}, validMovementFactor, sph, movementRay, normal, queryMask);
+
+// Shapes containing primitives, they declare
+// COLLISION_SHAPE_MASKED_METHODS_DECLARATION()
+#define EACH_COMPOUND_SHAPE(CLASS, MACRO, CODE)                                \
+	MACRO(CLASS, CODE, ., CompoundPrimitive, compound, COMPOUND)               \
+	MACRO(CLASS, CODE, ., SmallCompound, smallCompound, SMALL_COMPOUND)        \
+	MACRO(CLASS, CODE, ., PackedCompound, packedCompound, PACKED_COMPOUND)     \
+	MACRO(CLASS, CODE, ., CompoundInstance, compoundInstance,                  \
+		  COMPOUND_INSTANCE)
+
 #define EACH_SHAPE(CLASS, MACRO, CODE)                                         \
 	EACH_PRIMITIVE(CLASS, MACRO, CODE)                                         \
-	MACRO(CLASS, CODE, ., CompoundPrimitive, compound, COMPOUND)               \
-	MACRO(CLASS, CODE, ., HeightMap, heightMap, HEIGHT_MAP)
+	EACH_COMPOUND_SHAPE(CLASS, MACRO, CODE)                                    \
+	MACRO(CLASS, CODE, ., HeightMap, heightMap, HEIGHT_MAP)                    \
+	MACRO(CLASS, CODE, ., TriangleMesh, triangleMesh, TRIANGLE_MESH)          \
+	MACRO(CLASS, CODE, ., ConvexHull, convexHull, CONVEX_HULL)
 
 #define DEFINITION_ENUM_VALUES(CLASS, CODE, DEREF, SHAPE, NAME, INDEX)               \
 	INDEX = TypesShared::Enum::INDEX,
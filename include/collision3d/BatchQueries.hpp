@@ -0,0 +1,53 @@
+// This file is part of Collision3D.
+// Copyright (c) 2025 Marek Zalewski aka Drwalin
+// You should have received a copy of the MIT License along with this program.
+
+#pragma once
+
+#include "CollisionShapes_AnyOrCompound.hpp"
+#include "BatchTransform.hpp"
+
+namespace Collision3D
+{
+struct RayQuery {
+	const AnyShape *shape;
+	Transform trans;
+	RayInfo ray;
+	LayerMask queryMask = LAYER_MASK_ALL;
+};
+
+struct RayQueryResult {
+	float near;
+	glm::vec3 normal;
+	bool hit;
+};
+
+struct CylinderMovementQuery {
+	const AnyShape *shape;
+	Transform trans;
+	Cylinder cyl;
+	RayInfo movementRay;
+	LayerMask queryMask = LAYER_MASK_ALL;
+};
+
+struct CylinderMovementResult {
+	float validMovementFactor;
+	glm::vec3 normal;
+	bool hit;
+};
+
+// Queries are grouped by AnyShape::type and each group is processed by loop
+// specialised for that shape, instead of switching on type per query.
+// results[i] is the same as calling the masked AnyShape method for
+// queries[i].
+void BatchRayTest(const RayQuery *queries, uint32_t count,
+				  RayQueryResult *results);
+void BatchCylinderTestMovement(const CylinderMovementQuery *queries,
+							   uint32_t count,
+							   CylinderMovementResult *results);
+
+// out[i] = shapes[i].GetAabb(transforms[i]), Cylinders and VertBoxes use SoA
+// kernels from BatchTransform.hpp
+void GetAabbs(const AnyShape *shapes, const Transform *transforms,
+			  AabbSoA out, uint32_t count);
+} // namespace Collision3D
@@ -0,0 +1,92 @@
+// This file is part of Collision3D.
+// Copyright (c) 2025 Marek Zalewski aka Drwalin
+// You should have received a copy of the MIT License along with this program.
+
+#pragma once
+
+#include <cstdint>
+
+#include "CollisionShapes_Primitives.hpp"
+
+namespace Collision3D
+{
+// Structure of arrays of vectors, all arrays have the same length
+struct Vec3SoA {
+	float *x;
+	float *y;
+	float *z;
+};
+
+struct ConstVec3SoA {
+	const float *x;
+	const float *y;
+	const float *z;
+};
+
+// Aabbs as separate min/max component arrays, as consumed by broadphase
+// update
+struct AabbSoA {
+	Vec3SoA min;
+	Vec3SoA max;
+
+	inline spp::Aabb Get(uint32_t i) const
+	{
+		return {{min.x[i], min.y[i], min.z[i]}, {max.x[i], max.y[i], max.z[i]}};
+	}
+
+	inline void Set(uint32_t i, const spp::Aabb &aabb)
+	{
+		min.x[i] = aabb.min.x;
+		min.y[i] = aabb.min.y;
+		min.z[i] = aabb.min.z;
+		max.x[i] = aabb.max.x;
+		max.y[i] = aabb.max.y;
+		max.z[i] = aabb.max.z;
+	}
+};
+
+// Instruction set variant of batch kernels
+enum class SimdIsa : uint8_t {
+	SCALAR = 0,
+	SSE4_2 = 1,
+	AVX2 = 2,
+	AVX512 = 3,
+};
+
+// Variant is chosen at first use from cpu features. Environment variable
+// COLLISION3D_SIMD (scalar, sse4.2, avx2, avx512) can lower it.
+SimdIsa GetSimdIsa();
+// Override for benchmarking and testing, variants above what cpu supports
+// are clamped. Returns variant in use.
+SimdIsa SetSimdIsa(SimdIsa isa);
+
+// Batch versions of single element operations, vector variants process 4,
+// 8 or 16 elements at once with cos/sin gathered from Rotation::vecs.
+// Output may alias input.
+
+// out[i] = rotations[i] * in[i]
+void RotatePoints(const Rotation *rotations, ConstVec3SoA in, Vec3SoA out,
+				  uint32_t count);
+
+// out[i] = transforms[i].ToLocal(in[i])
+void ToLocalPoints(const Transform *transforms, ConstVec3SoA in, Vec3SoA out,
+				   uint32_t count);
+
+// out[i] = transforms[i].ToLocal(rays[i]), invDir and signs are recomputed
+// for rotated rays
+void TransformRays(const Transform *transforms, const RayInfo *rays,
+				   RayInfo *out, uint32_t count);
+
+// out[i] = shapes[i].GetAabb(transforms[i])
+void GetAabbs(const Cylinder *shapes, const Transform *transforms,
+			  AabbSoA out, uint32_t count);
+void GetAabbs(const VertBox *shapes, const Transform *transforms,
+			  AabbSoA out, uint32_t count);
+
+// Slab test of one ray against many aabbs, e.g. broadphase or compound
+// pruning. Writes indices of aabbs entered at factor in [0, cutFactor], or
+// containing ray start, to hitIds in increasing order and returns their
+// number. hitIds needs space for count indices.
+uint32_t RayTestAabbs(const RayInfo &ray, float cutFactor, AabbSoA aabbs,
+					  uint32_t count, uint32_t *hitIds);
+} // namespace Collision3D
@@ -9,6 +9,7 @@
 #include "../../SpatialPartitioning/include/spatial_partitioning/RayInfo.hpp"
 #include "../../SpatialPartitioning/include/spatial_partitioning/Aabb.hpp"
 
+#include "ForwardDeclarations.hpp"
 #include "Transform.hpp"
 #include "MathUtil.hpp"
 
@@ -17,27 +18,225 @@ namespace Collision3D
 using namespace spp;
 
 struct Cylinder;
+struct Sphere;
 
 bool TestPlaneIterational(glm::vec3 normal, float d, const RayInfo &ray,
 						  float &near, float &far, int &frontNormal,
 						  int &backNormal, int id);
+// Ray against convex polyhedron given by planes
+// (dot(normals[i], p) <= offsets[i] inside), normals need not be unit.
+// Ray starting inside hits at near = 0 with normal of nearest plane.
+// Planes are converted to SoA and tested with RayTestConvexSoA().
+bool RayTestConvex(const glm::vec3 *normals, const float *offsets,
+				   int planesCount, const RayInfo &ray, float &near,
+				   glm::vec3 &normal);
+
+constexpr inline int RAY_TEST_CONVEX_MAX_PLANES = 64;
+// Planes count of RayTestConvexSoA() is multiple of CONVEX_SOA_WIDTH, rest is
+// filled with zero normals and CONVEX_SOA_PAD_OFFSET, such planes never clip.
+constexpr inline int CONVEX_SOA_WIDTH = 8;
+constexpr inline float CONVEX_SOA_PAD_OFFSET = 1e30f;
+
+// Same as RayTestConvex() for unit normals in SoA. All planes are clipped in
+// one branchless pass with min/max reduction of near and far, plane of hit is
+// searched only after hit was found.
+bool RayTestConvexSoA(const float *nx, const float *ny, const float *nz,
+					  const float *offsets, int planesCount,
+					  const RayInfo &ray, float &near, glm::vec3 &normal);
+
+// Vertical cylinder treated as square base prism with origin at center of
+// base, moving along ray against triangle.
+bool CylinderTestMovementTriangle(glm::vec3 a, glm::vec3 b, glm::vec3 c,
+								  float radius, float height,
+								  const RayInfo &ray, float &near,
+								  glm::vec3 &normal);
+
+// Swept sphere tests. Sphere center moves from ray.start to ray.end, near is
+// factor of first contact in [0, 1] and normal points from shape to sphere
+// center. Sphere overlapping at start gives near = 0.
+bool SweptSphereTestPoint(glm::vec3 point, float radius, const RayInfo &ray,
+						  float &near, glm::vec3 &normal);
+bool SweptSphereTestSegment(glm::vec3 a, glm::vec3 b, float radius,
+							const RayInfo &ray, float &near,
+							glm::vec3 &normal);
+// Convex polyhedron given by unit plane normals with offsets
+// (dot(normals[i], p) <= offsets[i] inside), vertices and edges as pairs of
+// vertex indices. Planes may be degenerate, e.g. two opposite planes of
+// a triangle.
+bool SweptSphereTestConvex(const glm::vec3 *normals, const float *offsets,
+						   int planesCount, const glm::vec3 *vertices,
+						   int verticesCount, const uint8_t (*edges)[2],
+						   int edgesCount, float radius, const RayInfo &ray,
+						   float &near, glm::vec3 &normal);
+bool SweptSphereTestTriangle(glm::vec3 a, glm::vec3 b, glm::vec3 c,
+							 float radius, const RayInfo &ray, float &near,
+							 glm::vec3 &normal);
+// Vertical cylinder with origin at center of base, rounded by radius
+bool SweptSphereTestCylinder(float height, float cylinderRadius, float radius,
+							 const RayInfo &ray, float &near,
+							 glm::vec3 &normal);
 
 constexpr inline float ON_EDGE_FACTOR = 0.03f;
+
+// Surface with given normal (not necessarily normalized) can be stood on
+// when it is at most 45 degrees from horizontal
+inline bool IsGroundNormal(glm::vec3 normal)
+{
+	return normal.y > 0.0f &&
+		   normal.y * normal.y >= normal.x * normal.x + normal.z * normal.z;
+}
+
+// Intersection reported by RayTestAll()
+struct RayHit {
+	float near;
+	glm::vec3 normal;
+	// Index of primitive in compound, of triangle in TriangleMesh, of lowest
+	// corner of cell in HeightMap, 0 for other shapes
+	uint32_t primitiveId;
+};
+
+// Caller provided storage of RayTestAll(). Hits are kept sorted by near, when
+// full only nearest maxHits hits are kept. The same buffer can gather hits of
+// many shapes.
+struct RayHitBuffer {
+	RayHit *hits = nullptr;
+	uint32_t maxHits = 0;
+	uint32_t count = 0;
+
+	inline bool IsFull() const { return count >= maxHits; }
+
+	// Hits further than this are rejected, traversals use it as cut factor
+	inline float CutFactor() const
+	{
+		if (IsFull()) {
+			return count ? hits[count - 1].near : -1.0f;
+		}
+		return 1.0f;
+	}
+
+	// Returns false when hit was rejected
+	inline bool Add(const RayHit &hit)
+	{
+		if (hit.near > CutFactor()) {
+			return false;
+		}
+		uint32_t i = IsFull() ? count - 1 : count++;
+		for (; i > 0 && hits[i - 1].near > hit.near; --i) {
+			hits[i] = hits[i - 1];
+		}
+		hits[i] = hit;
+		return true;
+	}
+};
+
+// Volume of overlap queries: aabb, vertical cylinder or sphere. In local
+// space of shape aabb becomes box rotated around Y.
+struct OverlapVolume {
+	enum Type : uint8_t { BOX = 0, CYLINDER = 1, SPHERE = 2 };
+
+	// Center of box, center of base of cylinder or center of sphere
+	glm::vec3 pos;
+	// Of box
+	glm::vec3 halfExtents;
+	// Of cylinder and sphere
+	float radius;
+	// Of cylinder
+	float height;
+	// Of box
+	Rotation rot;
+	Type type;
+
+	static OverlapVolume FromAabb(const spp::Aabb &aabb);
+	static OverlapVolume FromCylinder(const Cylinder &cyl, glm::vec3 pos);
+	static OverlapVolume FromSphere(const Sphere &sph, glm::vec3 pos);
+
+	// The same volume in space of shape placed at trans
+	OverlapVolume ToLocal(const Transform &trans) const;
+	spp::Aabb GetAabb() const;
+	// Furthest point of volume in direction dir
+	glm::vec3 Support(glm::vec3 dir) const;
+};
+
+// Overlap of convex hull of vertices rounded by radius with volume, tested
+// with GJK. Touching within float precision counts as overlap.
+bool OverlapTestConvex(const glm::vec3 *vertices, int verticesCount,
+					   float radius, const OverlapVolume &volume);
+// Vertical capped cone with origin at center of base, cylinder when both
+// radii are equal
+bool OverlapTestCone(float height, float bottomRadius, float topRadius,
+					 const OverlapVolume &volume);
+
+// Edges of box-like polyhedron with vertices indexed by bits x = 1, y = 2,
+// z = 4
+constexpr inline uint8_t HEXAHEDRON_EDGES[12][2] = {
+	{0, 1}, {2, 3}, {4, 5}, {6, 7}, {0, 2}, {1, 3},
+	{4, 6}, {5, 7}, {0, 4}, {1, 5}, {2, 6}, {3, 7}};
+
+constexpr inline uint8_t TRIANGLE_EDGES[3][2] = {{0, 1}, {1, 2}, {2, 0}};
+
+// Edges of triangular prism with vertices 0-2 at bottom and 3-5 above them
+constexpr inline uint8_t TRIANGULAR_PRISM_EDGES[9][2] = {
+	{0, 1}, {1, 2}, {2, 0}, {3, 4}, {4, 5}, {5, 3}, {0, 3}, {1, 4}, {2, 5}};
 } // namespace Collision3D
 
+// OcclusionTest() returns on any hit in [0, 1] without searching for the
+// nearest one and without computing normal
 #define COLLISION_SHAPE_METHODS_DECLARATION()                                  \
 	spp::Aabb GetAabb(const Transform &trans) const;                           \
 	bool RayTest(const Transform &trans, const RayInfo &ray, float &near,      \
 				 glm::vec3 &normal) const;                                     \
 	bool RayTestLocal(const RayInfo &ray, float &near, glm::vec3 &normal)      \
 		const;                                                                 \
+	bool OcclusionTest(const Transform &trans, const RayInfo &ray) const;      \
+	bool OverlapTest(const Transform &trans, const OverlapVolume &volume)      \
+		const;                                                                 \
 	bool CylinderTestMovement(const Transform &trans,                          \
 							  float &validMovementFactor, const Cylinder &cyl, \
 							  const RayInfo &movementRay, glm::vec3 &normal)   \
 		const;                                                                 \
 	bool CylinderTestOnGround(const Transform &trans, const Cylinder &cyl,     \
 							  glm::vec3 pos, float &offsetHeight,              \
-							  glm::vec3 *onGroundNormal, bool *isOnEdge) const;
+							  glm::vec3 *onGroundNormal, bool *isOnEdge) const; \
+	bool SphereTestMovement(const Transform &trans,                            \
+							float &validMovementFactor, const Sphere &sph,     \
+							const RayInfo &movementRay, glm::vec3 &normal)     \
+		const;
+
+// Overloads of queries that skip primitives whose layer mask does not share
+// any bit with queryMask. Declared by shapes that contain primitives.
+#define COLLISION_SHAPE_MASKED_METHODS_DECLARATION()                           \
+	bool RayTest(const Transform &trans, const RayInfo &ray, float &near,      \
+				 glm::vec3 &normal, LayerMask queryMask) const;                \
+	bool RayTestLocal(const RayInfo &ray, float &near, glm::vec3 &normal,      \
+					  LayerMask queryMask) const;                              \
+	bool OcclusionTest(const Transform &trans, const RayInfo &ray,             \
+					   LayerMask queryMask) const;                             \
+	bool OverlapTest(const Transform &trans, const OverlapVolume &volume,      \
+					 LayerMask queryMask) const;                               \
+	bool CylinderTestMovement(const Transform &trans,                          \
+							  float &validMovementFactor, const Cylinder &cyl, \
+							  const RayInfo &movementRay, glm::vec3 &normal,   \
+							  LayerMask queryMask) const;                      \
+	bool CylinderTestOnGround(const Transform &trans, const Cylinder &cyl,     \
+							  glm::vec3 pos, float &offsetHeight,              \
+							  glm::vec3 *onGroundNormal, bool *isOnEdge,       \
+							  LayerMask queryMask) const;                      \
+	bool SphereTestMovement(const Transform &trans,                            \
+							float &validMovementFactor, const Sphere &sph,     \
+							const RayInfo &movementRay, glm::vec3 &normal,     \
+							LayerMask queryMask) const;
+
+// RayTestAll() gathers hits of every primitive crossed by ray, in single
+// traversal of compound. Each primitive gives its nearest hit.
+// OverlapAll() writes indices of up to maxIds primitives overlapping volume
+// to ids and returns their number.
+#define COLLISION_SHAPE_ALL_HITS_METHODS_DECLARATION()                         \
+	void RayTestAll(const Transform &trans, const RayInfo &ray,                \
+					RayHitBuffer &hits,                                        \
+					LayerMask queryMask = LAYER_MASK_ALL) const;               \
+	uint32_t OverlapAll(const Transform &trans, const OverlapVolume &volume,   \
+						uint32_t *ids, uint32_t maxIds,                        \
+						LayerMask queryMask = LAYER_MASK_ALL) const;
 
 #define CYLINDER_TEST_ON_GROUND_ASSUME_COLLISION2D()                           \
 	void CylinderTestOnGroundAssumeCollision2D(                                \
@@ -6,4 +6,6 @@
 
 #include "CollisionShapes_Primitives.hpp"
 #include "CollisionShapes_HeightMap.hpp"
+#include "CollisionShapes_TriangleMesh.hpp"
+#include "CollisionShapes_ConvexHull.hpp"
 #include "CollisionShapes_AnyOrCompound.hpp"
@@ -4,6 +4,9 @@
 
 #pragma once
 
+#include <atomic>
+#include <vector>
+
 #include "../../SpatialPartitioning/include/spatial_partitioning/TypedArray.hpp"
 #include "../../SpatialPartitioning/include/spatial_partitioning/EntityTypes.hpp"
 
@@ -15,8 +18,18 @@ class BvhMedianSplitHeap;
 
 #include "ForwardDeclarations.hpp"
 #include "CollisionAlgorithms.hpp"
+#include "CompactBvh.hpp"
 #include "AnyShapeMacros.hpp"
 
+// Number of primitives stored inline by SmallCompound. Default keeps
+// SmallCompound no bigger than PackedCompound, the largest other member of
+// AnyShape, so it does not grow every shape. Bigger compounds are better
+// served by CompoundInstance with shared bvh.
+#ifndef COLLISION3D_SMALL_COMPOUND_CAPACITY
+#define COLLISION3D_SMALL_COMPOUND_CAPACITY 2
+#define COLLISION3D_SMALL_COMPOUND_CAPACITY_DEFAULT
+#endif
+
 namespace Collision3D
 {
 namespace TypesShared
@@ -29,6 +42,15 @@ enum Enum : uint8_t {
 	RAMP_RECTANGLE = 4,
 	VERTICAL_TRIANGLE = 5,
 	RAMP_TRIANGLE = 6,
+	TRIANGLE_60 = 7,
+	TRIANGLE_90_45 = 8,
+	VERTICAL_CONE = 9,
+	VERTICAL_CAPSULE = 10,
+	CONVEX_HULL = 57,
+	TRIANGLE_MESH = 58,
+	PACKED_COMPOUND = 59,
+	SMALL_COMPOUND = 60,
+	COMPOUND_INSTANCE = 61,
 	HEIGHT_MAP = 62,
 	COMPOUND = 63,
 };
@@ -47,6 +69,7 @@ struct AnyPrimitive {
 		INVALID = 0,
 		EACH_PRIMITIVE(AnyPrimitive, DEFINITION_ENUM_VALUES, EMPTY_CODE)
 	} type = INVALID;
+	LayerMask layerMask = LAYER_MASK_ALL;
 
 	EACH_PRIMITIVE(AnyPrimitive, DECLARATION_CONSTRUCTORS_MOVE, EMPTY_CODE)
 
@@ -61,6 +84,49 @@ struct AnyPrimitive {
 	AnyPrimitive &operator=(const AnyPrimitive &other) = default;
 
 	COLLISION_SHAPE_METHODS_DECLARATION()
+	COLLISION_SHAPE_MASKED_METHODS_DECLARATION()
+};
+
+// Non owning view of primitives, tests all of them without acceleration
+// structure. Shared by compounds too small to have bvh.
+struct PrimitiveSpan {
+	const AnyPrimitive *data = nullptr;
+	uint32_t count = 0;
+	// Optional local aabbs of primitives, ray tests skip primitives entered
+	// behind the nearest hit found so far
+	const spp::Aabb *aabbs = nullptr;
+
+	const AnyPrimitive *begin() const { return data; }
+	const AnyPrimitive *end() const { return data + count; }
+
+	COLLISION_SHAPE_METHODS_DECLARATION()
+	COLLISION_SHAPE_MASKED_METHODS_DECLARATION()
+	COLLISION_SHAPE_ALL_HITS_METHODS_DECLARATION()
+};
+
+// Compound with primitives stored inline, does not allocate
+struct SmallCompound {
+	static constexpr uint32_t CAPACITY = COLLISION3D_SMALL_COMPOUND_CAPACITY;
+
+	AnyPrimitive primitives[CAPACITY];
+	uint32_t count = 0;
+
+	// Returns false when full
+	bool Add(const AnyPrimitive &primitive);
+
+	PrimitiveSpan Span() const { return {primitives, count}; }
+
+	COLLISION_SHAPE_METHODS_DECLARATION()
+	COLLISION_SHAPE_MASKED_METHODS_DECLARATION()
+	COLLISION_SHAPE_ALL_HITS_METHODS_DECLARATION()
+};
+
+// Result of CompoundPrimitive::Simplify()
+struct CompoundSimplifyStats {
+	uint32_t primitivesBefore = 0;
+	uint32_t primitivesAfter = 0;
+	uint32_t mergedBoxes = 0;
+	uint32_t removedContained = 0;
 };
 
 struct CompoundPrimitive {
@@ -68,21 +134,165 @@ struct CompoundPrimitive {
 	using BvhType =
 		spp::BvhMedianSplitHeap<spp::Aabb, uint32_t, uint32_t, 0, 1, void>;
 	BvhType *bvh = nullptr;
+	// Used instead of bvh when Optimise() was given node format
+	CompactBvh *compactBvh = nullptr;
+	// Local aabbs of primitives, cached by Optimise() when there are too few
+	// primitives for bvh. Ignored when size differs from primitives.
+	std::vector<spp::Aabb> localAabbs;
 
 	void Optimise();
+	void Optimise(BvhNodeFormat format,
+				  BvhBuilder builder = BvhBuilder::MEDIAN_SPLIT);
+
+	// Call after primitives with given indices were modified in place.
+	// compactBvh is refitted and rebuilt only when its quality degraded too
+	// much, spp bvh is always rebuilt, localAabbs are updated.
+	void UpdatePrimitives(const uint32_t *indices, uint32_t count);
+
+	// Bake time pass: merges side by side VertBoxes with the same rotation
+	// and layer mask whose union is a box and removes VertBoxes and Cylinders
+	// fully contained in a VertBox covering all their layers, with top level
+	// with its top. Hits and ground heights stay the same for every query
+	// mask, isOnEdge of ground test may differ. Existing bvh is rebuilt.
+	CompoundSimplifyStats Simplify(float epsilon = 0.0001f);
 
 	CompoundPrimitive() = default;
 	~CompoundPrimitive();
 
-	CompoundPrimitive(CompoundPrimitive &other) = default;
-	CompoundPrimitive(CompoundPrimitive &&other) = default;
-	CompoundPrimitive(const CompoundPrimitive &other) = default;
+	// Copies clone bvh, moves take it over
+	CompoundPrimitive(CompoundPrimitive &other);
+	CompoundPrimitive(CompoundPrimitive &&other);
+	CompoundPrimitive(const CompoundPrimitive &other);
+
+	CompoundPrimitive &operator=(CompoundPrimitive &other);
+	CompoundPrimitive &operator=(CompoundPrimitive &&other);
+	CompoundPrimitive &operator=(const CompoundPrimitive &other);
+
+	PrimitiveSpan Span() const
+	{
+		if (primitives.size == 0) {
+			return {};
+		}
+		if (localAabbs.size() == primitives.size) {
+			return {&primitives[0], primitives.size, localAabbs.data()};
+		}
+		return {&primitives[0], primitives.size};
+	}
+
+	COLLISION_SHAPE_METHODS_DECLARATION()
+	COLLISION_SHAPE_MASKED_METHODS_DECLARATION()
+	COLLISION_SHAPE_ALL_HITS_METHODS_DECLARATION()
+
+private:
+	void ClearBvh();
+	void CopyBvhFrom(const CompoundPrimitive &other);
+	void CacheLocalAabbs();
+};
+
+// Bounds of cylinder movement in space of compound given by trans
+spp::Aabb LocalMovementAabb(const Transform &trans, const Cylinder &cyl,
+							const RayInfo &movementRay);
+spp::Aabb LocalMovementAabb(const Transform &trans, const Sphere &sph,
+							const RayInfo &movementRay);
+// Unbounded vertical column containing cylinder footprint, with
+// ON_EDGE_FACTOR, in space of shape given by trans. Wide enough for
+// primitives which treat cylinder as square in their own rotation.
+spp::Aabb LocalGroundColumn(const Transform &trans, const Cylinder &cyl,
+							glm::vec3 pos);
+
+// Lossy 16 byte encoding of AnyPrimitive. Position is quantized to 16 bits
+// per axis inside PackedCompound bounds, shape dimensions are half floats.
+struct PackedPrimitive {
+	int16_t pos[3];
+	uint16_t dims[4];
+	// bits 0-7: rotation, bits 8-15: type
+	uint16_t typeRot;
+
+	void Encode(const AnyPrimitive &primitive, glm::vec3 origin,
+				glm::vec3 invScale);
+	AnyPrimitive Decode(glm::vec3 origin, glm::vec3 scale) const;
+};
+static_assert(sizeof(PackedPrimitive) == 16);
+
+// Read only compound made of PackedPrimitive, primitives are decoded while
+// queried. Layer masks are kept in separate array so that they can be tested
+// before decoding.
+struct PackedCompound {
+	std::vector<PackedPrimitive> primitives;
+	std::vector<LayerMask> masks;
+	// Frame of quantized positions
+	glm::vec3 origin = {0, 0, 0};
+	glm::vec3 scale = {1, 1, 1};
+	// Built over decoded primitives when there are at least 12 of them
+	CompactBvh *compactBvh = nullptr;
+
+	PackedCompound() = default;
+	PackedCompound(const CompoundPrimitive &compound,
+				   BvhNodeFormat format = BvhNodeFormat::QUANTIZED_16,
+				   BvhBuilder builder = BvhBuilder::BINNED_SAH);
+	~PackedCompound();
+
+	PackedCompound(PackedCompound &other);
+	PackedCompound(PackedCompound &&other);
+	PackedCompound(const PackedCompound &other);
+
+	PackedCompound &operator=(PackedCompound &other);
+	PackedCompound &operator=(PackedCompound &&other);
+	PackedCompound &operator=(const PackedCompound &other);
+
+	inline AnyPrimitive Get(uint32_t id) const
+	{
+		AnyPrimitive p = primitives[id].Decode(origin, scale);
+		p.layerMask = masks[id];
+		return p;
+	}
+
+	COLLISION_SHAPE_METHODS_DECLARATION()
+	COLLISION_SHAPE_MASKED_METHODS_DECLARATION()
+	COLLISION_SHAPE_ALL_HITS_METHODS_DECLARATION()
+};
+
+// Immutable compound geometry shared by CompoundInstance shapes. Deleted
+// when last instance referencing it is destroyed.
+struct CompoundPrototype {
+	// Returned instance holds the only reference, further instances are its
+	// copies, so prototype can not leak nor be freed while referenced
+	static CompoundInstance Create(CompoundPrimitive &&compound);
+
+	void Acquire() const;
+	void Release() const;
+
+	const CompoundPrimitive compound;
+
+private:
+	CompoundPrototype(CompoundPrimitive &&compound);
+	~CompoundPrototype() = default;
+
+	mutable std::atomic<uint32_t> references = 0;
+};
+
+// Placement of CompoundPrototype, copying costs one atomic increment
+struct CompoundInstance {
+	CompoundInstance() = default;
+	~CompoundInstance();
+
+	// Shares prototype already owned by other instance
+	explicit CompoundInstance(const CompoundPrototype *prototype);
+	CompoundInstance(CompoundPrimitive &&compound);
+
+	CompoundInstance(CompoundInstance &other);
+	CompoundInstance(CompoundInstance &&other);
+	CompoundInstance(const CompoundInstance &other);
 
-	CompoundPrimitive &operator=(CompoundPrimitive &other) = default;
-	CompoundPrimitive &operator=(CompoundPrimitive &&other) = default;
-	CompoundPrimitive &operator=(const CompoundPrimitive &other) = default;
+	CompoundInstance &operator=(CompoundInstance &other);
+	CompoundInstance &operator=(CompoundInstance &&other);
+	CompoundInstance &operator=(const CompoundInstance &other);
 
 	COLLISION_SHAPE_METHODS_DECLARATION()
+	COLLISION_SHAPE_MASKED_METHODS_DECLARATION()
+	COLLISION_SHAPE_ALL_HITS_METHODS_DECLARATION()
+
+	const CompoundPrototype *prototype = nullptr;
 };
 
 struct AnyShape {
@@ -97,6 +307,7 @@ struct AnyShape {
 		INVALID = 0,
 		EACH_SHAPE(AnyShape, DEFINITION_ENUM_VALUES, EMPTY_CODE)
 	} type = INVALID;
+	LayerMask layerMask = LAYER_MASK_ALL;
 
 	EACH_SHAPE(AnyShape, DECLARATION_CONSTRUCTORS_MOVE, EMPTY_CODE)
 
@@ -120,5 +331,17 @@ struct AnyShape {
 	AnyShape &operator=(AnyPrimitive &&other);
 
 	COLLISION_SHAPE_METHODS_DECLARATION()
+	COLLISION_SHAPE_MASKED_METHODS_DECLARATION()
+	COLLISION_SHAPE_ALL_HITS_METHODS_DECLARATION()
 };
+
+#ifdef COLLISION3D_SMALL_COMPOUND_CAPACITY_DEFAULT
+// Union is as big as PackedCompound, followed by pos, rot, type and layerMask
+static_assert(sizeof(AnyShape) <= sizeof(PackedCompound) + 16,
+			  "AnyShape grew, its largest member should be PackedCompound");
+#endif
+
+// Returns SmallCompound when all primitives fit inline, otherwise compound
+// itself
+AnyShape CreateCompoundShape(CompoundPrimitive &&compound, Transform trans = {});
 } // namespace Collision3D
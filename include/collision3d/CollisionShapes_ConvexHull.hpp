@@ -0,0 +1,95 @@
+// This file is part of Collision3D.
+// Copyright (c) 2025 Marek Zalewski aka Drwalin
+// You should have received a copy of the MIT License along with this program.
+
+#pragma once
+
+#include <atomic>
+
+#include "CollisionAlgorithms.hpp"
+
+namespace Collision3D
+{
+// Planes, vertices and edges of ConvexHull in single allocation. Immutable
+// after Init(), so copies of hull share it.
+struct ConvexHull_Data {
+	size_t bytes;
+
+	// Number of ConvexHull objects sharing this data
+	std::atomic<uint32_t> references;
+
+	// Counts include padding planes
+	uint32_t planesCount;
+	uint32_t movementPlanesCount;
+	uint32_t verticesCount;
+	uint32_t edgesCount;
+
+	spp::Aabb localAabb;
+
+	// nx[n], ny[n], nz[n], offsets[n] of unit planes,
+	// n is multiple of CONVEX_SOA_WIDTH
+	float *planes;
+	// Planes of Minkowski sum with box: hull planes, axes and crosses of
+	// edges with axes. Same layout, offsets are support of hull only.
+	float *movementPlanes;
+	glm::vec3 *vertices;
+	// Pairs of vertex indices
+	uint8_t (*edges)[2];
+
+	// Returned data has single reference
+	static ConvexHull_Data *Allocate(uint32_t planesCount,
+									 uint32_t movementPlanesCount,
+									 uint32_t verticesCount,
+									 uint32_t edgesCount);
+	static void Free(ConvexHull_Data *data);
+};
+
+// Convex polyhedron given by up to MAX_PLANES planes, for convex props that
+// would otherwise need many primitives. Planes are stored in SoA and tested
+// with RayTestConvexSoA(). Too big for AnyPrimitive, so it is a shape of its
+// own. Cylinder is treated as square base prism. Copies share data.
+struct ConvexHull {
+	static constexpr uint32_t MAX_PLANES = 32;
+	// Planes of Minkowski sum with cylinder prism are bounded by this
+	static constexpr uint32_t MAX_MOVEMENT_PLANES =
+		MAX_PLANES + 6 + 6 * (3 * MAX_PLANES - 6) + CONVEX_SOA_WIDTH;
+
+	ConvexHull() = default;
+	~ConvexHull();
+
+	ConvexHull(ConvexHull &other);
+	ConvexHull(ConvexHull &&other);
+	ConvexHull(const ConvexHull &other);
+
+	ConvexHull &operator=(ConvexHull &other);
+	ConvexHull &operator=(ConvexHull &&other);
+	ConvexHull &operator=(const ConvexHull &other);
+
+	// Intersection of half spaces dot(normals[i], p) <= offsets[i], normals
+	// need not be unit. Redundant planes are dropped. Returns false when
+	// there are more than MAX_PLANES planes or result has no volume.
+	// Result has to be bounded.
+	bool Init(const glm::vec3 *normals, const float *offsets,
+			  uint32_t planesCount);
+
+	inline bool IsValid() const { return data != nullptr; }
+
+	// Counts include padding planes
+	inline uint32_t GetPlanesCount() const
+	{
+		return data ? data->planesCount : 0;
+	}
+	inline uint32_t GetMovementPlanesCount() const
+	{
+		return data ? data->movementPlanesCount : 0;
+	}
+
+	COLLISION_SHAPE_METHODS_DECLARATION()
+
+public:
+	ConvexHull_Data *data = nullptr;
+
+private:
+	void Release();
+};
+} // namespace Collision3D
@@ -11,6 +11,7 @@ namespace Collision3D
 {
 // Origin at vertex (0,0) with height=0
 // Assuming there is no lower points than Y=0
+// Copies share header, it is copied on first modification of shared map
 struct HeightMap {
 	using Type = HeightMap_Type;
 	using MaterialType = HeightMap_MaterialType;
@@ -32,6 +33,15 @@ struct HeightMap {
 	// Treating cylinder as point at it's origin
 	COLLISION_SHAPE_METHODS_DECLARATION()
 
+	// Gathers every triangle crossed by ray in single grid traversal
+	void RayTestAll(const Transform &trans, const RayInfo &ray,
+					RayHitBuffer &hits) const;
+	// Writes indices of lowest corners of up to maxIds cells overlapping
+	// volume to ids. Ground below surface down to Y=0 is solid.
+	uint32_t OverlapAll(const Transform &trans, const OverlapVolume &volume,
+						uint32_t *ids, uint32_t maxIds) const;
+
+	// Modifying methods, including Access*(), make header unique first
 	bool Update(glm::ivec2 coord, Type value);
 	Type Get(glm::ivec2 coord) const;
 	
@@ -48,11 +58,13 @@ struct HeightMap {
 									   glm::vec3 pos) const;
 	
 	bool IsValid() const;
+	bool IsShared() const;
 
 public:
 	HeightMap_Header *header = nullptr;
 
 private:
-	void CopyIntoThis(const HeightMap &src);
+	void Release();
+	void MakeUnique();
 };
 } // namespace Collision3D
@@ -4,6 +4,8 @@
 
 #pragma once
 
+#include <atomic>
+
 #include "CollisionAlgorithms.hpp"
 #include "ForwardDeclarations.hpp"
 
@@ -15,6 +17,9 @@ struct HeightMap_Header {
 
 	size_t bytes;
 
+	// Number of HeightMap objects sharing this header
+	std::atomic<uint32_t> references;
+
 	glm::vec2 size;
 
 	glm::vec3 scale;
@@ -32,7 +37,10 @@ struct HeightMap_Header {
 	MaterialType *material;
 
 public:
+	// Returned header has single reference
 	static HeightMap_Header *Allocate(glm::ivec2 resolution);
+	HeightMap_Header *Clone() const;
+	static void Free(HeightMap_Header *header);
 
 public:
 	glm::ivec2 ConvertGlobalPosToCoord(const Transform &trans,
@@ -49,13 +57,32 @@ public:
 
 	COLLISION_SHAPE_METHODS_DECLARATION()
 
+	void RayTestAll(const Transform &trans, const RayInfo &ray,
+					RayHitBuffer &hits) const;
+	uint32_t OverlapAll(const Transform &trans, const OverlapVolume &volume,
+						uint32_t *ids, uint32_t maxIds) const;
+
 private:
+	// Output of RayTestAll(), when given to grid traversal all hits are
+	// gathered instead of stopping at the nearest one
+	struct AllHits {
+		RayHitBuffer &hits;
+		Rotation rot;
+	};
+
+	// Local ray in space of grid cells
+	RayInfo ToGridRay(const RayInfo &localRay) const;
+
+	bool RayTestGridAnyDirection(const RayInfo &ray, float &near,
+								 glm::vec3 &normal, AllHits *all) const;
+
 	template <int DIR_SIGN_X, int DIR_SIGN_Z>
-	bool RayTestGrid(const RayInfo &ray, float &near, glm::vec3 &normal) const;
+	bool RayTestGrid(const RayInfo &ray, float &near, glm::vec3 &normal,
+					 AllHits *all) const;
 
 	template <int DIR_SIGN_X, int DIR_SIGN_Z>
 	bool RayTestCell(const RayInfo &ray, float &near, glm::vec3 &normal, int x,
-					 int z, bool &stopIterating) const;
+					 int z, bool &stopIterating, AllHits *all) const;
 
 	template <bool TOP_ELSE_DOWN>
 	bool TriangleRayTest(Type h00, Type hxy, Type h11, int x, int z,
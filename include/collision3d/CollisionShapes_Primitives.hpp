@@ -29,13 +29,32 @@ struct Cylinder {
 };
 
 // Origin at center
-// Ray only
 struct Sphere {
 	float radius;
 
 	COLLISION_SHAPE_METHODS_DECLARATION()
 };
 
+// Capped cone, origin at center of base
+// Radius changes linearly from bottomRadius at base to topRadius at height,
+// either of them may be 0
+struct VerticalCone {
+	float height;
+	float bottomRadius;
+	float topRadius;
+
+	COLLISION_SHAPE_METHODS_DECLARATION()
+};
+
+// Origin at lowest point, height includes both hemispheres and should be at
+// least 2 * radius
+struct VerticalCapsule {
+	float height;
+	float radius;
+
+	COLLISION_SHAPE_METHODS_DECLARATION()
+};
+
 // Origin at center and extends
 struct RampRectangle {
 	float halfWidth;		  // expands (-x/2 ; +x/2)
@@ -66,3 +85,5 @@ struct VerticalTriangle {
 	COLLISION_SHAPE_METHODS_DECLARATION()
 };
 } // namespace Collision3D
+
+#include "CollisionShapes_PrimitivesInline.hpp"
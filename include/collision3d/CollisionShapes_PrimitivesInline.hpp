@@ -0,0 +1,271 @@
+// This file is part of Collision3D.
+// Copyright (c) 2025 Marek Zalewski aka Drwalin
+// You should have received a copy of the MIT License along with this program.
+
+#pragma once
+
+// Hot methods of VertBox and Cylinder, defined inline so that StaticDispatch
+// and other callers with statically known type can inline and vectorise
+// them without link time optimisation. Included by
+// CollisionShapes_Primitives.hpp.
+
+#include "CollisionShapes_Primitives.hpp"
+
+namespace Collision3D
+{
+inline spp::Aabb VertBox::GetAabb(const Transform &trans) const
+{
+	const int quarterTurns = trans.rot.QuarterTurns();
+	if (quarterTurns >= 0) {
+		// Box stays axis aligned, only x and z extents may swap
+		const glm::vec3 he = quarterTurns & 1
+								 ? glm::vec3{halfExtents.z, 0, halfExtents.x}
+								 : glm::vec3{halfExtents.x, 0, halfExtents.z};
+		glm::vec3 min = trans.pos - he, max = trans.pos + he;
+		max.y += halfExtents.y * 2.0f;
+		return {min, max};
+	}
+
+	Rotation rot = trans.rot;
+	if (rot.value >= 120) {
+		rot.value -= 120;
+	}
+
+	glm::vec3 min = trans.pos, max = trans.pos;
+	max.y += halfExtents.y * 2.0f;
+
+	const glm::vec2 x = rot * glm::vec2{halfExtents.x, 0};
+	const glm::vec2 z = rot * glm::vec2{0, halfExtents.z};
+
+	const glm::vec2 a = glm::abs(x + z);
+	const glm::vec2 b = glm::abs(x - z);
+	const glm::vec2 c = glm::abs(-x + z);
+	const glm::vec2 d = glm::abs(-x - z);
+
+	const glm::vec2 min2 = glm::max(a, glm::max(b, glm::max(c, d)));
+
+	min.x -= min2.x;
+	min.z -= min2.y;
+	max.x += min2.x;
+	max.z += min2.y;
+
+	return {min, max};
+}
+
+// Slab test of ray against box, normal of entered face
+inline bool FastRayTest2(const glm::vec3 min, const glm::vec3 max,
+						 const RayInfo &ray, float &near, glm::vec3 &normal)
+{
+	assert(glm::all(glm::lessThanEqual(min, max)));
+	alignas(16) glm::vec3 bounds[2] = {min, max};
+	alignas(16) glm::vec3 tmin, tmax;
+
+	int normalAxis = 0;
+
+	for (int i = 0; i < 2; ++i) {
+		tmin[i] = (bounds[ray.signs[i]][i] - ray.start[i]) * ray.invDir[i];
+		tmax[i] = (bounds[1 - ray.signs[i]][i] - ray.start[i]) * ray.invDir[i];
+	}
+
+	if ((tmin.x > tmax.y) || (tmin.y > tmax.x))
+		return false;
+
+	if (tmin.y > tmin.x) {
+		tmin.x = tmin.y;
+		normalAxis = 1;
+	}
+
+	if (tmax.y < tmax.x) {
+		tmax.x = tmax.y;
+	}
+
+	for (int i = 2; i < 3; ++i) {
+		tmin[i] = (bounds[ray.signs[i]][i] - ray.start[i]) * ray.invDir[i];
+		tmax[i] = (bounds[1 - ray.signs[i]][i] - ray.start[i]) * ray.invDir[i];
+	}
+
+	if ((tmin.x > tmax.z) || (tmin.z > tmax.x)) {
+		return false;
+	}
+
+	if (tmin.z > tmin.x) {
+		normalAxis = 2;
+		tmin.x = tmin.z;
+	}
+	if (tmax.z < tmax.x) {
+		tmax.x = tmax.z;
+	}
+	near = tmin.x;
+	float far = tmax.x;
+
+	if (far < 0.0f)
+		return false;
+
+	if (near > far)
+		return false;
+
+	if (near <= 0.0f) {
+		near = 0.0f;
+
+		const glm::vec3 out[2] = {max - ray.start, min - ray.start};
+		const float o[5] = {out[0].x, out[0].z, out[1].x, out[1].z, out[0].y};
+		int id = 0;
+		for (int i = 1; i < 5; ++i) {
+			if (fabs(o[id]) > fabs(o[i])) {
+				id = i;
+			}
+		}
+		normal = {0, 0, 0};
+		normal[(id % 2) * 2] = (id / 2) ? -1 : 1;
+	} else {
+		normal = {0, 0, 0};
+		normal[normalAxis] = ray.signs[normalAxis] ? 1 : -1;
+		assert(glm::dot(normal, ray.dir) < 0);
+	}
+
+	return true;
+}
+
+inline bool VertBox::RayTest(const Transform &trans, const RayInfo &ray,
+							 float &near, glm::vec3 &normal) const
+{
+	if (RayTestLocal(trans.ToLocal(ray), near, normal)) {
+		normal = trans.rot * normal;
+		return true;
+	} else {
+		return false;
+	}
+}
+
+inline bool VertBox::RayTestLocal(const RayInfo &ray, float &near,
+								  glm::vec3 &normal) const
+{
+	glm::vec3 he = halfExtents;
+	glm::vec3 min = -he;
+	glm::vec3 max = he;
+	min.y += halfExtents.y;
+	max.y += halfExtents.y;
+	return FastRayTest2(min, max, ray, near, normal);
+}
+
+inline bool VertBox::CylinderTestMovement(const Transform &trans,
+										  float &validMovementFactor,
+										  const Cylinder &cyl,
+										  const RayInfo &movementRay,
+										  glm::vec3 &normal) const
+{
+	RayInfo movementRayLocal = trans.ToLocal(movementRay);
+
+	glm::vec3 he = halfExtents + glm::vec3(cyl.radius, 0, cyl.radius);
+	glm::vec3 min = -he;
+	glm::vec3 max = he;
+	min.y += halfExtents.y;
+	max.y += halfExtents.y;
+	min.y -= cyl.height;
+	if (FastRayTest2(min, max, movementRayLocal, validMovementFactor, normal)) {
+		if (validMovementFactor > 1.0f) {
+			validMovementFactor = 1.0f;
+			return false;
+		}
+		assert(validMovementFactor >= 0.0f);
+		normal = trans.rot * normal;
+		return true;
+	} else {
+		validMovementFactor = 1.0f;
+		return false;
+	}
+}
+
+inline spp::Aabb Cylinder::GetAabb(const Transform &trans) const
+{
+	glm::vec3 min = trans.pos - glm::vec3{radius, 0, radius};
+	glm::vec3 max = trans.pos + glm::vec3{radius, height, radius};
+	return {min, max};
+}
+
+// Ray against vertical cylinder with base center at pos
+inline bool CylinderIntersect(const RayInfo &ray, glm::vec3 pos, float height,
+							  float radius, float &near, glm::vec3 &normal)
+{
+	glm::vec3 ba = {0, height, 0};
+	glm::vec3 oc = ray.start - pos;
+	float baba = glm::dot(ba, ba);
+	float bard = glm::dot(ba, ray.dirNormalized);
+	float baoc = glm::dot(ba, oc);
+	float k2 = baba - bard * bard;
+	float k1 = baba * glm::dot(oc, ray.dirNormalized) - baoc * bard;
+	float k0 = baba * glm::dot(oc, oc) - baoc * baoc - radius * radius * baba;
+	float h = k1 * k1 - k2 * k0;
+	if (h < 0.0)
+		return false;
+	h = sqrt(h);
+	float t = (-k1 - h) / k2;
+	float t2 = (-k1 + h) / k2;
+	
+	if (t < 0 && t2 > 0) { // is probably inside
+		assert(glm::distance(glm::vec2{pos.x, pos.z}, {ray.start.x, ray.start.z}) <= radius * 1.01);
+		if (oc.y >= 0 && oc.y <= height) {
+			near = 0;
+			const glm::vec3 outDir = (ray.start - pos) * glm::vec3(1,0,1);
+			const float outDirLen = glm::length(outDir);
+			if (outDirLen < 0.0000001) {
+				normal = glm::vec3(1,0,0);
+				return true;
+			}
+			
+			normal = outDir / outDirLen;
+			return true;
+		}
+	}
+
+	// body
+	float y = baoc + t * bard;
+	if (y > 0.0 && y < baba) {
+		normal = (oc + t * ray.dirNormalized - ba * y / baba) / radius;
+		t /= ray.length;
+		near = t;
+		if (t <= 1.0f && t >= 0) {
+			return true;
+		}
+		return false;
+	}
+
+	// caps
+	t = (((y < 0.0) ? 0.0 : baba) - baoc) / bard;
+	if (glm::abs(k1 + k2 * t) < h) {
+		normal = ba * glm::sign(y) / (float)sqrt(baba);
+		t /= ray.length;
+		near = t;
+		if (t <= 1.0f && t >= 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+inline bool Cylinder::RayTest(const Transform &trans, const RayInfo &ray,
+							  float &near, glm::vec3 &normal) const
+{
+	return CylinderIntersect(ray, trans.pos, height, radius, near, normal);
+}
+
+inline bool Cylinder::RayTestLocal(const RayInfo &ray, float &near,
+								   glm::vec3 &normal) const
+{
+	// TODO: warn because it is slower
+	return CylinderIntersect(ray, {}, height, radius, near, normal);
+}
+
+inline bool Cylinder::CylinderTestMovement(const Transform &trans,
+										   float &validMovementFactor,
+										   const Cylinder &cyl,
+										   const RayInfo &movementRay,
+										   glm::vec3 &normal) const
+{
+	Cylinder cyl2 = {height + cyl.height, radius + cyl.radius};
+	return CylinderIntersect(
+		movementRay, trans.pos - glm::vec3(0, cyl.height, 0), cyl2.height,
+		cyl2.radius, validMovementFactor, normal);
+}
+
+} // namespace Collision3D
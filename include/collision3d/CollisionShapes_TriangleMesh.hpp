@@ -0,0 +1,77 @@
+// This file is part of Collision3D.
+// Copyright (c) 2025 Marek Zalewski aka Drwalin
+// You should have received a copy of the MIT License along with this program.
+
+#pragma once
+
+#include <atomic>
+#include <vector>
+
+#include "CollisionAlgorithms.hpp"
+#include "CompactBvh.hpp"
+
+namespace Collision3D
+{
+// Vertices, indices and bvh of TriangleMesh. Immutable after Build(), so
+// copies of mesh share it.
+struct TriangleMesh_Data {
+	// Number of TriangleMesh objects sharing this data
+	std::atomic<uint32_t> references = 1;
+
+	std::vector<glm::vec3> vertices;
+	// Three vertex indices per triangle
+	std::vector<uint32_t> indices;
+	CompactBvh compactBvh;
+};
+
+// Static mesh of indexed triangles for geometry too complex for primitives,
+// e.g. cave interiors. Triangles are two sided and infinitely thin. Arrays
+// are flat and compactBvh is single allocation, so baked mesh can be stored
+// as is. Cylinder is treated as square base prism. Copies share data.
+struct TriangleMesh {
+	TriangleMesh() = default;
+	~TriangleMesh();
+
+	TriangleMesh(TriangleMesh &other);
+	TriangleMesh(TriangleMesh &&other);
+	TriangleMesh(const TriangleMesh &other);
+
+	TriangleMesh &operator=(TriangleMesh &other);
+	TriangleMesh &operator=(TriangleMesh &&other);
+	TriangleMesh &operator=(const TriangleMesh &other);
+
+	// Replaces mesh and builds bvh over its triangles
+	void Build(const glm::vec3 *vertices, uint32_t verticesCount,
+			   const uint32_t *indices, uint32_t trianglesCount,
+			   BvhNodeFormat format = BvhNodeFormat::FLOAT,
+			   BvhBuilder builder = BvhBuilder::BINNED_SAH);
+
+	inline uint32_t GetTrianglesCount() const
+	{
+		return data ? data->indices.size() / 3 : 0;
+	}
+
+	inline void GetTriangle(uint32_t id, glm::vec3 *v) const
+	{
+		const glm::vec3 *vertices = data->vertices.data();
+		const uint32_t *indices = data->indices.data() + id * 3;
+		v[0] = vertices[indices[0]];
+		v[1] = vertices[indices[1]];
+		v[2] = vertices[indices[2]];
+	}
+
+	COLLISION_SHAPE_METHODS_DECLARATION()
+
+	// Gathers every triangle crossed by ray in single bvh traversal
+	void RayTestAll(const Transform &trans, const RayInfo &ray,
+					RayHitBuffer &hits) const;
+	// Writes indices of up to maxIds triangles overlapping volume to ids
+	uint32_t OverlapAll(const Transform &trans, const OverlapVolume &volume,
+						uint32_t *ids, uint32_t maxIds) const;
+
+private:
+	void Release();
+
+	TriangleMesh_Data *data = nullptr;
+};
+} // namespace Collision3D
@@ -0,0 +1,556 @@
+// This file is part of Collision3D.
+// Copyright (c) 2025 Marek Zalewski aka Drwalin
+// You should have received a copy of the MIT License along with this program.
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cassert>
+#include <cstring>
+
+#include <type_traits>
+#include <limits>
+#include <vector>
+
+#include "../../SpatialPartitioning/include/spatial_partitioning/RayInfo.hpp"
+#include "../../SpatialPartitioning/include/spatial_partitioning/Aabb.hpp"
+
+#include "ForwardDeclarations.hpp"
+#include "MathUtil.hpp"
+
+namespace Collision3D
+{
+enum class BvhNodeFormat : uint8_t {
+	FLOAT = 0,
+	QUANTIZED_16 = 1,
+	QUANTIZED_8 = 2,
+};
+
+enum class BvhBuilder : uint8_t {
+	MEDIAN_SPLIT = 0,
+	// Binned surface area heuristic, slower to build, better trees for
+	// irregular sets
+	BINNED_SAH = 1,
+};
+
+// Quantized bounds are relative to CompactBvh::totalAabb.min in units of
+// CompactBvh::scale. Min is rounded down and max is rounded up.
+// Quantized nodes pack index and count into one word, which keeps 8 bit node
+// at 12 bytes.
+template <typename T> struct CompactBvhNode {
+	static constexpr uint32_t MAX_INDEX = 0xFFFFFF;
+	static constexpr uint32_t MAX_COUNT = 0xFF;
+
+	// internal node: index of second child, first child is the next node
+	// leaf: offset of first item
+	uint32_t index : 24;
+	// 0 for internal nodes
+	uint32_t count : 8;
+	T min[3];
+	T max[3];
+	// Union of layer masks of all items in subtree
+	LayerMask mask;
+};
+
+template <> struct CompactBvhNode<float> {
+	static constexpr uint32_t MAX_INDEX = 0xFFFFFFFF;
+	static constexpr uint32_t MAX_COUNT = 0xFFFF;
+
+	uint32_t index;
+	float min[3];
+	float max[3];
+	LayerMask mask;
+	uint16_t count;
+};
+
+static_assert(sizeof(CompactBvhNode<float>) == 32);
+static_assert(sizeof(CompactBvhNode<uint16_t>) == 20);
+static_assert(sizeof(CompactBvhNode<uint8_t>) == 12);
+
+// Flat depth-first BVH over items given by their AABB. Nodes and item
+// indices are stored in single allocation.
+struct CompactBvh {
+	CompactBvh() = default;
+	~CompactBvh();
+
+	CompactBvh(const CompactBvh &other);
+	CompactBvh(CompactBvh &&other);
+
+	CompactBvh &operator=(const CompactBvh &other);
+	CompactBvh &operator=(CompactBvh &&other);
+
+	// Subtrees bigger than PARALLEL_MIN_ITEMS are queued to persistent pool
+	// of hardware_concurrency() - 1 workers shared by all builds.
+	// Without masks every item has LAYER_MASK_ALL. Trees with more than
+	// CompactBvhNode<uint8_t>::MAX_INDEX nodes are stored as FLOAT.
+	void Build(const spp::Aabb *aabbs, uint32_t count, BvhNodeFormat format,
+			   BvhBuilder builder = BvhBuilder::MEDIAN_SPLIT,
+			   const LayerMask *masks = nullptr);
+	void Clear();
+
+	// Updates bounds of changed items and of their ancestors without
+	// changing tree topology. spp::Aabb getAabb(uint32_t item)
+	// LayerMask getMask(uint32_t item), when given, updates masks of changed
+	// items. Walking up from changed leaves uses parent links built on first
+	// call. Tree quality is checked once changed items since last check
+	// reach itemsCount / REFIT_COST_CHECK_DIVISOR, returns false when it
+	// degraded by more than MAX_REFIT_COST_RATIO, then tree should be rebuilt.
+	template <typename F, typename M = std::nullptr_t>
+	bool Refit(const uint32_t *changedItems, uint32_t changedCount,
+			   F &&getAabb, M &&getMask = nullptr);
+
+	inline spp::Aabb GetTotalAabb() const { return totalAabb; }
+	size_t GetMemoryUsage() const;
+
+	// bool callback(uint32_t item, float &cutFactor)
+	// Returning true stops traversal. Subtrees without any item matching
+	// mask are skipped, items in visited leaves are not filtered. Node bounds
+	// are expanded by margin, e.g. radius of swept sphere.
+	template <typename CB>
+	void IntersectRay(const spp::RayInfo &ray, float &cutFactor,
+					  CB &&callback, LayerMask mask = LAYER_MASK_ALL,
+					  float margin = 0.0f) const;
+
+	// bool callback(uint32_t item)
+	// Returning true stops traversal. Filtering same as in IntersectRay.
+	template <typename CB>
+	void IntersectAabb(const spp::Aabb &aabb, CB &&callback,
+					   LayerMask mask = LAYER_MASK_ALL) const;
+
+public:
+	static constexpr uint32_t MAX_LEAF_ITEMS = 2;
+	static constexpr uint32_t MAX_SAH_LEAF_ITEMS = 8;
+	static constexpr uint32_t SAH_BINS = 12;
+	// Smaller subtrees are cheaper to build than to hand over to a worker
+	static constexpr uint32_t PARALLEL_MIN_ITEMS = 1024;
+	static constexpr uint32_t MAX_DEPTH = 64;
+	static constexpr float MAX_REFIT_COST_RATIO = 1.5f;
+	static constexpr uint32_t REFIT_COST_CHECK_DIVISOR = 8;
+
+	spp::Aabb totalAabb = spp::AABB_INVALID;
+	glm::vec3 scale = {1, 1, 1};
+	glm::vec3 invScale = {1, 1, 1};
+
+	uint32_t nodesCount = 0;
+	uint32_t itemsCount = 0;
+	BvhNodeFormat format = BvhNodeFormat::FLOAT;
+	BvhBuilder builder = BvhBuilder::MEDIAN_SPLIT;
+	// SAH cost of tree right after Build()
+	float buildCost = 0.0f;
+
+	// CompactBvhNode<T>[nodesCount] followed by uint32_t[itemsCount]
+	void *data = nullptr;
+
+	// Parent of each node and leaf node of each item, built by first Refit()
+	std::vector<uint32_t> refitParents;
+	std::vector<uint32_t> refitLeaves;
+	uint32_t refitChangedSinceCheck = 0;
+
+public:
+	template <typename T>
+	inline void EncodeBounds(const spp::Aabb &aabb,
+							 CompactBvhNode<T> &node) const
+	{
+		if constexpr (std::is_same_v<T, float>) {
+			for (int i = 0; i < 3; ++i) {
+				node.min[i] = aabb.min[i];
+				node.max[i] = aabb.max[i];
+			}
+		} else {
+			constexpr float QMAX = std::numeric_limits<T>::max();
+			const glm::vec3 origin = totalAabb.min;
+			for (int i = 0; i < 3; ++i) {
+				float mn = glm::floor((aabb.min[i] - origin[i]) * invScale[i]);
+				float mx = glm::ceil((aabb.max[i] - origin[i]) * invScale[i]);
+				// Rounding of invScale may move decoded value by ulp to the
+				// wrong side, fix it with the same expression as DecodeNode.
+				if (mn > 0.0f && origin[i] + mn * scale[i] > aabb.min[i]) {
+					mn -= 1.0f;
+				}
+				if (mx < QMAX && origin[i] + mx * scale[i] < aabb.max[i]) {
+					mx += 1.0f;
+				}
+				node.min[i] = (T)glm::clamp(mn, 0.0f, QMAX);
+				node.max[i] = (T)glm::clamp(mx, 0.0f, QMAX);
+			}
+		}
+	}
+
+private:
+	void SetFrame(const spp::Aabb &aabb);
+	float ComputeCost() const;
+	template <typename T> float ComputeCostImpl() const;
+
+	template <typename T, typename F, typename M>
+	bool RefitImpl(const uint32_t *changedItems, uint32_t changedCount,
+				   F &getAabb, M &getMask);
+	template <typename T> void BuildRefitLinks();
+	// Returns true when bounds or mask of node changed
+	template <typename T, typename F, typename M>
+	bool RefitLeaf(CompactBvhNode<T> &node, F &getAabb, M &getMask);
+	template <typename T> bool RefitInternal(uint32_t n);
+	// Padding of 16 bit node is not compared
+	template <typename T>
+	static inline bool SameBounds(const CompactBvhNode<T> &a,
+								  const CompactBvhNode<T> &b)
+	{
+		bool same = a.mask == b.mask;
+		for (int i = 0; i < 3; ++i) {
+			same &= a.min[i] == b.min[i] && a.max[i] == b.max[i];
+		}
+		return same;
+	}
+
+	template <typename T> inline const CompactBvhNode<T> *Nodes() const
+	{
+		return (const CompactBvhNode<T> *)data;
+	}
+
+	template <typename T> inline const uint32_t *Items() const
+	{
+		return (const uint32_t *)((const uint8_t *)data +
+								  nodesCount * sizeof(CompactBvhNode<T>));
+	}
+
+	template <typename T>
+	inline void DecodeNode(const CompactBvhNode<T> &node, glm::vec3 &min,
+						   glm::vec3 &max) const
+	{
+		for (int i = 0; i < 3; ++i) {
+			if constexpr (std::is_same_v<T, float>) {
+				min[i] = node.min[i];
+				max[i] = node.max[i];
+			} else {
+				min[i] = totalAabb.min[i] + float(node.min[i]) * scale[i];
+				max[i] = totalAabb.min[i] + float(node.max[i]) * scale[i];
+			}
+		}
+	}
+
+	template <typename T>
+	inline bool RayNode(const CompactBvhNode<T> &node,
+						const spp::RayInfo &ray, float cutFactor,
+						LayerMask mask, float margin, float &tNear) const
+	{
+		if ((node.mask & mask) == 0) {
+			return false;
+		}
+		glm::vec3 min, max;
+		DecodeNode(node, min, max);
+		min -= margin;
+		max += margin;
+		const glm::vec3 t0 = (min - ray.start) * ray.invDir;
+		const glm::vec3 t1 = (max - ray.start) * ray.invDir;
+		tNear = glm::maxcomp(glm::min(t0, t1));
+		const float tFar = glm::mincomp(glm::max(t0, t1));
+		return tNear <= tFar && tFar >= 0.0f && tNear <= cutFactor;
+	}
+
+	template <typename T, typename CB>
+	void IntersectRayImpl(const spp::RayInfo &ray, float &cutFactor,
+						  CB &callback, LayerMask mask, float margin) const;
+
+	template <typename T, typename CB>
+	void IntersectAabbImpl(const spp::Aabb &aabb, CB &callback,
+						   LayerMask mask) const;
+};
+
+template <typename CB>
+void CompactBvh::IntersectRay(const spp::RayInfo &ray, float &cutFactor,
+							  CB &&callback, LayerMask mask,
+							  float margin) const
+{
+	switch (format) {
+	case BvhNodeFormat::FLOAT:
+		IntersectRayImpl<float>(ray, cutFactor, callback, mask, margin);
+		break;
+	case BvhNodeFormat::QUANTIZED_16:
+		IntersectRayImpl<uint16_t>(ray, cutFactor, callback, mask, margin);
+		break;
+	case BvhNodeFormat::QUANTIZED_8:
+		IntersectRayImpl<uint8_t>(ray, cutFactor, callback, mask, margin);
+		break;
+	}
+}
+
+template <typename CB>
+void CompactBvh::IntersectAabb(const spp::Aabb &aabb, CB &&callback,
+							   LayerMask mask) const
+{
+	switch (format) {
+	case BvhNodeFormat::FLOAT:
+		IntersectAabbImpl<float>(aabb, callback, mask);
+		break;
+	case BvhNodeFormat::QUANTIZED_16:
+		IntersectAabbImpl<uint16_t>(aabb, callback, mask);
+		break;
+	case BvhNodeFormat::QUANTIZED_8:
+		IntersectAabbImpl<uint8_t>(aabb, callback, mask);
+		break;
+	}
+}
+
+template <typename T, typename CB>
+void CompactBvh::IntersectRayImpl(const spp::RayInfo &ray, float &cutFactor,
+								  CB &callback, LayerMask mask,
+								  float margin) const
+{
+	if (nodesCount == 0) {
+		return;
+	}
+	const CompactBvhNode<T> *nodes = Nodes<T>();
+	const uint32_t *items = Items<T>();
+
+	struct Entry {
+		uint32_t node;
+		float tNear;
+	} stack[MAX_DEPTH * 2];
+	int stackSize = 0;
+
+	float tNear;
+	if (RayNode(nodes[0], ray, cutFactor, mask, margin, tNear) == false) {
+		return;
+	}
+	stack[stackSize++] = {0, tNear};
+
+	while (stackSize) {
+		const Entry e = stack[--stackSize];
+		if (e.tNear > cutFactor) {
+			continue;
+		}
+		const CompactBvhNode<T> &node = nodes[e.node];
+		if (node.count) {
+			for (uint32_t i = 0; i < node.count; ++i) {
+				if (callback(items[node.index + i], cutFactor)) {
+					return;
+				}
+			}
+			continue;
+		}
+
+		const uint32_t a = e.node + 1;
+		const uint32_t b = node.index;
+		float ta, tb;
+		const bool ha = RayNode(nodes[a], ray, cutFactor, mask, margin, ta);
+		const bool hb = RayNode(nodes[b], ray, cutFactor, mask, margin, tb);
+		if (ha && hb) {
+			// push farther first, so that nearer is visited first
+			if (ta <= tb) {
+				stack[stackSize++] = {b, tb};
+				stack[stackSize++] = {a, ta};
+			} else {
+				stack[stackSize++] = {a, ta};
+				stack[stackSize++] = {b, tb};
+			}
+		} else if (ha) {
+			stack[stackSize++] = {a, ta};
+		} else if (hb) {
+			stack[stackSize++] = {b, tb};
+		}
+	}
+}
+
+template <typename T, typename CB>
+void CompactBvh::IntersectAabbImpl(const spp::Aabb &aabb, CB &callback,
+								   LayerMask mask) const
+{
+	if (nodesCount == 0) {
+		return;
+	}
+	const CompactBvhNode<T> *nodes = Nodes<T>();
+	const uint32_t *items = Items<T>();
+
+	// Convert query into node units once instead of decoding every node
+	glm::vec3 qmin = aabb.min, qmax = aabb.max;
+	if constexpr (!std::is_same_v<T, float>) {
+		qmin = (aabb.min - totalAabb.min) * invScale;
+		qmax = (aabb.max - totalAabb.min) * invScale;
+	}
+
+	uint32_t stack[MAX_DEPTH * 2];
+	int stackSize = 0;
+	stack[stackSize++] = 0;
+
+	while (stackSize) {
+		const CompactBvhNode<T> &node = nodes[stack[--stackSize]];
+		const uint32_t id = &node - nodes;
+		bool overlap = (node.mask & mask) != 0;
+		for (int i = 0; i < 3; ++i) {
+			overlap &= float(node.min[i]) <= qmax[i];
+			overlap &= float(node.max[i]) >= qmin[i];
+		}
+		if (overlap == false) {
+			continue;
+		}
+		if (node.count) {
+			for (uint32_t i = 0; i < node.count; ++i) {
+				if (callback(items[node.index + i])) {
+					return;
+				}
+			}
+		} else {
+			stack[stackSize++] = node.index;
+			stack[stackSize++] = id + 1;
+		}
+	}
+}
+
+template <typename T> float CompactBvh::ComputeCostImpl() const
+{
+	if (nodesCount == 0) {
+		return 0.0f;
+	}
+	const CompactBvhNode<T> *nodes = Nodes<T>();
+	float cost = 0.0f;
+	glm::vec3 min, max;
+	for (uint32_t i = 0; i < nodesCount; ++i) {
+		DecodeNode(nodes[i], min, max);
+		const glm::vec3 e = max - min;
+		const float area = e.x * e.y + e.y * e.z + e.z * e.x;
+		cost += area * (nodes[i].count ? nodes[i].count : 0.5f);
+	}
+	DecodeNode(nodes[0], min, max);
+	const glm::vec3 e = max - min;
+	const float area = e.x * e.y + e.y * e.z + e.z * e.x;
+	return cost / glm::max(area, 1e-20f);
+}
+
+template <typename F, typename M>
+bool CompactBvh::Refit(const uint32_t *changedItems, uint32_t changedCount,
+					   F &&getAabb, M &&getMask)
+{
+	switch (format) {
+	case BvhNodeFormat::FLOAT:
+		return RefitImpl<float>(changedItems, changedCount, getAabb, getMask);
+	case BvhNodeFormat::QUANTIZED_16:
+		return RefitImpl<uint16_t>(changedItems, changedCount, getAabb,
+								   getMask);
+	case BvhNodeFormat::QUANTIZED_8:
+		return RefitImpl<uint8_t>(changedItems, changedCount, getAabb,
+								  getMask);
+	}
+	return false;
+}
+
+template <typename T> void CompactBvh::BuildRefitLinks()
+{
+	const CompactBvhNode<T> *nodes = Nodes<T>();
+	const uint32_t *items = Items<T>();
+	refitParents.assign(nodesCount, 0);
+	refitLeaves.assign(itemsCount, 0);
+	for (uint32_t n = 0; n < nodesCount; ++n) {
+		const CompactBvhNode<T> &node = nodes[n];
+		if (node.count) {
+			for (uint32_t i = 0; i < node.count; ++i) {
+				refitLeaves[items[node.index + i]] = n;
+			}
+		} else {
+			refitParents[n + 1] = n;
+			refitParents[node.index] = n;
+		}
+	}
+}
+
+template <typename T, typename F, typename M>
+bool CompactBvh::RefitLeaf(CompactBvhNode<T> &node, F &getAabb, M &getMask)
+{
+	const uint32_t *items = Items<T>();
+	const CompactBvhNode<T> old = node;
+	spp::Aabb aabb = getAabb(items[node.index]);
+	for (uint32_t i = 1; i < node.count; ++i) {
+		aabb = aabb + getAabb(items[node.index + i]);
+	}
+	EncodeBounds(aabb, node);
+	if constexpr (!std::is_null_pointer_v<M>) {
+		node.mask = 0;
+		for (uint32_t i = 0; i < node.count; ++i) {
+			node.mask |= getMask(items[node.index + i]);
+		}
+	}
+	return SameBounds(old, node) == false;
+}
+
+template <typename T> bool CompactBvh::RefitInternal(uint32_t n)
+{
+	CompactBvhNode<T> *nodes = (CompactBvhNode<T> *)data;
+	CompactBvhNode<T> &node = nodes[n];
+	const CompactBvhNode<T> old = node;
+	const CompactBvhNode<T> &a = nodes[n + 1];
+	const CompactBvhNode<T> &b = nodes[node.index];
+	for (int i = 0; i < 3; ++i) {
+		node.min[i] = glm::min(a.min[i], b.min[i]);
+		node.max[i] = glm::max(a.max[i], b.max[i]);
+	}
+	node.mask = a.mask | b.mask;
+	return SameBounds(old, node) == false;
+}
+
+template <typename T, typename F, typename M>
+bool CompactBvh::RefitImpl(const uint32_t *changedItems,
+						   uint32_t changedCount, F &getAabb, M &getMask)
+{
+	if (nodesCount == 0 || changedCount == 0) {
+		return true;
+	}
+	CompactBvhNode<T> *nodes = (CompactBvhNode<T> *)data;
+
+	// Quantized nodes keep their frame unless changed items leave it,
+	// otherwise every node has to be recomputed in the new frame.
+	bool all = false;
+	if constexpr (!std::is_same_v<T, float>) {
+		spp::Aabb frame = totalAabb;
+		for (uint32_t i = 0; i < changedCount; ++i) {
+			frame = frame + getAabb(changedItems[i]);
+		}
+		if (frame.min != totalAabb.min || frame.max != totalAabb.max) {
+			const uint32_t *items = Items<T>();
+			spp::Aabb total = spp::AABB_INVALID;
+			for (uint32_t i = 0; i < itemsCount; ++i) {
+				total = total + getAabb(items[i]);
+			}
+			SetFrame(total);
+			all = true;
+		}
+	}
+
+	if (all) {
+		// Children are always after their parent
+		for (int64_t n = (int64_t)nodesCount - 1; n >= 0; --n) {
+			if (nodes[n].count) {
+				RefitLeaf(nodes[n], getAabb, getMask);
+			} else {
+				RefitInternal<T>(n);
+			}
+		}
+	} else {
+		if (refitLeaves.size() != itemsCount) {
+			BuildRefitLinks<T>();
+		}
+		// Ancestors of node that did not change stay valid
+		for (uint32_t i = 0; i < changedCount; ++i) {
+			assert(changedItems[i] < itemsCount);
+			uint32_t n = refitLeaves[changedItems[i]];
+			bool changed = RefitLeaf(nodes[n], getAabb, getMask);
+			while (changed && n != 0) {
+				n = refitParents[n];
+				changed = RefitInternal<T>(n);
+			}
+		}
+	}
+
+	if constexpr (std::is_same_v<T, float>) {
+		totalAabb = {{nodes[0].min[0], nodes[0].min[1], nodes[0].min[2]},
+					 {nodes[0].max[0], nodes[0].max[1], nodes[0].max[2]}};
+	}
+
+	// Cost is computed over all nodes, check is amortised over many refits
+	refitChangedSinceCheck += changedCount;
+	if (all == false && refitChangedSinceCheck * REFIT_COST_CHECK_DIVISOR <
+							itemsCount) {
+		return true;
+	}
+	refitChangedSinceCheck = 0;
+	return ComputeCostImpl<T>() <= buildCost * MAX_REFIT_COST_RATIO;
+}
+} // namespace Collision3D
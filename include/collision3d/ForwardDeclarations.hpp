@@ -12,16 +12,34 @@ struct VertBox;
 struct Cylinder;
 struct Sphere;
 struct RampRectangle;
+struct RampTriangle;
+struct VerticalTriangle;
+struct Triangle60;
+struct Triangle90_45;
+struct VerticalCone;
+struct VerticalCapsule;
 struct HeightMap;
 struct HeightMap_Header;
+struct TriangleMesh;
+struct ConvexHull;
 
 struct CompoundPrimitive;
+struct CompoundPrototype;
+struct CompoundInstance;
+struct SmallCompound;
+struct PrimitiveSpan;
+struct PackedCompound;
+struct CompactBvh;
 struct AnyShape;
 struct AnyPrimitive;
 
 struct Rotation;
 struct Transform;
 
+// Shape takes part in query only when its mask shares a bit with query mask
+using LayerMask = uint16_t;
+constexpr inline LayerMask LAYER_MASK_ALL = 0xFFFF;
+
 using HeightMap_Type = float;
 using HeightMap_MaterialType = uint8_t;
 } // namespace Collision3D
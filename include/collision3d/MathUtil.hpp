@@ -4,6 +4,9 @@
 
 #pragma once
 
+#include <cstdint>
+#include <cstring>
+
 #include "../../SpatialPartitioning/glm/glm/ext/vector_float3.hpp"
 #include "../../SpatialPartitioning/glm/glm/ext/vector_float2.hpp"
 #include "../../SpatialPartitioning/glm/glm/geometric.hpp"
@@ -27,3 +30,61 @@ inline float length2(const glm::vec2 &v) { return glm::dot(v, v); }
 inline float dot2(const glm::vec3 &v) { return glm::dot(v, v); }
 inline float dot2(const glm::vec2 &v) { return glm::dot(v, v); }
 } // namespace glm
+
+namespace Collision3D
+{
+// IEEE half precision conversion, rounds to nearest even
+inline uint16_t FloatToHalf(float value)
+{
+	uint32_t f;
+	memcpy(&f, &value, sizeof(f));
+	const uint32_t sign = f & 0x80000000u;
+	f ^= sign;
+
+	uint16_t h;
+	if (f >= (143u << 23)) {
+		// overflow to inf, keep nan
+		h = f > (255u << 23) ? 0x7E00 : 0x7C00;
+	} else if (f < (113u << 23)) {
+		// subnormal or zero, let float addition do the rounding
+		const uint32_t magicBits = 126u << 23;
+		float magic, v;
+		memcpy(&magic, &magicBits, sizeof(magic));
+		memcpy(&v, &f, sizeof(v));
+		v += magic;
+		memcpy(&f, &v, sizeof(f));
+		h = f - magicBits;
+	} else {
+		const uint32_t mantissaOdd = (f >> 13) & 1;
+		f += ((uint32_t)(15 - 127) << 23) + 0xFFF;
+		f += mantissaOdd;
+		h = f >> 13;
+	}
+	return h | (sign >> 16);
+}
+
+inline float HalfToFloat(uint16_t h)
+{
+	constexpr uint32_t shiftedExp = 0x7C00u << 13;
+	uint32_t f = (h & 0x7FFFu) << 13;
+	const uint32_t exp = f & shiftedExp;
+	f += (uint32_t)(127 - 15) << 23;
+	if (exp == shiftedExp) {
+		// inf or nan
+		f += (uint32_t)(128 - 16) << 23;
+	} else if (exp == 0) {
+		// subnormal, renormalise
+		const uint32_t magicBits = 113u << 23;
+		float magic, v;
+		memcpy(&magic, &magicBits, sizeof(magic));
+		f += 1u << 23;
+		memcpy(&v, &f, sizeof(v));
+		v -= magic;
+		memcpy(&f, &v, sizeof(f));
+	}
+	f |= (uint32_t)(h & 0x8000u) << 16;
+	float value;
+	memcpy(&value, &f, sizeof(value));
+	return value;
+}
+} // namespace Collision3D
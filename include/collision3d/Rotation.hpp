@@ -31,6 +31,15 @@ struct Rotation {
 		return {(uint8_t)v};
 	}
 
+	// Number of exact 90 degree turns, or -1 for other rotations
+	inline int QuarterTurns() const
+	{
+		if (value % 60) {
+			return -1;
+		}
+		return (value / 60) & 3;
+	}
+
 	inline float ToDegrees() const { return (360.0f / 240.0f) * value; }
 
 	inline float ToRadians() const
@@ -95,8 +104,8 @@ struct Rotation {
 		assert(r.value < 240);
 		const int a = l.value;
 		const int b = r.value;
-		const int sum = a - b + (a > b ? 0 : 240);
-		assert(sum >= 0 && sum <= 240);
+		const int sum = a - b + (a >= b ? 0 : 240);
+		assert(sum >= 0 && sum < 240);
 		return {(uint8_t)sum};
 	}
 
@@ -107,7 +116,7 @@ struct Rotation {
 		const int a = l.value;
 		const int b = r.value;
 		int sum = a + b;
-		sum -= sum > 240 ? 240 : 0;
+		sum -= sum >= 240 ? 240 : 0;
 		assert(sum >= 0 && sum < 240);
 		return {(uint8_t)sum};
 	}
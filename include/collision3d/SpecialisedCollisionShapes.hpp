@@ -13,6 +13,8 @@ using namespace spp;
 // One edge is horizontal
 // 60 degree at each vertex at XZ plane
 // Origin at center of horizontal edge
+// Infinitely thin, vertices: (-edge/2, 0, 0), (edge/2, 0, 0),
+// (0, vertexHeight, edge * sqrt(3)/2)
 struct Triangle60 {
 	float edge;
 	float vertexHeight;
@@ -24,6 +26,8 @@ struct Triangle60 {
 // 90 degree at XZ plane at vertex opposite origin
 // 45 degree at XZ plane on other tow vertices
 // Origin at center of horizontal edge
+// Infinitely thin, vertices: (-edge/2, 0, 0), (edge/2, 0, 0),
+// (0, vertexHeight, edge/2)
 struct Triangle90_45 {
 	float edge;
 	float vertexHeight;
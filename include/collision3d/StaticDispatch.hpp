@@ -0,0 +1,205 @@
+// This file is part of Collision3D.
+// Copyright (c) 2025 Marek Zalewski aka Drwalin
+// You should have received a copy of the MIT License along with this program.
+
+#pragma once
+
+#include <cassert>
+#include <concepts>
+#include <type_traits>
+#include <utility>
+
+#include "CollisionShapes_AnyOrCompound.hpp"
+
+namespace Collision3D
+{
+template <typename S>
+concept CollisionShape = requires(const S &shape, const Transform &trans,
+								  const RayInfo &ray, float &f, glm::vec3 &v,
+								  const Cylinder &cyl, const Sphere &sph,
+								  glm::vec3 pos, glm::vec3 *pv, bool *pb,
+								  const OverlapVolume &volume) {
+	{ shape.GetAabb(trans) } -> std::same_as<spp::Aabb>;
+	{ shape.RayTest(trans, ray, f, v) } -> std::same_as<bool>;
+	{ shape.RayTestLocal(ray, f, v) } -> std::same_as<bool>;
+	{ shape.OcclusionTest(trans, ray) } -> std::same_as<bool>;
+	{ shape.OverlapTest(trans, volume) } -> std::same_as<bool>;
+	{ shape.CylinderTestMovement(trans, f, cyl, ray, v) } -> std::same_as<bool>;
+	{ shape.SphereTestMovement(trans, f, sph, ray, v) } -> std::same_as<bool>;
+	{
+		shape.CylinderTestOnGround(trans, cyl, pos, f, pv, pb)
+	} -> std::same_as<bool>;
+};
+
+// Shapes made of primitives, they accept query layer mask
+template <typename S>
+concept CompoundCollisionShape =
+	CollisionShape<S> &&
+	requires(const S &shape, const Transform &trans, const RayInfo &ray,
+			 float &f, glm::vec3 &v, const Sphere &sph, LayerMask mask,
+			 const OverlapVolume &volume) {
+		{ shape.RayTest(trans, ray, f, v, mask) } -> std::same_as<bool>;
+		{ shape.OcclusionTest(trans, ray, mask) } -> std::same_as<bool>;
+		{ shape.OverlapTest(trans, volume, mask) } -> std::same_as<bool>;
+		{
+			shape.SphereTestMovement(trans, f, sph, ray, v, mask)
+		} -> std::same_as<bool>;
+	};
+
+template <typename T>
+concept AnyShapeOrPrimitive =
+	std::same_as<std::remove_cvref_t<T>, AnyShape> ||
+	std::same_as<std::remove_cvref_t<T>, AnyPrimitive>;
+
+#define CODE_VISIT(SHAPE, NAME, INDEX, DEREF) return visitor(any.NAME);
+
+// Calls visitor with active member of AnyShape or AnyPrimitive and returns
+// its result. any must not be INVALID. Transform of any (pos, rot) is not
+// applied.
+template <AnyShapeOrPrimitive Any, typename F>
+inline decltype(auto) Visit(Any &&any, F &&visitor)
+{
+	using Class = std::remove_cvref_t<Any>;
+	if constexpr (std::same_as<Class, AnyShape>) {
+		switch (any.type) {
+			EACH_SHAPE(Class, SWITCH_CASES, CODE_VISIT);
+		default:
+			break;
+		}
+	} else {
+		switch (any.type) {
+			EACH_PRIMITIVE(Class, SWITCH_CASES, CODE_VISIT);
+		default:
+			break;
+		}
+	}
+	assert(false && "Visit of INVALID shape");
+	std::unreachable();
+}
+
+#undef CODE_VISIT
+
+// Free function forms of shape methods for statically known shape types.
+// Called through concrete type they skip AnyShape switch. GetAabb, RayTest,
+// RayTestLocal and CylinderTestMovement of VertBox and Cylinder are defined
+// in CollisionShapes_PrimitivesInline.hpp and inline into caller loops, other
+// methods are compiled in Algorithms_*.cpp and need link time optimisation.
+
+template <CollisionShape S>
+inline spp::Aabb GetAabb(const S &shape, const Transform &trans)
+{
+	return shape.GetAabb(trans);
+}
+
+template <CollisionShape S>
+inline bool RayTest(const S &shape, const Transform &trans, const RayInfo &ray,
+					float &near, glm::vec3 &normal)
+{
+	return shape.RayTest(trans, ray, near, normal);
+}
+
+template <CompoundCollisionShape S>
+inline bool RayTest(const S &shape, const Transform &trans, const RayInfo &ray,
+					float &near, glm::vec3 &normal, LayerMask queryMask)
+{
+	return shape.RayTest(trans, ray, near, normal, queryMask);
+}
+
+template <CollisionShape S>
+inline bool RayTestLocal(const S &shape, const RayInfo &ray, float &near,
+						 glm::vec3 &normal)
+{
+	return shape.RayTestLocal(ray, near, normal);
+}
+
+template <CollisionShape S>
+inline bool OcclusionTest(const S &shape, const Transform &trans,
+						  const RayInfo &ray)
+{
+	return shape.OcclusionTest(trans, ray);
+}
+
+template <CompoundCollisionShape S>
+inline bool OcclusionTest(const S &shape, const Transform &trans,
+						  const RayInfo &ray, LayerMask queryMask)
+{
+	return shape.OcclusionTest(trans, ray, queryMask);
+}
+
+template <CollisionShape S>
+inline bool OverlapTest(const S &shape, const Transform &trans,
+						const OverlapVolume &volume)
+{
+	return shape.OverlapTest(trans, volume);
+}
+
+template <CompoundCollisionShape S>
+inline bool OverlapTest(const S &shape, const Transform &trans,
+						const OverlapVolume &volume, LayerMask queryMask)
+{
+	return shape.OverlapTest(trans, volume, queryMask);
+}
+
+template <CollisionShape S>
+inline bool CylinderTestMovement(const S &shape, const Transform &trans,
+								 float &validMovementFactor,
+								 const Cylinder &cyl,
+								 const RayInfo &movementRay,
+								 glm::vec3 &normal)
+{
+	return shape.CylinderTestMovement(trans, validMovementFactor, cyl,
+									  movementRay, normal);
+}
+
+template <CollisionShape S>
+inline bool SphereTestMovement(const S &shape, const Transform &trans,
+							   float &validMovementFactor, const Sphere &sph,
+							   const RayInfo &movementRay, glm::vec3 &normal)
+{
+	return shape.SphereTestMovement(trans, validMovementFactor, sph,
+									movementRay, normal);
+}
+
+template <CompoundCollisionShape S>
+inline bool SphereTestMovement(const S &shape, const Transform &trans,
+							   float &validMovementFactor, const Sphere &sph,
+							   const RayInfo &movementRay, glm::vec3 &normal,
+							   LayerMask queryMask)
+{
+	return shape.SphereTestMovement(trans, validMovementFactor, sph,
+									movementRay, normal, queryMask);
+}
+
+template <CollisionShape S>
+inline bool CylinderTestOnGround(const S &shape, const Transform &trans,
+								 const Cylinder &cyl, glm::vec3 pos,
+								 float &offsetHeight,
+								 glm::vec3 *onGroundNormal = nullptr,
+								 bool *isOnEdge = nullptr)
+{
+	return shape.CylinderTestOnGround(trans, cyl, pos, offsetHeight,
+									  onGroundNormal, isOnEdge);
+}
+
+// Nearest hit of ray among shapes of single type, shapes[i] is placed with
+// transforms[i]. Returns index of hit shape or -1.
+template <CollisionShape S>
+inline int32_t RayTestNearest(const S *shapes, const Transform *transforms,
+							  uint32_t count, const RayInfo &ray, float &near,
+							  glm::vec3 &normal)
+{
+	int32_t hit = -1;
+	float ne;
+	glm::vec3 no;
+	for (uint32_t i = 0; i < count; ++i) {
+		if (shapes[i].RayTest(transforms[i], ray, ne, no)) {
+			if (hit < 0 || ne < near) {
+				near = ne;
+				normal = no;
+				hit = i;
+			}
+		}
+	}
+	return hit;
+}
+} // namespace Collision3D
@@ -46,6 +46,11 @@ struct Transform {
 
 	inline RayInfo ToLocal(const RayInfo &ray) const
 	{
+		const int quarterTurns = rot.QuarterTurns();
+		if (quarterTurns >= 0) {
+			return ToLocalQuarterTurns(ray, quarterTurns);
+		}
+
 		RayInfo r2 = ray;
 		r2.start = rot.ToLocal(ray.start - pos);
 		r2.dir = rot.ToLocal(ray.dir);
@@ -64,5 +69,47 @@ struct Transform {
 		
 		return r2;
 	}
+
+private:
+	// Inverse rotation by multiple of 90 degrees only swaps and negates x and
+	// z, so invDir and signs are moved the same way instead of recomputed
+	inline RayInfo ToLocalQuarterTurns(const RayInfo &ray,
+									   int quarterTurns) const
+	{
+		RayInfo r2 = ray;
+		const glm::vec3 start = ray.start - pos;
+		// local = {sx * v[ix], v.y, sz * v[iz]}
+		int ix = 0, iz = 2;
+		float sx = 1.0f, sz = 1.0f;
+		switch (quarterTurns) {
+		case 0:
+			break;
+		case 1:
+			ix = 2;
+			iz = 0;
+			sx = -1.0f;
+			break;
+		case 2:
+			sx = -1.0f;
+			sz = -1.0f;
+			break;
+		case 3:
+			ix = 2;
+			iz = 0;
+			sz = -1.0f;
+			break;
+		}
+
+		r2.start = {sx * start[ix], start.y, sz * start[iz]};
+		r2.dir = {sx * ray.dir[ix], ray.dir.y, sz * ray.dir[iz]};
+		r2.dirNormalized = {sx * ray.dirNormalized[ix], ray.dirNormalized.y,
+							sz * ray.dirNormalized[iz]};
+		r2.invDir[0] = sx * ray.invDir[ix];
+		r2.invDir[2] = sz * ray.invDir[iz];
+		r2.signs[0] = sx < 0.0f ? 1 - ray.signs[ix] : ray.signs[ix];
+		r2.signs[2] = sz < 0.0f ? 1 - ray.signs[iz] : ray.signs[iz];
+		r2.end = r2.start + r2.dir;
+		return r2;
+	}
 };
 } // namespace Collision3D
@@ -38,6 +38,30 @@ bool AnyPrimitive::RayTestLocal(const RayInfo &ray, float &near,
 	return RayTest({}, ray, near, normal);
 }
 
+bool AnyPrimitive::OcclusionTest(const Transform &trans,
+								 const RayInfo &ray) const
+{
+	switch (type) {
+	case INVALID:
+		return false;
+		EACH_PRIMITIVE(AnyPrimitive, SWITCH_CASES, CODE_OCCLUSION_TEST);
+	default:
+		return false;
+	}
+}
+
+bool AnyPrimitive::OverlapTest(const Transform &trans,
+							   const OverlapVolume &volume) const
+{
+	switch (type) {
+	case INVALID:
+		return false;
+		EACH_PRIMITIVE(AnyPrimitive, SWITCH_CASES, CODE_OVERLAP_TEST);
+	default:
+		return false;
+	}
+}
+
 bool AnyPrimitive::CylinderTestOnGround(const Transform &trans,
 										const Cylinder &cyl, glm::vec3 pos,
 										float &offsetHeight,
@@ -68,4 +92,97 @@ bool AnyPrimitive::CylinderTestMovement(const Transform &trans,
 		return false;
 	}
 }
+
+bool AnyPrimitive::RayTest(const Transform &trans, const RayInfo &ray,
+						   float &near, glm::vec3 &normal,
+						   LayerMask queryMask) const
+{
+	if ((layerMask & queryMask) == 0) {
+		return false;
+	}
+	return RayTest(trans, ray, near, normal);
+}
+
+bool AnyPrimitive::RayTestLocal(const RayInfo &ray, float &near,
+								glm::vec3 &normal, LayerMask queryMask) const
+{
+	return RayTest({}, ray, near, normal, queryMask);
+}
+
+bool AnyPrimitive::OcclusionTest(const Transform &trans,
+								 const RayInfo &ray,
+								 LayerMask queryMask) const
+{
+	if ((layerMask & queryMask) == 0) {
+		return false;
+	}
+	return OcclusionTest(trans, ray);
+}
+
+bool AnyPrimitive::OverlapTest(const Transform &trans,
+							   const OverlapVolume &volume,
+							   LayerMask queryMask) const
+{
+	if ((layerMask & queryMask) == 0) {
+		return false;
+	}
+	return OverlapTest(trans, volume);
+}
+
+bool AnyPrimitive::CylinderTestOnGround(const Transform &trans,
+										const Cylinder &cyl, glm::vec3 pos,
+										float &offsetHeight,
+										glm::vec3 *onGroundNormal,
+										bool *isOnEdge,
+										LayerMask queryMask) const
+{
+	if ((layerMask & queryMask) == 0) {
+		return false;
+	}
+	return CylinderTestOnGround(trans, cyl, pos, offsetHeight, onGroundNormal,
+								isOnEdge);
+}
+
+bool AnyPrimitive::CylinderTestMovement(const Transform &trans,
+										float &validMovementFactor,
+										const Cylinder &cyl,
+										const RayInfo &movementRay,
+										glm::vec3 &normal,
+										LayerMask queryMask) const
+{
+	if ((layerMask & queryMask) == 0) {
+		return false;
+	}
+	return CylinderTestMovement(trans, validMovementFactor, cyl, movementRay,
+								normal);
+}
+
+bool AnyPrimitive::SphereTestMovement(const Transform &trans,
+									  float &validMovementFactor,
+									  const Sphere &sph,
+									  const RayInfo &movementRay,
+									  glm::vec3 &normal) const
+{
+	switch (type) {
+	case INVALID:
+		return false;
+		EACH_PRIMITIVE(AnyPrimitive, SWITCH_CASES, CODE_SPHERE_TEST_MOVEMENT);
+	default:
+		return false;
+	}
+}
+
+bool AnyPrimitive::SphereTestMovement(const Transform &trans,
+									  float &validMovementFactor,
+									  const Sphere &sph,
+									  const RayInfo &movementRay,
+									  glm::vec3 &normal,
+									  LayerMask queryMask) const
+{
+	if ((layerMask & queryMask) == 0) {
+		return false;
+	}
+	return SphereTestMovement(trans, validMovementFactor, sph, movementRay,
+							  normal);
+}
 } // namespace Collision3D
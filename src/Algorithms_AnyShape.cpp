@@ -2,6 +2,8 @@
 // Copyright (c) 2025 Marek Zalewski aka Drwalin
 // You should have received a copy of the MIT License along with this program.
 
+#include <new>
+
 #include "../include/collision3d/CollisionShapes_AnyOrCompound.hpp"
 
 namespace Collision3D
@@ -19,6 +21,7 @@ AnyShape::AnyShape(AnyShape &other)
 	type = other.type;
 	pos = other.pos;
 	rot = other.rot;
+	layerMask = other.layerMask;
 	switch (other.type) {
 	case INVALID:
 		break;
@@ -33,6 +36,7 @@ AnyShape::AnyShape(AnyShape &&other)
 	type = other.type;
 	pos = other.pos;
 	rot = other.rot;
+	layerMask = other.layerMask;
 	switch (other.type) {
 	case INVALID:
 		break;
@@ -48,6 +52,7 @@ AnyShape::AnyShape(const AnyShape &other)
 	type = other.type;
 	pos = other.pos;
 	rot = other.rot;
+	layerMask = other.layerMask;
 	switch (other.type) {
 	case INVALID:
 		break;
@@ -117,6 +122,29 @@ bool AnyShape::RayTestLocal(const RayInfo &ray, float &near,
 	return RayTest({}, ray, near, normal);
 }
 
+bool AnyShape::OcclusionTest(const Transform &trans, const RayInfo &ray) const
+{
+	switch (type) {
+	case INVALID:
+		return false;
+		EACH_SHAPE(AnyShape, SWITCH_CASES, CODE_OCCLUSION_TEST);
+	default:
+		return false;
+	}
+}
+
+bool AnyShape::OverlapTest(const Transform &trans,
+						   const OverlapVolume &volume) const
+{
+	switch (type) {
+	case INVALID:
+		return false;
+		EACH_SHAPE(AnyShape, SWITCH_CASES, CODE_OVERLAP_TEST);
+	default:
+		return false;
+	}
+}
+
 bool AnyShape::CylinderTestOnGround(const Transform &trans, const Cylinder &cyl,
 									glm::vec3 pos, float &offsetHeight,
 									glm::vec3 *onGroundNormal,
@@ -146,6 +174,186 @@ bool AnyShape::CylinderTestMovement(const Transform &trans,
 	}
 }
 
+bool AnyShape::RayTest(const Transform &trans, const RayInfo &ray, float &near,
+					   glm::vec3 &normal, LayerMask queryMask) const
+{
+	if ((layerMask & queryMask) == 0) {
+		return false;
+	}
+	switch (type) {
+	case INVALID:
+		return false;
+		EACH_COMPOUND_SHAPE(AnyShape, SWITCH_CASES, CODE_RAY_TEST_MASKED);
+	default:
+		return RayTest(trans, ray, near, normal);
+	}
+}
+
+bool AnyShape::RayTestLocal(const RayInfo &ray, float &near,
+							glm::vec3 &normal, LayerMask queryMask) const
+{
+	return RayTest({}, ray, near, normal, queryMask);
+}
+
+bool AnyShape::OcclusionTest(const Transform &trans, const RayInfo &ray,
+							 LayerMask queryMask) const
+{
+	if ((layerMask & queryMask) == 0) {
+		return false;
+	}
+	switch (type) {
+	case INVALID:
+		return false;
+		EACH_COMPOUND_SHAPE(AnyShape, SWITCH_CASES, CODE_OCCLUSION_TEST_MASKED);
+	default:
+		return OcclusionTest(trans, ray);
+	}
+}
+
+void AnyShape::RayTestAll(const Transform &trans, const RayInfo &ray,
+						  RayHitBuffer &hits, LayerMask queryMask) const
+{
+	if ((layerMask & queryMask) == 0) {
+		return;
+	}
+	switch (type) {
+	case INVALID:
+		return;
+		EACH_COMPOUND_SHAPE(AnyShape, SWITCH_CASES, CODE_RAY_TEST_ALL_MASKED);
+	case HEIGHT_MAP:
+		heightMap.RayTestAll(trans * Transform{pos, rot}, ray, hits);
+		return;
+	case TRIANGLE_MESH:
+		triangleMesh.RayTestAll(trans * Transform{pos, rot}, ray, hits);
+		return;
+	default: {
+		float near;
+		glm::vec3 normal;
+		if (RayTest(trans, ray, near, normal)) {
+			hits.Add({glm::max(near, 0.0f), normal, 0});
+		}
+		return;
+	}
+	}
+}
+
+bool AnyShape::OverlapTest(const Transform &trans, const OverlapVolume &volume,
+						   LayerMask queryMask) const
+{
+	if ((layerMask & queryMask) == 0) {
+		return false;
+	}
+	switch (type) {
+	case INVALID:
+		return false;
+		EACH_COMPOUND_SHAPE(AnyShape, SWITCH_CASES, CODE_OVERLAP_TEST_MASKED);
+	default:
+		return OverlapTest(trans, volume);
+	}
+}
+
+uint32_t AnyShape::OverlapAll(const Transform &trans,
+							  const OverlapVolume &volume, uint32_t *ids,
+							  uint32_t maxIds, LayerMask queryMask) const
+{
+	if ((layerMask & queryMask) == 0 || maxIds == 0) {
+		return 0;
+	}
+	switch (type) {
+	case INVALID:
+		return 0;
+		EACH_COMPOUND_SHAPE(AnyShape, SWITCH_CASES, CODE_OVERLAP_ALL_MASKED);
+	case HEIGHT_MAP:
+		return heightMap.OverlapAll(trans * Transform{pos, rot}, volume, ids,
+									maxIds);
+	case TRIANGLE_MESH:
+		return triangleMesh.OverlapAll(trans * Transform{pos, rot}, volume,
+									   ids, maxIds);
+	default:
+		if (OverlapTest(trans, volume)) {
+			ids[0] = 0;
+			return 1;
+		}
+		return 0;
+	}
+}
+
+bool AnyShape::CylinderTestOnGround(const Transform &trans, const Cylinder &cyl,
+									glm::vec3 pos, float &offsetHeight,
+									glm::vec3 *onGroundNormal, bool *isOnEdge,
+									LayerMask queryMask) const
+{
+	if ((layerMask & queryMask) == 0) {
+		return false;
+	}
+	switch (type) {
+	case INVALID:
+		return false;
+		EACH_COMPOUND_SHAPE(AnyShape, SWITCH_CASES,
+							CODE_CYLINDER_TEST_ON_GROUND_MASKED);
+	default:
+		return CylinderTestOnGround(trans, cyl, pos, offsetHeight,
+									onGroundNormal, isOnEdge);
+	}
+}
+
+bool AnyShape::CylinderTestMovement(const Transform &trans,
+									float &validMovementFactor,
+									const Cylinder &cyl,
+									const RayInfo &movementRay,
+									glm::vec3 &normal,
+									LayerMask queryMask) const
+{
+	if ((layerMask & queryMask) == 0) {
+		return false;
+	}
+	switch (type) {
+	case INVALID:
+		return false;
+		EACH_COMPOUND_SHAPE(AnyShape, SWITCH_CASES,
+							CODE_CYLINDER_TEST_MOVEMENT_MASKED);
+	default:
+		return CylinderTestMovement(trans, validMovementFactor, cyl,
+									movementRay, normal);
+	}
+}
+
+bool AnyShape::SphereTestMovement(const Transform &trans,
+								  float &validMovementFactor,
+								  const Sphere &sph,
+								  const RayInfo &movementRay,
+								  glm::vec3 &normal) const
+{
+	switch (type) {
+	case INVALID:
+		return false;
+		EACH_SHAPE(AnyShape, SWITCH_CASES, CODE_SPHERE_TEST_MOVEMENT);
+	default:
+		return false;
+	}
+}
+
+bool AnyShape::SphereTestMovement(const Transform &trans,
+								  float &validMovementFactor,
+								  const Sphere &sph,
+								  const RayInfo &movementRay,
+								  glm::vec3 &normal,
+								  LayerMask queryMask) const
+{
+	if ((layerMask & queryMask) == 0) {
+		return false;
+	}
+	switch (type) {
+	case INVALID:
+		return false;
+		EACH_COMPOUND_SHAPE(AnyShape, SWITCH_CASES,
+							CODE_SPHERE_TEST_MOVEMENT_MASKED);
+	default:
+		return SphereTestMovement(trans, validMovementFactor, sph,
+								  movementRay, normal);
+	}
+}
+
 #define CODE_COPY_FROM_ANY_PRIMITIVE(SHAPE, NAME, INDEX, DEREF)                \
 	type = INDEX;                                                              \
 	NAME = other.NAME;
@@ -153,6 +361,7 @@ AnyShape::AnyShape(AnyPrimitive &other)
 {
 	pos = other.pos;
 	rot = other.rot;
+	layerMask = other.layerMask;
 	switch (other.type) {
 	case AnyPrimitive::INVALID:
 		break;
@@ -168,6 +377,7 @@ AnyShape::AnyShape(const AnyPrimitive &other)
 {
 	pos = other.pos;
 	rot = other.rot;
+	layerMask = other.layerMask;
 	switch (other.type) {
 	case AnyPrimitive::INVALID:
 		break;
@@ -180,6 +390,7 @@ AnyShape::AnyShape(AnyPrimitive &&other)
 {
 	pos = other.pos;
 	rot = other.rot;
+	layerMask = other.layerMask;
 	switch (other.type) {
 	case AnyPrimitive::INVALID:
 		break;
@@ -196,6 +407,7 @@ AnyShape &AnyShape::operator=(AnyPrimitive &other)
 	this->~AnyShape();
 	pos = other.pos;
 	rot = other.rot;
+	layerMask = other.layerMask;
 	switch (other.type) {
 	case AnyPrimitive::INVALID:
 		break;
@@ -213,6 +425,7 @@ AnyShape &AnyShape::operator=(const AnyPrimitive &other)
 	this->~AnyShape();
 	pos = other.pos;
 	rot = other.rot;
+	layerMask = other.layerMask;
 	switch (other.type) {
 	case AnyPrimitive::INVALID:
 		break;
@@ -227,6 +440,7 @@ AnyShape &AnyShape::operator=(AnyPrimitive &&other)
 	this->~AnyShape();
 	pos = other.pos;
 	rot = other.rot;
+	layerMask = other.layerMask;
 	switch (other.type) {
 	case AnyPrimitive::INVALID:
 		break;
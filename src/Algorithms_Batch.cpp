@@ -0,0 +1,241 @@
+// This file is part of Collision3D.
+// Copyright (c) 2025 Marek Zalewski aka Drwalin
+// You should have received a copy of the MIT License along with this program.
+
+#include <algorithm>
+#include <vector>
+
+#include "../include/collision3d/BatchQueries.hpp"
+
+namespace Collision3D
+{
+using namespace spp;
+
+namespace
+{
+// Counting sort of query indices by shape type. Returns offsets of groups in
+// order, group of type t is [offsets[t], offsets[t+1]).
+template <typename GET_TYPE>
+void SortByType(uint32_t count, GET_TYPE getType,
+				std::vector<uint32_t> &order, uint32_t (&offsets)[257])
+{
+	for (uint32_t &o : offsets) {
+		o = 0;
+	}
+	for (uint32_t i = 0; i < count; ++i) {
+		++offsets[getType(i) + 1];
+	}
+	for (int t = 0; t < 256; ++t) {
+		offsets[t + 1] += offsets[t];
+	}
+	uint32_t next[256];
+	for (int t = 0; t < 256; ++t) {
+		next[t] = offsets[t];
+	}
+	order.resize(count);
+	for (uint32_t i = 0; i < count; ++i) {
+		order[next[getType(i)]++] = i;
+	}
+}
+
+// Shapes with primitives take query mask further, others are filtered only
+// by mask of AnyShape
+template <typename S>
+inline bool ShapeRayTest(const S &shape, const Transform &trans,
+						 const RayInfo &ray, float &near, glm::vec3 &normal,
+						 LayerMask queryMask)
+{
+	if constexpr (requires {
+					  shape.RayTest(trans, ray, near, normal, queryMask);
+				  }) {
+		return shape.RayTest(trans, ray, near, normal, queryMask);
+	} else {
+		return shape.RayTest(trans, ray, near, normal);
+	}
+}
+
+template <typename S>
+inline bool ShapeCylinderTestMovement(const S &shape, const Transform &trans,
+									  float &validMovementFactor,
+									  const Cylinder &cyl,
+									  const RayInfo &movementRay,
+									  glm::vec3 &normal, LayerMask queryMask)
+{
+	if constexpr (requires {
+					  shape.CylinderTestMovement(trans, validMovementFactor,
+												 cyl, movementRay, normal,
+												 queryMask);
+				  }) {
+		return shape.CylinderTestMovement(trans, validMovementFactor, cyl,
+										  movementRay, normal, queryMask);
+	} else {
+		return shape.CylinderTestMovement(trans, validMovementFactor, cyl,
+										  movementRay, normal);
+	}
+}
+
+// Get is a stateless accessor of the union member, so the whole loop is
+// compiled for single shape type
+template <typename GET>
+void RayTestGroup(const RayQuery *queries, const uint32_t *order,
+				  uint32_t count, RayQueryResult *results, GET get)
+{
+	for (uint32_t i = 0; i < count; ++i) {
+		const RayQuery &q = queries[order[i]];
+		RayQueryResult &r = results[order[i]];
+		const AnyShape &s = *q.shape;
+		r.hit = false;
+		if ((s.layerMask & q.queryMask) == 0) {
+			continue;
+		}
+		// same as AnyShape::RayTest
+		if (ShapeRayTest(get(s), q.trans * Transform{s.pos, s.rot}, q.ray,
+						 r.near, r.normal, q.queryMask)) {
+			r.normal = (q.trans.rot + s.rot) * r.normal;
+			r.hit = true;
+		}
+	}
+}
+
+template <typename GET>
+void CylinderTestMovementGroup(const CylinderMovementQuery *queries,
+							   const uint32_t *order, uint32_t count,
+							   CylinderMovementResult *results, GET get)
+{
+	for (uint32_t i = 0; i < count; ++i) {
+		const CylinderMovementQuery &q = queries[order[i]];
+		CylinderMovementResult &r = results[order[i]];
+		const AnyShape &s = *q.shape;
+		r.hit = false;
+		if ((s.layerMask & q.queryMask) == 0) {
+			continue;
+		}
+		r.hit = ShapeCylinderTestMovement(
+			get(s), q.trans * Transform{s.pos, s.rot}, r.validMovementFactor,
+			q.cyl, q.movementRay, r.normal, q.queryMask);
+	}
+}
+
+// Primitives with SoA kernel are copied in chunks to contiguous arrays
+template <typename S, typename GET>
+void GetAabbsGroup(const AnyShape *shapes, const Transform *transforms,
+				   const uint32_t *order, uint32_t count, AabbSoA out, GET get)
+{
+	if constexpr (requires(const S *p, AabbSoA soa) {
+					  GetAabbs(p, transforms, soa, count);
+				  }) {
+		constexpr uint32_t CHUNK = 64;
+		S prims[CHUNK];
+		Transform trans[CHUNK];
+		float tmp[6][CHUNK];
+		const AabbSoA chunk{{tmp[0], tmp[1], tmp[2]}, {tmp[3], tmp[4], tmp[5]}};
+		for (uint32_t begin = 0; begin < count; begin += CHUNK) {
+			const uint32_t n = std::min(CHUNK, count - begin);
+			for (uint32_t i = 0; i < n; ++i) {
+				const AnyShape &s = shapes[order[begin + i]];
+				prims[i] = get(s);
+				trans[i] = transforms[order[begin + i]] *
+						   Transform{s.pos, s.rot};
+			}
+			GetAabbs(prims, trans, chunk, n);
+			for (uint32_t i = 0; i < n; ++i) {
+				out.Set(order[begin + i], chunk.Get(i));
+			}
+		}
+	} else {
+		for (uint32_t i = 0; i < count; ++i) {
+			const uint32_t id = order[i];
+			out.Set(id, shapes[id].GetAabb(transforms[id]));
+		}
+	}
+}
+} // namespace
+
+#define CODE_BATCH_RAY_TEST(SHAPE, NAME, INDEX, DEREF)                         \
+	RayTestGroup(queries, order.data() + begin, end - begin, results,          \
+				 [](const AnyShape &s) -> const SHAPE & { return s.NAME; });
+
+void BatchRayTest(const RayQuery *queries, uint32_t count,
+				  RayQueryResult *results)
+{
+	thread_local std::vector<uint32_t> order;
+	uint32_t offsets[257];
+	SortByType(
+		count, [queries](uint32_t i) { return queries[i].shape->type; },
+		order, offsets);
+
+	for (int t = 0; t < 256; ++t) {
+		const uint32_t begin = offsets[t], end = offsets[t + 1];
+		if (begin == end) {
+			continue;
+		}
+		switch ((AnyShape::Type)t) {
+			EACH_SHAPE(AnyShape, SWITCH_CASES, CODE_BATCH_RAY_TEST);
+		default:
+			for (uint32_t i = begin; i < end; ++i) {
+				results[order[i]].hit = false;
+			}
+		}
+	}
+}
+
+#define CODE_BATCH_GET_AABBS(SHAPE, NAME, INDEX, DEREF)                        \
+	GetAabbsGroup<SHAPE>(                                                      \
+		shapes, transforms, order.data() + begin, end - begin, out,            \
+		[](const AnyShape &s) -> const SHAPE & { return s.NAME; });
+
+void GetAabbs(const AnyShape *shapes, const Transform *transforms,
+			  AabbSoA out, uint32_t count)
+{
+	thread_local std::vector<uint32_t> order;
+	uint32_t offsets[257];
+	SortByType(
+		count, [shapes](uint32_t i) { return shapes[i].type; }, order,
+		offsets);
+
+	for (int t = 0; t < 256; ++t) {
+		const uint32_t begin = offsets[t], end = offsets[t + 1];
+		if (begin == end) {
+			continue;
+		}
+		switch ((AnyShape::Type)t) {
+			EACH_SHAPE(AnyShape, SWITCH_CASES, CODE_BATCH_GET_AABBS);
+		default:
+			for (uint32_t i = begin; i < end; ++i) {
+				out.Set(order[i], spp::AABB_INVALID);
+			}
+		}
+	}
+}
+
+#define CODE_BATCH_CYLINDER_TEST_MOVEMENT(SHAPE, NAME, INDEX, DEREF)           \
+	CylinderTestMovementGroup(                                                 \
+		queries, order.data() + begin, end - begin, results,                   \
+		[](const AnyShape &s) -> const SHAPE & { return s.NAME; });
+
+void BatchCylinderTestMovement(const CylinderMovementQuery *queries,
+							   uint32_t count,
+							   CylinderMovementResult *results)
+{
+	thread_local std::vector<uint32_t> order;
+	uint32_t offsets[257];
+	SortByType(
+		count, [queries](uint32_t i) { return queries[i].shape->type; },
+		order, offsets);
+
+	for (int t = 0; t < 256; ++t) {
+		const uint32_t begin = offsets[t], end = offsets[t + 1];
+		if (begin == end) {
+			continue;
+		}
+		switch ((AnyShape::Type)t) {
+			EACH_SHAPE(AnyShape, SWITCH_CASES,
+					   CODE_BATCH_CYLINDER_TEST_MOVEMENT);
+		default:
+			for (uint32_t i = begin; i < end; ++i) {
+				results[order[i]].hit = false;
+			}
+		}
+	}
+}
+} // namespace Collision3D
@@ -0,0 +1,214 @@
+// This file is part of Collision3D.
+// Copyright (c) 2025 Marek Zalewski aka Drwalin
+// You should have received a copy of the MIT License along with this program.
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#endif
+
+#include "BatchKernels.hpp"
+
+namespace Collision3D
+{
+using namespace spp;
+
+namespace
+{
+const BatchKernelTable *KernelsOf(SimdIsa isa)
+{
+	switch (isa) {
+	case SimdIsa::SSE4_2:
+		return &BatchKernels_Sse42::table;
+	case SimdIsa::AVX2:
+		return &BatchKernels_Avx2::table;
+	case SimdIsa::AVX512:
+		return &BatchKernels_Avx512::table;
+	default:
+		return nullptr;
+	}
+}
+
+// Highest variant that cpu supports and that was compiled with its flags
+SimdIsa DetectSimdIsa()
+{
+	SimdIsa isa = SimdIsa::SCALAR;
+#if (defined(__GNUC__) || defined(__clang__)) &&                              \
+	(defined(__x86_64__) || defined(__i386__))
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512f") &&
+		__builtin_cpu_supports("avx512vl") &&
+		__builtin_cpu_supports("avx512bw") &&
+		__builtin_cpu_supports("avx512dq")) {
+		isa = SimdIsa::AVX512;
+	} else if (__builtin_cpu_supports("avx2") &&
+			   __builtin_cpu_supports("fma")) {
+		isa = SimdIsa::AVX2;
+	} else if (__builtin_cpu_supports("sse4.2")) {
+		isa = SimdIsa::SSE4_2;
+	}
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+	int r1[4], r7[4] = {0, 0, 0, 0};
+	__cpuid(r1, 0);
+	const int maxLeaf = r1[0];
+	__cpuid(r1, 1);
+	if (maxLeaf >= 7) {
+		__cpuidex(r7, 7, 0);
+	}
+	const bool sse42 = r1[2] & (1 << 20);
+	const bool fma = r1[2] & (1 << 12);
+	// Os has to save ymm and zmm registers, not only cpu support them
+	const bool osxsave = r1[2] & (1 << 27);
+	const uint64_t xcr0 = osxsave ? _xgetbv(0) : 0;
+	const bool ymm = (xcr0 & 0x6) == 0x6;
+	const bool zmm = (xcr0 & 0xE6) == 0xE6;
+	const bool avx2 = r7[1] & (1 << 5);
+	const bool avx512 = (r7[1] & (1 << 16)) && (r7[1] & (1 << 17)) &&
+						(r7[1] & (1 << 30)) && (r7[1] & (1u << 31));
+	if (zmm && avx512) {
+		isa = SimdIsa::AVX512;
+	} else if (ymm && avx2 && fma) {
+		isa = SimdIsa::AVX2;
+	} else if (sse42) {
+		isa = SimdIsa::SSE4_2;
+	}
+#endif
+	while (isa != SimdIsa::SCALAR && KernelsOf(isa)->rotatePoints == nullptr) {
+		isa = (SimdIsa)((uint8_t)isa - 1);
+	}
+	return isa;
+}
+
+// COLLISION3D_SIMD=scalar|sse4.2|avx2|avx512 lowers detected variant
+SimdIsa InitialSimdIsa()
+{
+	const SimdIsa supported = DetectSimdIsa();
+	const char *env = std::getenv("COLLISION3D_SIMD");
+	if (env == nullptr) {
+		return supported;
+	}
+	SimdIsa requested = supported;
+	if (strcmp(env, "scalar") == 0) {
+		requested = SimdIsa::SCALAR;
+	} else if (strcmp(env, "sse4.2") == 0) {
+		requested = SimdIsa::SSE4_2;
+	} else if (strcmp(env, "avx2") == 0) {
+		requested = SimdIsa::AVX2;
+	} else if (strcmp(env, "avx512") == 0) {
+		requested = SimdIsa::AVX512;
+	}
+	return requested < supported ? requested : supported;
+}
+
+std::atomic<SimdIsa> &ActiveSimdIsa()
+{
+	static std::atomic<SimdIsa> isa = InitialSimdIsa();
+	return isa;
+}
+} // namespace
+
+SimdIsa GetSimdIsa() { return ActiveSimdIsa().load(std::memory_order_relaxed); }
+
+SimdIsa SetSimdIsa(SimdIsa isa)
+{
+	static const SimdIsa supported = DetectSimdIsa();
+	if (isa > supported) {
+		isa = supported;
+	}
+	ActiveSimdIsa().store(isa, std::memory_order_relaxed);
+	return isa;
+}
+
+const BatchKernelTable *GetBatchKernels() { return KernelsOf(GetSimdIsa()); }
+
+void RotatePoints(const Rotation *rotations, ConstVec3SoA in, Vec3SoA out,
+				  uint32_t count)
+{
+	const BatchKernelTable *kernels = GetBatchKernels();
+	uint32_t i = kernels ? kernels->rotatePoints(rotations, in, out, count) : 0;
+	for (; i < count; ++i) {
+		const glm::vec3 v = rotations[i] * glm::vec3{in.x[i], in.y[i], in.z[i]};
+		out.x[i] = v.x;
+		out.y[i] = v.y;
+		out.z[i] = v.z;
+	}
+}
+
+void ToLocalPoints(const Transform *transforms, ConstVec3SoA in, Vec3SoA out,
+				   uint32_t count)
+{
+	const BatchKernelTable *kernels = GetBatchKernels();
+	uint32_t i =
+		kernels ? kernels->toLocalPoints(transforms, in, out, count) : 0;
+	for (; i < count; ++i) {
+		const glm::vec3 v =
+			transforms[i].ToLocal(glm::vec3{in.x[i], in.y[i], in.z[i]});
+		out.x[i] = v.x;
+		out.y[i] = v.y;
+		out.z[i] = v.z;
+	}
+}
+
+void TransformRays(const Transform *transforms, const RayInfo *rays,
+				   RayInfo *out, uint32_t count)
+{
+	const BatchKernelTable *kernels = GetBatchKernels();
+	const uint32_t done =
+		kernels ? kernels->transformRays(transforms, rays, out, count) : 0;
+	// Kernels leave quarter turns untouched, to keep exact axis swaps
+	for (uint32_t i = 0; i < done; ++i) {
+		if (transforms[i].rot.QuarterTurns() >= 0) {
+			out[i] = transforms[i].ToLocal(rays[i]);
+		}
+	}
+	for (uint32_t i = done; i < count; ++i) {
+		out[i] = transforms[i].ToLocal(rays[i]);
+	}
+}
+
+void GetAabbs(const Cylinder *shapes, const Transform *transforms,
+			  AabbSoA out, uint32_t count)
+{
+	const BatchKernelTable *kernels = GetBatchKernels();
+	uint32_t i =
+		kernels ? kernels->cylinderAabbs(shapes, transforms, out, count) : 0;
+	for (; i < count; ++i) {
+		out.Set(i, shapes[i].GetAabb(transforms[i]));
+	}
+}
+
+void GetAabbs(const VertBox *shapes, const Transform *transforms,
+			  AabbSoA out, uint32_t count)
+{
+	const BatchKernelTable *kernels = GetBatchKernels();
+	uint32_t i =
+		kernels ? kernels->vertBoxAabbs(shapes, transforms, out, count) : 0;
+	for (; i < count; ++i) {
+		out.Set(i, shapes[i].GetAabb(transforms[i]));
+	}
+}
+
+uint32_t RayTestAabbs(const RayInfo &ray, float cutFactor, AabbSoA aabbs,
+					  uint32_t count, uint32_t *hitIds)
+{
+	const BatchKernelTable *kernels = GetBatchKernels();
+	uint32_t hits = 0;
+	uint32_t i =
+		kernels ? kernels->rayAabbs(ray, cutFactor, aabbs, count, hitIds, hits)
+				: 0;
+	for (; i < count; ++i) {
+		const spp::Aabb aabb = aabbs.Get(i);
+		const glm::vec3 t0 = (aabb.min - ray.start) * ray.invDir;
+		const glm::vec3 t1 = (aabb.max - ray.start) * ray.invDir;
+		const float tNear = glm::maxcomp(glm::min(t0, t1));
+		const float tFar = glm::mincomp(glm::max(t0, t1));
+		if (tNear <= tFar && tFar >= 0.0f && tNear <= cutFactor) {
+			hitIds[hits++] = i;
+		}
+	}
+	return hits;
+}
+} // namespace Collision3D
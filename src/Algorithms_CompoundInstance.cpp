@@ -0,0 +1,250 @@
+// This file is part of Collision3D.
+// Copyright (c) 2025 Marek Zalewski aka Drwalin
+// You should have received a copy of the MIT License along with this program.
+
+#include "../include/collision3d/CollisionShapes_AnyOrCompound.hpp"
+
+namespace Collision3D
+{
+using namespace spp;
+
+CompoundPrototype::CompoundPrototype(CompoundPrimitive &&compound)
+	: compound(std::move(compound))
+{
+}
+
+CompoundInstance CompoundPrototype::Create(CompoundPrimitive &&compound)
+{
+	return CompoundInstance(new CompoundPrototype(std::move(compound)));
+}
+
+void CompoundPrototype::Acquire() const
+{
+	references.fetch_add(1, std::memory_order_relaxed);
+}
+
+void CompoundPrototype::Release() const
+{
+	if (references.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+		delete this;
+	}
+}
+
+CompoundInstance::~CompoundInstance()
+{
+	if (prototype) {
+		prototype->Release();
+		prototype = nullptr;
+	}
+}
+
+CompoundInstance::CompoundInstance(const CompoundPrototype *prototype)
+	: prototype(prototype)
+{
+	if (prototype) {
+		prototype->Acquire();
+	}
+}
+
+CompoundInstance::CompoundInstance(CompoundPrimitive &&compound)
+	: CompoundInstance(CompoundPrototype::Create(std::move(compound)))
+{
+}
+
+CompoundInstance::CompoundInstance(CompoundInstance &other)
+	: CompoundInstance((const CompoundInstance &)other)
+{
+}
+
+CompoundInstance::CompoundInstance(CompoundInstance &&other)
+	: prototype(other.prototype)
+{
+	other.prototype = nullptr;
+}
+
+CompoundInstance::CompoundInstance(const CompoundInstance &other)
+	: prototype(other.prototype)
+{
+	if (prototype) {
+		prototype->Acquire();
+	}
+}
+
+CompoundInstance &CompoundInstance::operator=(CompoundInstance &other)
+{
+	return *this = (const CompoundInstance &)other;
+}
+
+CompoundInstance &CompoundInstance::operator=(CompoundInstance &&other)
+{
+	if (this != &other) {
+		this->~CompoundInstance();
+		prototype = other.prototype;
+		other.prototype = nullptr;
+	}
+	return *this;
+}
+
+CompoundInstance &CompoundInstance::operator=(const CompoundInstance &other)
+{
+	if (other.prototype) {
+		other.prototype->Acquire();
+	}
+	this->~CompoundInstance();
+	prototype = other.prototype;
+	return *this;
+}
+
+spp::Aabb CompoundInstance::GetAabb(const Transform &trans) const
+{
+	assert(prototype);
+	return prototype->compound.GetAabb(trans);
+}
+
+bool CompoundInstance::RayTest(const Transform &trans, const RayInfo &ray,
+							   float &near, glm::vec3 &normal) const
+{
+	assert(prototype);
+	return prototype->compound.RayTest(trans, ray, near, normal);
+}
+
+bool CompoundInstance::RayTestLocal(const RayInfo &ray, float &near,
+									glm::vec3 &normal) const
+{
+	assert(prototype);
+	return prototype->compound.RayTestLocal(ray, near, normal);
+}
+
+bool CompoundInstance::OcclusionTest(const Transform &trans,
+									 const RayInfo &ray) const
+{
+	assert(prototype);
+	return prototype->compound.OcclusionTest(trans, ray);
+}
+
+bool CompoundInstance::OverlapTest(const Transform &trans,
+								   const OverlapVolume &volume) const
+{
+	assert(prototype);
+	return prototype->compound.OverlapTest(trans, volume);
+}
+
+bool CompoundInstance::CylinderTestOnGround(const Transform &trans,
+											const Cylinder &cyl, glm::vec3 pos,
+											float &offsetHeight,
+											glm::vec3 *onGroundNormal,
+											bool *isOnEdge) const
+{
+	assert(prototype);
+	return prototype->compound.CylinderTestOnGround(
+		trans, cyl, pos, offsetHeight, onGroundNormal, isOnEdge);
+}
+
+bool CompoundInstance::CylinderTestMovement(const Transform &trans,
+											float &validMovementFactor,
+											const Cylinder &cyl,
+											const RayInfo &movementRay,
+											glm::vec3 &normal) const
+{
+	assert(prototype);
+	return prototype->compound.CylinderTestMovement(
+		trans, validMovementFactor, cyl, movementRay, normal);
+}
+
+bool CompoundInstance::RayTest(const Transform &trans, const RayInfo &ray,
+							   float &near, glm::vec3 &normal,
+							   LayerMask queryMask) const
+{
+	assert(prototype);
+	return prototype->compound.RayTest(trans, ray, near, normal, queryMask);
+}
+
+bool CompoundInstance::RayTestLocal(const RayInfo &ray, float &near,
+									glm::vec3 &normal,
+									LayerMask queryMask) const
+{
+	assert(prototype);
+	return prototype->compound.RayTestLocal(ray, near, normal, queryMask);
+}
+
+bool CompoundInstance::OcclusionTest(const Transform &trans,
+									 const RayInfo &ray,
+									 LayerMask queryMask) const
+{
+	assert(prototype);
+	return prototype->compound.OcclusionTest(trans, ray, queryMask);
+}
+
+void CompoundInstance::RayTestAll(const Transform &trans, const RayInfo &ray,
+								  RayHitBuffer &hits,
+								  LayerMask queryMask) const
+{
+	assert(prototype);
+	prototype->compound.RayTestAll(trans, ray, hits, queryMask);
+}
+
+bool CompoundInstance::OverlapTest(const Transform &trans,
+								   const OverlapVolume &volume,
+								   LayerMask queryMask) const
+{
+	assert(prototype);
+	return prototype->compound.OverlapTest(trans, volume, queryMask);
+}
+
+uint32_t CompoundInstance::OverlapAll(const Transform &trans,
+									  const OverlapVolume &volume,
+									  uint32_t *ids, uint32_t maxIds,
+									  LayerMask queryMask) const
+{
+	assert(prototype);
+	return prototype->compound.OverlapAll(trans, volume, ids, maxIds,
+										  queryMask);
+}
+
+bool CompoundInstance::CylinderTestOnGround(const Transform &trans,
+											const Cylinder &cyl, glm::vec3 pos,
+											float &offsetHeight,
+											glm::vec3 *onGroundNormal,
+											bool *isOnEdge,
+											LayerMask queryMask) const
+{
+	assert(prototype);
+	return prototype->compound.CylinderTestOnGround(
+		trans, cyl, pos, offsetHeight, onGroundNormal, isOnEdge, queryMask);
+}
+
+bool CompoundInstance::CylinderTestMovement(const Transform &trans,
+											float &validMovementFactor,
+											const Cylinder &cyl,
+											const RayInfo &movementRay,
+											glm::vec3 &normal,
+											LayerMask queryMask) const
+{
+	assert(prototype);
+	return prototype->compound.CylinderTestMovement(
+		trans, validMovementFactor, cyl, movementRay, normal, queryMask);
+}
+
+bool CompoundInstance::SphereTestMovement(const Transform &trans,
+										  float &validMovementFactor,
+										  const Sphere &sph,
+										  const RayInfo &movementRay,
+										  glm::vec3 &normal) const
+{
+	assert(prototype);
+	return prototype->compound.SphereTestMovement(
+		trans, validMovementFactor, sph, movementRay, normal);
+}
+
+bool CompoundInstance::SphereTestMovement(const Transform &trans,
+										  float &validMovementFactor,
+										  const Sphere &sph,
+										  const RayInfo &movementRay,
+										  glm::vec3 &normal,
+										  LayerMask queryMask) const
+{
+	assert(prototype);
+	return prototype->compound.SphereTestMovement(
+		trans, validMovementFactor, sph, movementRay, normal, queryMask);
+}
+} // namespace Collision3D
@@ -2,6 +2,8 @@
 // Copyright (c) 2025 Marek Zalewski aka Drwalin
 // You should have received a copy of the MIT License along with this program.
 
+#include <vector>
+
 #include "../SpatialPartitioning/include/spatial_partitioning/BvhMedianSplitHeap.hpp"
 
 #include "../include/collision3d/CollisionShapes_AnyOrCompound.hpp"
@@ -11,51 +13,266 @@ namespace Collision3D
 using _ =
 	spp::BvhMedianSplitHeap<spp::Aabb, uint32_t, uint32_t, 0, 1, void>;
 
-CompoundPrimitive::~CompoundPrimitive()
+CompoundPrimitive::~CompoundPrimitive() { ClearBvh(); }
+
+CompoundPrimitive::CompoundPrimitive(CompoundPrimitive &other)
+	: CompoundPrimitive((const CompoundPrimitive &)other)
 {
-	if (bvh) {
-		delete bvh;
-		bvh = nullptr;
+}
+
+CompoundPrimitive::CompoundPrimitive(CompoundPrimitive &&other)
+	: primitives(std::move(other.primitives)), bvh(other.bvh),
+	  compactBvh(other.compactBvh), localAabbs(std::move(other.localAabbs))
+{
+	other.bvh = nullptr;
+	other.compactBvh = nullptr;
+}
+
+CompoundPrimitive::CompoundPrimitive(const CompoundPrimitive &other)
+	: primitives(other.primitives), localAabbs(other.localAabbs)
+{
+	CopyBvhFrom(other);
+}
+
+CompoundPrimitive &CompoundPrimitive::operator=(CompoundPrimitive &other)
+{
+	return *this = (const CompoundPrimitive &)other;
+}
+
+CompoundPrimitive &CompoundPrimitive::operator=(CompoundPrimitive &&other)
+{
+	if (this == &other) {
+		return *this;
 	}
+	ClearBvh();
+	primitives = std::move(other.primitives);
+	bvh = other.bvh;
+	compactBvh = other.compactBvh;
+	localAabbs = std::move(other.localAabbs);
+	other.bvh = nullptr;
+	other.compactBvh = nullptr;
+	return *this;
 }
 
-void CompoundPrimitive::Optimise()
+CompoundPrimitive &CompoundPrimitive::operator=(const CompoundPrimitive &other)
+{
+	if (this == &other) {
+		return *this;
+	}
+	ClearBvh();
+	primitives = other.primitives;
+	localAabbs = other.localAabbs;
+	CopyBvhFrom(other);
+	return *this;
+}
+
+void CompoundPrimitive::ClearBvh()
 {
 	if (bvh) {
 		delete bvh;
 		bvh = nullptr;
 	}
+	if (compactBvh) {
+		delete compactBvh;
+		compactBvh = nullptr;
+	}
+}
+
+void CompoundPrimitive::CopyBvhFrom(const CompoundPrimitive &other)
+{
+	if (other.compactBvh) {
+		compactBvh = new CompactBvh(*other.compactBvh);
+	} else if (other.bvh) {
+		// spp bvh is not copyable, build new one
+		Optimise();
+	}
+}
+
+void CompoundPrimitive::CacheLocalAabbs()
+{
+	localAabbs.resize(primitives.size);
+	for (uint32_t i = 0; i < primitives.size; ++i) {
+		localAabbs[i] = primitives[i].GetAabb({});
+	}
+}
+
+void CompoundPrimitive::Optimise()
+{
+	ClearBvh();
 	if (primitives.size < 12) {
+		CacheLocalAabbs();
 		return;
 	}
+	localAabbs.clear();
 	bvh = new BvhType(primitives.size + 1);
 	bvh->StartFastAdding();
 	for (int i = 0; i < primitives.size; ++i) {
 		const auto &s = primitives[i];
 		Aabb aabb = s.GetAabb({});
-		bvh->Add(i + 1, aabb, 1);
+		bvh->Add(i + 1, aabb, s.layerMask);
 	}
 	bvh->StopFastAdding();
 	bvh->Rebuild();
 }
 
+void CompoundPrimitive::Optimise(BvhNodeFormat format, BvhBuilder builder)
+{
+	if (bvh) {
+		delete bvh;
+		bvh = nullptr;
+	}
+	if (primitives.size < 12) {
+		if (compactBvh) {
+			delete compactBvh;
+			compactBvh = nullptr;
+		}
+		CacheLocalAabbs();
+		return;
+	}
+	localAabbs.clear();
+	std::vector<spp::Aabb> aabbs(primitives.size);
+	std::vector<LayerMask> masks(primitives.size);
+	for (uint32_t i = 0; i < primitives.size; ++i) {
+		aabbs[i] = primitives[i].GetAabb({});
+		masks[i] = primitives[i].layerMask;
+	}
+	if (compactBvh == nullptr) {
+		compactBvh = new CompactBvh();
+	}
+	compactBvh->Build(aabbs.data(), aabbs.size(), format, builder,
+					  masks.data());
+}
+
+void CompoundPrimitive::UpdatePrimitives(const uint32_t *indices,
+										 uint32_t count)
+{
+	if (compactBvh) {
+		assert(compactBvh->itemsCount == primitives.size);
+		if (compactBvh->Refit(
+				indices, count,
+				[this](uint32_t id) { return primitives[id].GetAabb({}); },
+				[this](uint32_t id) { return primitives[id].layerMask; }) ==
+			false) {
+			Optimise(compactBvh->format, compactBvh->builder);
+		}
+	} else if (bvh) {
+		Optimise();
+	} else if (localAabbs.size() == primitives.size) {
+		for (uint32_t i = 0; i < count; ++i) {
+			localAabbs[indices[i]] = primitives[indices[i]].GetAabb({});
+		}
+	}
+}
+
+spp::Aabb LocalMovementAabb(const Transform &trans, const Cylinder &cyl,
+							const RayInfo &movementRay)
+{
+	const glm::vec3 start = trans.ToLocal(movementRay.start);
+	const glm::vec3 dir = trans.rot.ToLocal(movementRay.dir);
+	Aabb aabb = cyl.GetAabb({start, {}});
+	aabb.max += glm::max({0, 0, 0}, dir) + ON_EDGE_FACTOR;
+	aabb.min += glm::min({0, 0, 0}, dir) - ON_EDGE_FACTOR;
+	return aabb;
+}
+
+spp::Aabb LocalMovementAabb(const Transform &trans, const Sphere &sph,
+							const RayInfo &movementRay)
+{
+	const glm::vec3 start = trans.ToLocal(movementRay.start);
+	const glm::vec3 dir = trans.rot.ToLocal(movementRay.dir);
+	Aabb aabb = sph.GetAabb({start, {}});
+	aabb.max += glm::max({0, 0, 0}, dir) + ON_EDGE_FACTOR;
+	aabb.min += glm::min({0, 0, 0}, dir) - ON_EDGE_FACTOR;
+	return aabb;
+}
+
+spp::Aabb LocalGroundColumn(const Transform &trans, const Cylinder &cyl,
+							glm::vec3 pos)
+{
+	const glm::vec3 localPos = trans.ToLocal(pos);
+	const float r = (cyl.radius + ON_EDGE_FACTOR) * 1.41421356f;
+	return {{localPos.x - r, -1e30f, localPos.z - r},
+			{localPos.x + r, 1e30f, localPos.z + r}};
+}
+
+namespace
+{
+// Rotation is only around y, transforming 4 corners is enough
+spp::Aabb TransformLocalAabb(const Transform &trans, const spp::Aabb &local)
+{
+	spp::Aabb aabb = spp::AABB_INVALID;
+	for (int i = 0; i < 4; ++i) {
+		const glm::vec3 corner = {i & 1 ? local.max.x : local.min.x, 0,
+								  i & 2 ? local.max.z : local.min.z};
+		const glm::vec3 p = trans * corner;
+		aabb = aabb + spp::Aabb{p, p};
+	}
+	aabb.min.y = local.min.y + trans.pos.y;
+	aabb.max.y = local.max.y + trans.pos.y;
+	return aabb;
+}
+} // namespace
+
 spp::Aabb CompoundPrimitive::GetAabb(const Transform &trans) const
 {
 	if (bvh) {
-		return bvh->GetTotalAabb();
+		return TransformLocalAabb(trans, bvh->GetTotalAabb());
+	} else if (compactBvh) {
+		return TransformLocalAabb(trans, compactBvh->GetTotalAabb());
 	} else {
-		spp::Aabb aabb = spp::AABB_INVALID;
-		for (const auto &s : primitives) {
-			aabb = aabb + s.GetAabb(trans);
-		}
-		return aabb;
+		return Span().GetAabb(trans);
 	}
 }
 
 bool CompoundPrimitive::RayTest(const Transform &trans, const RayInfo &ray,
 								float &near, glm::vec3 &normal) const
 {
-	if (RayTestLocal(trans.ToLocal(ray), near, normal)) {
+	return RayTest(trans, ray, near, normal, LAYER_MASK_ALL);
+}
+
+bool CompoundPrimitive::RayTestLocal(const RayInfo &ray, float &near,
+									 glm::vec3 &normal) const
+{
+	return RayTestLocal(ray, near, normal, LAYER_MASK_ALL);
+}
+
+bool CompoundPrimitive::OcclusionTest(const Transform &trans,
+									  const RayInfo &ray) const
+{
+	return OcclusionTest(trans, ray, LAYER_MASK_ALL);
+}
+
+bool CompoundPrimitive::OverlapTest(const Transform &trans,
+									const OverlapVolume &volume) const
+{
+	return OverlapTest(trans, volume, LAYER_MASK_ALL);
+}
+
+bool CompoundPrimitive::CylinderTestOnGround(const Transform &trans,
+											 const Cylinder &cyl, glm::vec3 pos,
+											 float &offsetHeight,
+											 glm::vec3 *onGroundNormal,
+											 bool *isOnEdge) const
+{
+	return CylinderTestOnGround(trans, cyl, pos, offsetHeight, onGroundNormal,
+								isOnEdge, LAYER_MASK_ALL);
+}
+
+bool CompoundPrimitive::CylinderTestMovement(const Transform &trans,
+											 float &validMovementFactor,
+											 const Cylinder &cyl,
+											 const RayInfo &movementRay,
+											 glm::vec3 &normal) const
+{
+	return CylinderTestMovement(trans, validMovementFactor, cyl, movementRay,
+								normal, LAYER_MASK_ALL);
+}
+
+bool CompoundPrimitive::RayTest(const Transform &trans, const RayInfo &ray,
+								float &near, glm::vec3 &normal,
+								LayerMask queryMask) const
+{
+	if (RayTestLocal(trans.ToLocal(ray), near, normal, queryMask)) {
 		normal = trans.rot * normal;
 		return true;
 	} else {
@@ -64,7 +281,8 @@ bool CompoundPrimitive::RayTest(const Transform &trans, const RayInfo &ray,
 }
 
 bool CompoundPrimitive::RayTestLocal(const RayInfo &ray, float &near,
-									 glm::vec3 &normal) const
+									 glm::vec3 &normal,
+									 LayerMask queryMask) const
 {
 	if (bvh) {
 		assert(false && "Untested");
@@ -73,7 +291,7 @@ bool CompoundPrimitive::RayTestLocal(const RayInfo &ray, float &near,
 			const CompoundPrimitive *cp;
 			bool hasHit = false;
 		} cb{{}, normal, this};
-		cb.mask = ~(uint32_t)0;
+		cb.mask = queryMask;
 		cb.broadphase = (BvhType*)bvh;
 			
 		typedef spp::RayPartialResult (*CbT)(spp::RayCallback<spp::Aabb, uint32_t, uint32_t, 0> *,
@@ -84,7 +302,7 @@ bool CompoundPrimitive::RayTestLocal(const RayInfo &ray, float &near,
 			const auto &prim = cb->cp->primitives[entity-1];
 			float ne;
 			glm::vec3 no;
-			if (prim.RayTestLocal(*cb, ne, no)) {
+			if (prim.RayTestLocal(*cb, ne, no, cb->mask)) {
 				// TODO: remove reduntant code
 				if (ne < 0.0f) {
 					ne = 0.0f;
@@ -103,58 +321,156 @@ bool CompoundPrimitive::RayTestLocal(const RayInfo &ray, float &near,
 		bvh->IntersectRay_const(cb);
 		near = cb.cutFactor;
 		return cb.hasHit;
-	} else {
+	} else if (compactBvh) {
 		bool res = false;
-		float ne;
-		glm::vec3 no;
-		for (const auto &s : primitives) {
-			if (s.RayTestLocal(ray, ne, no)) {
-				if (res) {
-					if (near > ne) {
-						near = ne;
+		float cutFactor = 1.0f;
+		compactBvh->IntersectRay(
+			ray, cutFactor, [&](uint32_t id, float &cut) -> bool {
+				float ne;
+				glm::vec3 no;
+				if (primitives[id].RayTestLocal(ray, ne, no, queryMask)) {
+					if (ne < 0.0f) {
+						ne = 0.0f;
+					}
+					if (ne <= cut) {
 						normal = no;
+						cut = ne;
+						res = true;
 					}
-				} else {
-					near = ne;
-					normal = no;
-					res = true;
 				}
-			}
-		}
+				return false;
+			},
+			queryMask);
+		near = cutFactor;
 		return res;
+	} else {
+		return Span().RayTestLocal(ray, near, normal, queryMask);
+	}
+}
+
+bool CompoundPrimitive::OcclusionTest(const Transform &trans,
+									  const RayInfo &ray,
+									  LayerMask queryMask) const
+{
+	const RayInfo localRay = trans.ToLocal(ray);
+	if (bvh) {
+		// spp bvh callback can not stop traversal
+		float near;
+		glm::vec3 normal;
+		return RayTestLocal(localRay, near, normal, queryMask);
+	} else if (compactBvh) {
+		bool res = false;
+		float cutFactor = 1.0f;
+		compactBvh->IntersectRay(
+			localRay, cutFactor,
+			[&](uint32_t id, float &) -> bool {
+				res = primitives[id].OcclusionTest({}, localRay, queryMask);
+				return res;
+			},
+			queryMask);
+		return res;
+	} else {
+		return Span().OcclusionTest(trans, ray, queryMask);
+	}
+}
+
+void CompoundPrimitive::RayTestAll(const Transform &trans, const RayInfo &ray,
+								   RayHitBuffer &hits,
+								   LayerMask queryMask) const
+{
+	if (compactBvh == nullptr) {
+		// spp bvh callback can not be given cut factor of full buffer
+		Span().RayTestAll(trans, ray, hits, queryMask);
+		return;
 	}
+	const RayInfo localRay = trans.ToLocal(ray);
+	float cutFactor = hits.CutFactor();
+	compactBvh->IntersectRay(
+		localRay, cutFactor,
+		[&](uint32_t id, float &cut) -> bool {
+			float ne;
+			glm::vec3 no;
+			if (primitives[id].RayTestLocal(localRay, ne, no, queryMask)) {
+				if (hits.Add({glm::max(ne, 0.0f), trans.rot * no, id})) {
+					cut = hits.CutFactor();
+				}
+			}
+			return false;
+		},
+		queryMask);
+}
+
+bool CompoundPrimitive::OverlapTest(const Transform &trans,
+									const OverlapVolume &volume,
+									LayerMask queryMask) const
+{
+	uint32_t id;
+	return OverlapAll(trans, volume, &id, 1, queryMask) != 0;
+}
+
+uint32_t CompoundPrimitive::OverlapAll(const Transform &trans,
+									   const OverlapVolume &volume,
+									   uint32_t *ids, uint32_t maxIds,
+									   LayerMask queryMask) const
+{
+	if (compactBvh == nullptr) {
+		// spp bvh callback can not stop traversal when ids are full
+		return Span().OverlapAll(trans, volume, ids, maxIds, queryMask);
+	}
+	const OverlapVolume local = volume.ToLocal(trans);
+	uint32_t found = 0;
+	if (maxIds == 0) {
+		return 0;
+	}
+	compactBvh->IntersectAabb(
+		local.GetAabb(),
+		[&](uint32_t id) -> bool {
+			if (primitives[id].OverlapTest({}, local, queryMask)) {
+				ids[found++] = id;
+			}
+			return found >= maxIds;
+		},
+		queryMask);
+	return found;
 }
 
 bool CompoundPrimitive::CylinderTestOnGround(const Transform &trans,
 											 const Cylinder &cyl, glm::vec3 pos,
 											 float &offsetHeight,
 											 glm::vec3 *onGroundNormal,
-											 bool *isOnEdge) const
+											 bool *isOnEdge,
+											 LayerMask queryMask) const
 {
-	// TODO: implement with bvh
-	bool res = false;
-	float ofh;
-	for (const auto &s : primitives) {
-		if (s.CylinderTestOnGround(trans, cyl, pos, ofh, onGroundNormal,
-								   isOnEdge)) {
-			if (res) {
-				if (offsetHeight < ofh) {
-					offsetHeight = ofh;
+	if (compactBvh) {
+		bool res = false;
+		compactBvh->IntersectAabb(
+			LocalGroundColumn(trans, cyl, pos),
+			[&](uint32_t id) -> bool {
+				float ofh;
+				if (primitives[id].CylinderTestOnGround(
+						trans, cyl, pos, ofh, onGroundNormal, isOnEdge,
+						queryMask)) {
+					if (res == false || offsetHeight < ofh) {
+						offsetHeight = ofh;
+						res = true;
+					}
 				}
-			} else {
-				offsetHeight = ofh;
-				res = true;
-			}
-		}
+				return false;
+			},
+			queryMask);
+		return res;
+	} else {
+		return Span().CylinderTestOnGround(trans, cyl, pos, offsetHeight,
+										   onGroundNormal, isOnEdge, queryMask);
 	}
-	return res;
 }
 
 bool CompoundPrimitive::CylinderTestMovement(const Transform &trans,
 											 float &validMovementFactor,
 											 const Cylinder &cyl,
 											 const RayInfo &movementRay,
-											 glm::vec3 &normal) const
+											 glm::vec3 &normal,
+											 LayerMask queryMask) const
 {
 	if (bvh) {
 		assert(false && "Untested");
@@ -172,7 +488,7 @@ bool CompoundPrimitive::CylinderTestMovement(const Transform &trans,
 			validMovementFactor,
 			cyl,
 			movementRay, normal};
-		cb.mask = ~(uint32_t)0;
+		cb.mask = queryMask;
 
 		typedef void (*CbT)(spp::AabbCallback<spp::Aabb, uint32_t, uint32_t, 0> *, uint32_t);
 		cb.callback = (CbT) + [](_Cb *cb, uint32_t entity) {
@@ -180,7 +496,7 @@ bool CompoundPrimitive::CylinderTestMovement(const Transform &trans,
 			
 			float vmf;
 			glm::vec3 no;
-			if (prim.CylinderTestMovement(cb->trans, vmf, cb->cyl, cb->movementRay, no)) {
+			if (prim.CylinderTestMovement(cb->trans, vmf, cb->cyl, cb->movementRay, no, cb->mask)) {
 				// TODO: remove reduntant code
 				if (cb->res) {
 					if (cb->validMovementFactor > vmf) {
@@ -195,33 +511,114 @@ bool CompoundPrimitive::CylinderTestMovement(const Transform &trans,
 			}
 		};
 		
-		Aabb aabb = cyl.GetAabb({movementRay.start - trans.pos, {}});
-		aabb.max += glm::max({0, 0, 0}, movementRay.dir) + ON_EDGE_FACTOR;
-		aabb.min += glm::min({0, 0, 0}, movementRay.dir) - ON_EDGE_FACTOR;
-		cb.aabb = aabb;
+		cb.aabb = LocalMovementAabb(trans, cyl, movementRay);
 		
 		bvh->IntersectAabb(cb);
 
 		return cb.res;
-	} else {
+	} else if (compactBvh) {
 		bool res = false;
-		float vmf;
-		glm::vec3 no;
-		for (const auto &s : primitives) {
-			if (s.CylinderTestMovement(trans, vmf, cyl, movementRay, no)) {
-				if (res) {
-					if (validMovementFactor > vmf) {
+		compactBvh->IntersectAabb(
+			LocalMovementAabb(trans, cyl, movementRay),
+			[&](uint32_t id) -> bool {
+				float vmf;
+				glm::vec3 no;
+				if (primitives[id].CylinderTestMovement(
+						trans, vmf, cyl, movementRay, no, queryMask)) {
+					if (res == false || validMovementFactor > vmf) {
 						validMovementFactor = vmf;
 						normal = no;
+						res = true;
 					}
-				} else {
-					validMovementFactor = vmf;
-					normal = no;
-					res = true;
+				}
+				return false;
+			},
+			queryMask);
+		return res;
+	} else {
+		return Span().CylinderTestMovement(trans, validMovementFactor, cyl,
+										   movementRay, normal, queryMask);
+	}
+}
+
+bool CompoundPrimitive::SphereTestMovement(const Transform &trans,
+										   float &validMovementFactor,
+										   const Sphere &sph,
+										   const RayInfo &movementRay,
+										   glm::vec3 &normal) const
+{
+	return SphereTestMovement(trans, validMovementFactor, sph, movementRay,
+							  normal, LAYER_MASK_ALL);
+}
+
+bool CompoundPrimitive::SphereTestMovement(const Transform &trans,
+										   float &validMovementFactor,
+										   const Sphere &sph,
+										   const RayInfo &movementRay,
+										   glm::vec3 &normal,
+										   LayerMask queryMask) const
+{
+	if (bvh) {
+		assert(false && "Untested");
+		struct _Cb : public spp::AabbCallback<spp::Aabb, uint32_t, uint32_t, 0> {
+			const CompoundPrimitive *cp;
+
+			const Transform &trans;
+			float &validMovementFactor;
+			const Sphere &sph;
+			const RayInfo &movementRay;
+			glm::vec3 &normal;
+			bool res = false;
+		} cb{{}, this, trans, validMovementFactor, sph, movementRay, normal};
+		cb.mask = queryMask;
+
+		typedef void (*CbT)(spp::AabbCallback<spp::Aabb, uint32_t, uint32_t, 0> *, uint32_t);
+		cb.callback = (CbT) + [](_Cb *cb, uint32_t entity) {
+			const auto &prim = cb->cp->primitives[entity-1];
+
+			float vmf;
+			glm::vec3 no;
+			if (prim.SphereTestMovement(cb->trans, vmf, cb->sph,
+										cb->movementRay, no, cb->mask)) {
+				if (cb->res == false || cb->validMovementFactor > vmf) {
+					cb->validMovementFactor = vmf;
+					cb->normal = no;
+					cb->res = true;
 				}
 			}
-		}
+		};
+
+		cb.aabb = LocalMovementAabb(trans, sph, movementRay);
+
+		bvh->IntersectAabb(cb);
+
+		return cb.res;
+	} else if (compactBvh) {
+		// Nodes are expanded by radius, so nearer primitives are tested first
+		// and farther subtrees are cut off
+		bool res = false;
+		float cutFactor = 1.0f;
+		compactBvh->IntersectRay(
+			trans.ToLocal(movementRay), cutFactor,
+			[&](uint32_t id, float &cut) -> bool {
+				float vmf;
+				glm::vec3 no;
+				if (primitives[id].SphereTestMovement(
+						trans, vmf, sph, movementRay, no, queryMask)) {
+					if (vmf <= cut) {
+						cut = vmf;
+						normal = no;
+						res = true;
+					}
+				}
+				return false;
+			},
+			queryMask, sph.radius);
+		validMovementFactor = cutFactor;
 		return res;
+	} else {
+		return Span().SphereTestMovement(trans, validMovementFactor, sph,
+										 movementRay, normal, queryMask);
 	}
 }
 } // namespace Collision3D
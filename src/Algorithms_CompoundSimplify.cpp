@@ -0,0 +1,185 @@
+// This file is part of Collision3D.
+// Copyright (c) 2025 Marek Zalewski aka Drwalin
+// You should have received a copy of the MIT License along with this program.
+
+#include <vector>
+
+#include "../include/collision3d/CollisionShapes_AnyOrCompound.hpp"
+
+namespace Collision3D
+{
+using namespace spp;
+
+namespace
+{
+// VertBox in space rotated by its own rotation, there it is axis aligned
+struct LocalBox {
+	glm::vec3 min;
+	glm::vec3 max;
+	Rotation rot;
+	LayerMask layerMask;
+	uint32_t index;
+	bool alive;
+	// Only merged boxes are written back, others keep exact original values
+	bool merged;
+};
+
+LocalBox ToLocalBox(const AnyPrimitive &p, uint32_t index)
+{
+	const glm::vec3 he = p.vertBox.halfExtents;
+	const glm::vec3 c = p.rot.ToLocal(p.pos);
+	return {c - glm::vec3{he.x, 0, he.z}, c + glm::vec3{he.x, he.y * 2.0f, he.z},
+			p.rot, p.layerMask, index, true, false};
+}
+
+void FromLocalBox(const LocalBox &box, AnyPrimitive &p)
+{
+	const glm::vec3 he = (box.max - box.min) * 0.5f;
+	glm::vec3 c = (box.max + box.min) * 0.5f;
+	c.y = box.min.y;
+	p.vertBox.halfExtents = {he.x, he.y, he.z};
+	p.pos = box.rot * c;
+	p.rot = box.rot;
+}
+
+bool Equal(float a, float b, float epsilon)
+{
+	return glm::abs(a - b) <= epsilon;
+}
+
+// Union of boxes is a box when they match on two axes and touch on third.
+// Boxes of different layers stay separate, queries could see their union.
+// Stacked boxes stay separate, ground test reports the lowest top.
+bool TryMerge(LocalBox &a, const LocalBox &b, float epsilon)
+{
+	if (a.rot.value != b.rot.value || a.layerMask != b.layerMask) {
+		return false;
+	}
+	for (int axis = 0; axis < 3; axis += 2) {
+		bool matching = true;
+		for (int i = 0; i < 3; ++i) {
+			if (i != axis && (!Equal(a.min[i], b.min[i], epsilon) ||
+							  !Equal(a.max[i], b.max[i], epsilon))) {
+				matching = false;
+				break;
+			}
+		}
+		if (matching == false) {
+			continue;
+		}
+		if (a.max[axis] + epsilon < b.min[axis] ||
+			b.max[axis] + epsilon < a.min[axis]) {
+			return false;
+		}
+		a.min[axis] = glm::min(a.min[axis], b.min[axis]);
+		a.max[axis] = glm::max(a.max[axis], b.max[axis]);
+		a.merged = true;
+		return true;
+	}
+	return false;
+}
+
+// Contained primitive is removable only when every query hitting it hits box.
+// Ground test keeps the lowest top, so only flat tops level with top of box
+// may go.
+bool IsContained(const AnyPrimitive &p, const LocalBox &box, float epsilon)
+{
+	if ((p.layerMask & ~box.layerMask) != 0) {
+		return false;
+	}
+	if (p.type != AnyPrimitive::VERTBOX && p.type != AnyPrimitive::CYLINDER) {
+		return false;
+	}
+	// Primitive applies its own pos and rot, only rotation to box is given
+	const spp::Aabb aabb = p.GetAabb({{0, 0, 0}, box.rot.inverse()});
+	if (!Equal(aabb.max.y, box.max.y, epsilon)) {
+		return false;
+	}
+	for (int i = 0; i < 3; ++i) {
+		if (aabb.min[i] < box.min[i] - epsilon ||
+			aabb.max[i] > box.max[i] + epsilon) {
+			return false;
+		}
+	}
+	return true;
+}
+} // namespace
+
+CompoundSimplifyStats CompoundPrimitive::Simplify(float epsilon)
+{
+	CompoundSimplifyStats stats;
+	stats.primitivesBefore = primitives.size;
+
+	std::vector<bool> alive(primitives.size, true);
+
+	std::vector<LocalBox> boxes;
+	for (uint32_t i = 0; i < primitives.size; ++i) {
+		if (primitives[i].type == AnyPrimitive::VERTBOX) {
+			boxes.push_back(ToLocalBox(primitives[i], i));
+		}
+	}
+
+	// Merging may enable further merges, repeat until nothing changes
+	for (bool changed = true; changed;) {
+		changed = false;
+		for (size_t i = 0; i < boxes.size(); ++i) {
+			if (boxes[i].alive == false) {
+				continue;
+			}
+			for (size_t j = i + 1; j < boxes.size(); ++j) {
+				if (boxes[j].alive && TryMerge(boxes[i], boxes[j], epsilon)) {
+					boxes[j].alive = false;
+					alive[boxes[j].index] = false;
+					++stats.mergedBoxes;
+					changed = true;
+				}
+			}
+		}
+	}
+
+	for (const LocalBox &box : boxes) {
+		if (box.alive && box.merged) {
+			FromLocalBox(box, primitives[box.index]);
+		}
+	}
+
+	// Container is never removed before testing against it, so of two
+	// identical primitives only one is removed
+	for (const LocalBox &box : boxes) {
+		if (alive[box.index] == false) {
+			continue;
+		}
+		for (uint32_t i = 0; i < primitives.size; ++i) {
+			if (i != box.index && alive[i] &&
+				IsContained(primitives[i], box, epsilon)) {
+				alive[i] = false;
+				++stats.removedContained;
+			}
+		}
+	}
+
+	uint32_t count = 0;
+	for (uint32_t i = 0; i < primitives.size; ++i) {
+		if (alive[i]) {
+			if (count != i) {
+				primitives[count] = primitives[i];
+			}
+			++count;
+		}
+	}
+	primitives.resize(count);
+	stats.primitivesAfter = count;
+
+	if (count != stats.primitivesBefore) {
+		if (compactBvh) {
+			Optimise(compactBvh->format, compactBvh->builder);
+		} else if (bvh) {
+			Optimise();
+		}
+	}
+	if (localAabbs.empty() == false) {
+		CacheLocalAabbs();
+	}
+	return stats;
+}
+} // namespace Collision3D
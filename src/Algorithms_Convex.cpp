@@ -47,4 +47,147 @@ bool TestPlaneIterational(glm::vec3 normal, float d, const RayInfo &ray,
 	}
 	return true;
 }
+
+bool RayTestConvexSoA(const float *nx, const float *ny, const float *nz,
+					  const float *offsets, int planesCount,
+					  const RayInfo &ray, float &near, glm::vec3 &normal)
+{
+	assert(planesCount % CONVEX_SOA_WIDTH == 0);
+	constexpr int W = CONVEX_SOA_WIDTH;
+
+	// Per lane reductions, no data dependent branches so that compiler can
+	// vectorise the loop
+	float lNear[W], lFar[W], lParallel[W];
+	for (int j = 0; j < W; ++j) {
+		lNear[j] = -1e9f;
+		lFar[j] = 1e9f;
+		lParallel[j] = -1.0f;
+	}
+	for (int i = 0; i < planesCount; i += W) {
+		for (int j = 0; j < W; ++j) {
+			const int k = i + j;
+			const float vd =
+				nx[k] * ray.dir.x + ny[k] * ray.dir.y + nz[k] * ray.dir.z;
+			const float vn = nx[k] * ray.start.x + ny[k] * ray.start.y +
+							 nz[k] * ray.start.z - offsets[k];
+			const float t = -vn / vd;
+			lNear[j] = vd < 0.0f ? glm::max(lNear[j], t) : lNear[j];
+			lFar[j] = vd > 0.0f ? glm::min(lFar[j], t) : lFar[j];
+			// ray parallel to plane and outside of it
+			lParallel[j] = vd == 0.0f ? glm::max(lParallel[j], vn) : lParallel[j];
+		}
+	}
+	float far = lFar[0], parallel = lParallel[0];
+	near = lNear[0];
+	for (int j = 1; j < W; ++j) {
+		near = glm::max(near, lNear[j]);
+		far = glm::min(far, lFar[j]);
+		parallel = glm::max(parallel, lParallel[j]);
+	}
+
+	if (parallel > 0.0f || far < 0.0f || far < near || near > 1.0f) {
+		return false;
+	}
+
+	if (near < 0.0f) {
+		/* is inside, shortest way outside is through nearest plane */
+		near = 0.0f;
+		float d = -1e30f;
+		for (int k = 0; k < planesCount; ++k) {
+			const float d2 = nx[k] * ray.start.x + ny[k] * ray.start.y +
+							 nz[k] * ray.start.z - offsets[k];
+			if (d2 > d) {
+				d = d2;
+				normal = {nx[k], ny[k], nz[k]};
+			}
+		}
+		return true;
+	}
+
+	/* outside, hitting front face, it is the one with latest entry */
+	float tBest = -1e30f;
+	for (int k = 0; k < planesCount; ++k) {
+		const float vd =
+			nx[k] * ray.dir.x + ny[k] * ray.dir.y + nz[k] * ray.dir.z;
+		if (vd < 0.0f) {
+			const float vn = nx[k] * ray.start.x + ny[k] * ray.start.y +
+							 nz[k] * ray.start.z - offsets[k];
+			const float t = -vn / vd;
+			if (t > tBest) {
+				tBest = t;
+				normal = {nx[k], ny[k], nz[k]};
+			}
+		}
+	}
+	return true;
+}
+
+bool RayTestConvex(const glm::vec3 *normals, const float *offsets,
+				   int planesCount, const RayInfo &ray, float &near,
+				   glm::vec3 &normal)
+{
+	assert(planesCount <= RAY_TEST_CONVEX_MAX_PLANES);
+	constexpr int N = RAY_TEST_CONVEX_MAX_PLANES;
+	float nx[N], ny[N], nz[N], offs[N];
+	int count = 0;
+	for (int i = 0; i < planesCount; ++i) {
+		const float len = glm::length(normals[i]);
+		if (len == 0.0f) {
+			if (offsets[i] < 0.0f) {
+				return false;
+			}
+			continue;
+		}
+		const glm::vec3 n = normals[i] / len;
+		nx[count] = n.x;
+		ny[count] = n.y;
+		nz[count] = n.z;
+		offs[count] = offsets[i] / len;
+		++count;
+	}
+	for (; count % CONVEX_SOA_WIDTH; ++count) {
+		nx[count] = ny[count] = nz[count] = 0.0f;
+		offs[count] = CONVEX_SOA_PAD_OFFSET;
+	}
+	return RayTestConvexSoA(nx, ny, nz, offs, count, ray, near, normal);
+}
+
+bool CylinderTestMovementTriangle(glm::vec3 a, glm::vec3 b, glm::vec3 c,
+								  float radius, float height,
+								  const RayInfo &ray, float &near,
+								  glm::vec3 &normal)
+{
+	// Minkowski sum of triangle and box [-r, r] x [-h, 0] x [-r, r] is
+	// bounded by triangle normal, box axes and crosses of triangle edges with
+	// box axes, each taken in both directions.
+	const glm::vec3 v[3] = {a, b, c};
+	const glm::vec3 axes[3] = {{1, 0, 0}, {0, 1, 0}, {0, 0, 1}};
+	glm::vec3 normals[26];
+	float offsets[26];
+	int count = 0;
+	auto add = [&](glm::vec3 n) {
+		if (n.x == 0.0f && n.y == 0.0f && n.z == 0.0f) {
+			return;
+		}
+		for (const glm::vec3 m : {n, -n}) {
+			const float support = glm::max(
+				glm::dot(m, v[0]), glm::max(glm::dot(m, v[1]), glm::dot(m, v[2])));
+			normals[count] = m;
+			offsets[count] = support + radius * (fabs(m.x) + fabs(m.z)) +
+							 (m.y < 0.0f ? -m.y * height : 0.0f);
+			++count;
+		}
+	};
+	add(glm::cross(b - a, c - a));
+	for (const glm::vec3 &axis : axes) {
+		add(axis);
+	}
+	for (int i = 0; i < 3; ++i) {
+		const glm::vec3 e = v[TRIANGLE_EDGES[i][1]] - v[TRIANGLE_EDGES[i][0]];
+		for (const glm::vec3 &axis : axes) {
+			add(glm::cross(e, axis));
+		}
+	}
+	return RayTestConvex(normals, offsets, count, ray, near, normal);
+}
 } // namespace Collision3D
@@ -0,0 +1,520 @@
+// This file is part of Collision3D.
+// Copyright (c) 2025 Marek Zalewski aka Drwalin
+// You should have received a copy of the MIT License along with this program.
+
+#include <cstring>
+#include <cstdlib>
+
+#include <bit>
+#include <vector>
+
+#include "../include/collision3d/CollisionShapes_AnyOrCompound.hpp"
+
+namespace Collision3D
+{
+using namespace spp;
+
+// Appends planes in SoA layout used by RayTestConvexSoA(), padded with planes
+// that never clip
+static void StorePlanesSoA(const glm::vec3 *normals, const float *offsets,
+						   uint32_t count, std::vector<float> &out)
+{
+	uint32_t n = count;
+	while (n % CONVEX_SOA_WIDTH) {
+		++n;
+	}
+	out.assign(n * 4, 0.0f);
+	for (uint32_t i = 0; i < n; ++i) {
+		if (i < count) {
+			out[i] = normals[i].x;
+			out[n + i] = normals[i].y;
+			out[n * 2 + i] = normals[i].z;
+			out[n * 3 + i] = offsets[i];
+		} else {
+			out[n * 3 + i] = CONVEX_SOA_PAD_OFFSET;
+		}
+	}
+}
+
+ConvexHull_Data *ConvexHull_Data::Allocate(uint32_t planesCount,
+											uint32_t movementPlanesCount,
+											uint32_t verticesCount,
+											uint32_t edgesCount)
+{
+	// Float arrays start at 16 byte offsets, as aligned as malloc result
+	auto align = [](size_t bytes) { return (bytes + 15) & ~(size_t)15; };
+	size_t bytes = align(sizeof(ConvexHull_Data));
+	const size_t offsetPlanes = bytes;
+	bytes += align(planesCount * 4 * sizeof(float));
+	const size_t offsetMovementPlanes = bytes;
+	bytes += align(movementPlanesCount * 4 * sizeof(float));
+	const size_t offsetVertices = bytes;
+	bytes += verticesCount * sizeof(glm::vec3);
+	const size_t offsetEdges = bytes;
+	bytes += edgesCount * 2;
+
+	void *ptr = malloc(bytes);
+	memset(ptr, 0, sizeof(ConvexHull_Data));
+	ConvexHull_Data *ret = new (ptr) ConvexHull_Data();
+	ret->bytes = bytes;
+	ret->references = 1;
+	ret->planesCount = planesCount;
+	ret->movementPlanesCount = movementPlanesCount;
+	ret->verticesCount = verticesCount;
+	ret->edgesCount = edgesCount;
+	ret->localAabb = spp::AABB_INVALID;
+	ret->planes = (float *)((size_t)ptr + offsetPlanes);
+	ret->movementPlanes = (float *)((size_t)ptr + offsetMovementPlanes);
+	ret->vertices = (glm::vec3 *)((size_t)ptr + offsetVertices);
+	ret->edges = (uint8_t(*)[2])((size_t)ptr + offsetEdges);
+	return ret;
+}
+
+void ConvexHull_Data::Free(ConvexHull_Data *data)
+{
+	data->~ConvexHull_Data();
+	free(data);
+}
+
+ConvexHull::~ConvexHull() { Release(); }
+
+ConvexHull::ConvexHull(ConvexHull &other)
+	: ConvexHull((const ConvexHull &)other)
+{
+}
+
+ConvexHull::ConvexHull(ConvexHull &&other) : data(other.data)
+{
+	other.data = nullptr;
+}
+
+ConvexHull::ConvexHull(const ConvexHull &other) : data(other.data)
+{
+	if (data) {
+		data->references.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+ConvexHull &ConvexHull::operator=(ConvexHull &other)
+{
+	return *this = (const ConvexHull &)other;
+}
+
+ConvexHull &ConvexHull::operator=(ConvexHull &&other)
+{
+	if (this != &other) {
+		Release();
+		data = other.data;
+		other.data = nullptr;
+	}
+	return *this;
+}
+
+ConvexHull &ConvexHull::operator=(const ConvexHull &other)
+{
+	// Release() clears other.data on self assignment
+	ConvexHull_Data *shared = other.data;
+	if (shared) {
+		shared->references.fetch_add(1, std::memory_order_relaxed);
+	}
+	Release();
+	data = shared;
+	return *this;
+}
+
+void ConvexHull::Release()
+{
+	if (data) {
+		if (data->references.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+			ConvexHull_Data::Free(data);
+		}
+		data = nullptr;
+	}
+}
+
+bool ConvexHull::Init(const glm::vec3 *normals, const float *offsets,
+					  uint32_t planesCount)
+{
+	Release();
+	std::vector<float> planes;
+	std::vector<float> movementPlanes;
+	std::vector<glm::vec3> vertices;
+	std::vector<uint8_t> edges;
+	spp::Aabb localAabb = spp::AABB_INVALID;
+	if (planesCount > MAX_PLANES) {
+		return false;
+	}
+
+	// Unit and unique planes
+	glm::vec3 n[MAX_PLANES];
+	float d[MAX_PLANES];
+	uint32_t count = 0;
+	float maxOffset = 0.0f;
+	for (uint32_t i = 0; i < planesCount; ++i) {
+		const float len = glm::length(normals[i]);
+		if (len == 0.0f) {
+			if (offsets[i] < 0.0f) {
+				return false;
+			}
+			continue;
+		}
+		const glm::vec3 nn = normals[i] / len;
+		const float dd = offsets[i] / len;
+		bool duplicate = false;
+		for (uint32_t j = 0; j < count; ++j) {
+			if (glm::dot(n[j], nn) > 1.0f - 1e-6f) {
+				d[j] = glm::min(d[j], dd);
+				duplicate = true;
+				break;
+			}
+		}
+		if (duplicate == false) {
+			n[count] = nn;
+			d[count] = dd;
+			++count;
+		}
+		maxOffset = glm::max(maxOffset, glm::abs(dd));
+	}
+	const float eps = 1e-4f * (1.0f + maxOffset);
+
+	// Vertices are intersections of three planes inside of all others, masks
+	// mark planes they lie on
+	std::vector<uint32_t> masks;
+	for (uint32_t i = 0; i < count; ++i) {
+		for (uint32_t j = i + 1; j < count; ++j) {
+			for (uint32_t k = j + 1; k < count; ++k) {
+				const glm::vec3 c = glm::cross(n[j], n[k]);
+				const float det = glm::dot(n[i], c);
+				if (glm::abs(det) < 1e-6f) {
+					continue;
+				}
+				const glm::vec3 p = (c * d[i] + glm::cross(n[k], n[i]) * d[j] +
+									 glm::cross(n[i], n[j]) * d[k]) /
+									det;
+				uint32_t mask = 0;
+				bool inside = true;
+				for (uint32_t l = 0; l < count && inside; ++l) {
+					const float dist = glm::dot(n[l], p) - d[l];
+					inside = dist <= eps;
+					if (dist > -eps) {
+						mask |= 1u << l;
+					}
+				}
+				if (inside == false) {
+					continue;
+				}
+				bool merged = false;
+				for (uint32_t v = 0; v < vertices.size(); ++v) {
+					if (glm::distance(vertices[v], p) <= eps) {
+						masks[v] |= mask;
+						merged = true;
+						break;
+					}
+				}
+				if (merged == false) {
+					vertices.push_back(p);
+					masks.push_back(mask);
+				}
+			}
+		}
+	}
+	if (vertices.size() < 4 || vertices.size() > 255) {
+		return false;
+	}
+
+	// Facets have at least three vertices, other planes are redundant
+	uint32_t facets = 0;
+	glm::vec3 fn[MAX_PLANES];
+	float fd[MAX_PLANES];
+	uint32_t facetsCount = 0;
+	for (uint32_t l = 0; l < count; ++l) {
+		uint32_t onPlane = 0;
+		for (uint32_t m : masks) {
+			onPlane += (m >> l) & 1;
+		}
+		if (onPlane >= 3) {
+			facets |= 1u << l;
+			fn[facetsCount] = n[l];
+			fd[facetsCount] = d[l];
+			++facetsCount;
+		}
+	}
+	if (facetsCount < 4) {
+		return false;
+	}
+
+	// Vertices sharing two facets are connected by an edge
+	for (uint32_t a = 0; a < vertices.size(); ++a) {
+		for (uint32_t b = a + 1; b < vertices.size(); ++b) {
+			if (std::popcount(masks[a] & masks[b] & facets) >= 2) {
+				edges.push_back(a);
+				edges.push_back(b);
+			}
+		}
+	}
+
+	for (const glm::vec3 &v : vertices) {
+		localAabb = localAabb + spp::Aabb{v, v};
+	}
+
+	StorePlanesSoA(fn, fd, facetsCount, planes);
+
+	// Candidate normals of Minkowski sum with box, unique
+	std::vector<glm::vec3> mn(fn, fn + facetsCount);
+	auto add = [&](glm::vec3 a) {
+		const float len = glm::length(a);
+		if (len < 1e-6f) {
+			return;
+		}
+		a /= len;
+		for (const glm::vec3 b : {a, -a}) {
+			bool duplicate = false;
+			for (const glm::vec3 &c : mn) {
+				if (glm::dot(b, c) > 1.0f - 1e-6f) {
+					duplicate = true;
+					break;
+				}
+			}
+			if (duplicate == false) {
+				mn.push_back(b);
+			}
+		}
+	};
+	const glm::vec3 axes[3] = {{1, 0, 0}, {0, 1, 0}, {0, 0, 1}};
+	for (const glm::vec3 &axis : axes) {
+		add(axis);
+	}
+	for (uint32_t e = 0; e < edges.size(); e += 2) {
+		const glm::vec3 dir = vertices[edges[e + 1]] - vertices[edges[e]];
+		for (const glm::vec3 &axis : axes) {
+			add(glm::cross(dir, axis));
+		}
+	}
+	if (mn.size() + CONVEX_SOA_WIDTH > MAX_MOVEMENT_PLANES) {
+		return false;
+	}
+	std::vector<float> support(mn.size());
+	for (uint32_t i = 0; i < mn.size(); ++i) {
+		support[i] = glm::dot(mn[i], vertices[0]);
+		for (const glm::vec3 &v : vertices) {
+			support[i] = glm::max(support[i], glm::dot(mn[i], v));
+		}
+	}
+	StorePlanesSoA(mn.data(), support.data(), mn.size(), movementPlanes);
+
+	data = ConvexHull_Data::Allocate(planes.size() / 4,
+									 movementPlanes.size() / 4,
+									 vertices.size(), edges.size() / 2);
+	data->localAabb = localAabb;
+	memcpy(data->planes, planes.data(), planes.size() * sizeof(float));
+	memcpy(data->movementPlanes, movementPlanes.data(),
+		   movementPlanes.size() * sizeof(float));
+	memcpy(data->vertices, vertices.data(),
+		   vertices.size() * sizeof(glm::vec3));
+	memcpy(data->edges, edges.data(), edges.size());
+	return true;
+}
+
+spp::Aabb ConvexHull::GetAabb(const Transform &trans) const
+{
+	if (data == nullptr) {
+		return spp::AABB_INVALID;
+	}
+	const spp::Aabb &localAabb = data->localAabb;
+	// Rotation is only around y, transforming 4 corners is enough
+	spp::Aabb aabb = spp::AABB_INVALID;
+	for (int i = 0; i < 4; ++i) {
+		const glm::vec3 corner = {i & 1 ? localAabb.max.x : localAabb.min.x, 0,
+								  i & 2 ? localAabb.max.z : localAabb.min.z};
+		const glm::vec3 p = trans * corner;
+		aabb = aabb + spp::Aabb{p, p};
+	}
+	aabb.min.y = localAabb.min.y + trans.pos.y;
+	aabb.max.y = localAabb.max.y + trans.pos.y;
+	return aabb;
+}
+
+bool ConvexHull::RayTest(const Transform &trans, const RayInfo &ray,
+						 float &near, glm::vec3 &normal) const
+{
+	if (RayTestLocal(trans.ToLocal(ray), near, normal)) {
+		normal = trans.rot * normal;
+		return true;
+	} else {
+		return false;
+	}
+}
+
+bool ConvexHull::RayTestLocal(const RayInfo &ray, float &near,
+							  glm::vec3 &normal) const
+{
+	const uint32_t n = GetPlanesCount();
+	if (n == 0) {
+		return false;
+	}
+	const float *p = data->planes;
+	return RayTestConvexSoA(p, p + n, p + n * 2, p + n * 3, n, ray, near,
+							normal);
+}
+
+bool ConvexHull::OcclusionTest(const Transform &trans, const RayInfo &ray) const
+{
+	float near;
+	glm::vec3 normal;
+	return RayTestLocal(trans.ToLocal(ray), near, normal);
+}
+
+bool ConvexHull::OverlapTest(const Transform &trans,
+							 const OverlapVolume &volume) const
+{
+	if (data == nullptr) {
+		return false;
+	}
+	return OverlapTestConvex(data->vertices, data->verticesCount, 0.0f,
+							 volume.ToLocal(trans));
+}
+
+bool ConvexHull::CylinderTestOnGround(const Transform &trans,
+									  const Cylinder &cyl, glm::vec3 pos,
+									  float &offsetHeight,
+									  glm::vec3 *onGroundNormal,
+									  bool *isOnEdge) const
+{
+	const uint32_t n = GetPlanesCount();
+	if (n == 0) {
+		return false;
+	}
+	const float *nx = data->planes;
+	const float *ny = nx + n;
+	const float *nz = ny + n;
+	const float *offs = nz + n;
+	const glm::vec3 localPos = trans.ToLocal(pos);
+
+	// Lowest upper plane and highest lower plane above point in XZ
+	auto topAt = [&](float x, float z, float &bottom, uint32_t &plane) {
+		float top = 1e30f;
+		bottom = -1e30f;
+		for (uint32_t k = 0; k < n; ++k) {
+			const float w = offs[k] - nx[k] * x - nz[k] * z;
+			if (ny[k] > 0.0f && w / ny[k] < top) {
+				top = w / ny[k];
+				plane = k;
+			} else if (ny[k] < 0.0f) {
+				bottom = glm::max(bottom, w / ny[k]);
+			} else if (ny[k] == 0.0f && w < 0.0f) {
+				bottom = 1e30f;
+			}
+		}
+		return top;
+	};
+
+	glm::vec2 q{localPos.x, localPos.z};
+	float bottom;
+	uint32_t plane = 0;
+	const float top = topAt(q.x, q.y, bottom, plane);
+	if (top < bottom) {
+		// Outside of XZ projection, nearest point is on projection of edge
+		const glm::vec2 p = q;
+		float best = 1e30f;
+		for (uint32_t e = 0; e < data->edgesCount; ++e) {
+			const glm::vec3 a3 = data->vertices[data->edges[e][0]];
+			const glm::vec3 b3 = data->vertices[data->edges[e][1]];
+			const glm::vec2 a{a3.x, a3.z};
+			const glm::vec2 ab = glm::vec2{b3.x, b3.z} - a;
+			const float ee = glm::dot(ab, ab);
+			const float f =
+				ee > 0.0f ? glm::clamp(glm::dot(p - a, ab) / ee, 0.0f, 1.0f)
+						  : 0.0f;
+			const glm::vec2 c = a + ab * f;
+			const float dd = glm::dot(p - c, p - c);
+			if (dd < best) {
+				best = dd;
+				q = c;
+			}
+		}
+	}
+	const float dist = glm::distance(glm::vec2{localPos.x, localPos.z}, q);
+	if (dist > cyl.radius + ON_EDGE_FACTOR) {
+		return false;
+	}
+
+	const float y = topAt(q.x, q.y, bottom, plane);
+	const glm::vec3 normal{nx[plane], ny[plane], nz[plane]};
+	if (IsGroundNormal(normal) == false) {
+		return false;
+	}
+	offsetHeight = localPos.y - y;
+
+	if (onGroundNormal) {
+		*onGroundNormal = trans.rot * normal;
+	}
+
+	if (isOnEdge) {
+		if (dist > cyl.radius) {
+			*isOnEdge = true;
+		}
+	}
+
+	return true;
+}
+
+bool ConvexHull::CylinderTestMovement(const Transform &trans,
+									  float &validMovementFactor,
+									  const Cylinder &cyl,
+									  const RayInfo &movementRay,
+									  glm::vec3 &normal) const
+{
+	const uint32_t n = GetMovementPlanesCount();
+	if (n == 0) {
+		return false;
+	}
+	const float *nx = data->movementPlanes;
+	const float *ny = nx + n;
+	const float *nz = ny + n;
+	const float *support = nz + n;
+	// Add support of box [-r, r] x [-h, 0] x [-r, r]
+	float offs[MAX_MOVEMENT_PLANES];
+	for (uint32_t k = 0; k < n; ++k) {
+		offs[k] = support[k] + cyl.radius * (glm::abs(nx[k]) + glm::abs(nz[k])) +
+				  glm::max(-ny[k], 0.0f) * cyl.height;
+	}
+	if (RayTestConvexSoA(nx, ny, nz, offs, n, trans.ToLocal(movementRay),
+						 validMovementFactor, normal)) {
+		normal = trans.rot * normal;
+		return true;
+	}
+	return false;
+}
+
+bool ConvexHull::SphereTestMovement(const Transform &trans,
+									float &validMovementFactor,
+									const Sphere &sph,
+									const RayInfo &movementRay,
+									glm::vec3 &normal) const
+{
+	const uint32_t n = GetPlanesCount();
+	if (n == 0) {
+		return false;
+	}
+	const float *p = data->planes;
+	glm::vec3 normals[MAX_PLANES];
+	float offsets[MAX_PLANES];
+	uint32_t count = 0;
+	for (uint32_t k = 0; k < n; ++k) {
+		if (p[n * 3 + k] != CONVEX_SOA_PAD_OFFSET) {
+			normals[count] = {p[k], p[n + k], p[n * 2 + k]};
+			offsets[count] = p[n * 3 + k];
+			++count;
+		}
+	}
+	if (SweptSphereTestConvex(normals, offsets, count, data->vertices,
+							  data->verticesCount, data->edges,
+							  data->edgesCount, sph.radius,
+							  trans.ToLocal(movementRay), validMovementFactor,
+							  normal)) {
+		normal = trans.rot * normal;
+		return true;
+	}
+	return false;
+}
+} // namespace Collision3D
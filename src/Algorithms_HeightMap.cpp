@@ -14,19 +14,11 @@ using namespace spp;
 
 HeightMap::HeightMap() : header(nullptr) {}
 
-HeightMap::~HeightMap()
-{
-	if (header) {
-		free(header);
-		header = nullptr;
-	}
-}
+HeightMap::~HeightMap() { Release(); }
 
 HeightMap::HeightMap(HeightMap &other)
+	: HeightMap((const HeightMap &)other)
 {
-	assert(!"Shouldn't be used");
-	header = nullptr;
-	CopyIntoThis(other);
 }
 
 HeightMap::HeightMap(HeightMap &&other) : header(other.header)
@@ -34,57 +26,67 @@ HeightMap::HeightMap(HeightMap &&other) : header(other.header)
 	other.header = nullptr;
 }
 
-HeightMap::HeightMap(const HeightMap &other)
+HeightMap::HeightMap(const HeightMap &other) : header(other.header)
 {
-	assert(!"Shouldn't be used");
-	header = nullptr;
-	CopyIntoThis(other);
+	if (header) {
+		header->references.fetch_add(1, std::memory_order_relaxed);
+	}
 }
 
 HeightMap &HeightMap::operator=(HeightMap &other)
 {
-	assert(!"Shouldn't be used");
-	CopyIntoThis(other);
+	return *this = (const HeightMap &)other;
 }
 
 HeightMap &HeightMap::operator=(HeightMap &&other)
 {
-	header = other.header;
-	other.header = nullptr;
+	if (this != &other) {
+		Release();
+		header = other.header;
+		other.header = nullptr;
+	}
 	return *this;
 }
 
 HeightMap &HeightMap::operator=(const HeightMap &other)
 {
-	assert(!"Shouldn't be used");
-	CopyIntoThis(other);
+	if (other.header) {
+		other.header->references.fetch_add(1, std::memory_order_relaxed);
+	}
+	Release();
+	header = other.header;
+	return *this;
 }
 
-void HeightMap::CopyIntoThis(const HeightMap &other)
+void HeightMap::Release()
 {
-	assert(!"Shouldn't be used");
-	this->~HeightMap();
-
-	if (other.header) {
-		header = (HeightMap_Header *)malloc(other.header->bytes);
-		memcpy(header, other.header, other.header->bytes);
-		size_t diff = ((size_t)header) - ((size_t)other.header);
-		*((size_t *)&(header->material)) += diff;
-		*((size_t *)&(header->heights)) += diff;
-	} else {
+	if (header) {
+		if (header->references.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+			HeightMap_Header::Free(header);
+		}
 		header = nullptr;
 	}
 }
 
+void HeightMap::MakeUnique()
+{
+	assert(header);
+	if (header->references.load(std::memory_order_acquire) > 1) {
+		HeightMap_Header *copy = header->Clone();
+		Release();
+		header = copy;
+	}
+}
+
 void HeightMap::Init(glm::ivec2 resolution)
 {
-	this->~HeightMap();
+	Release();
 	header = HeightMap_Header::Allocate(resolution);
 }
 
 void HeightMap::InitMeta(float horizontalScale, float verticalScale)
 {
-	assert(header);
+	MakeUnique();
 	header->InitMeta(horizontalScale, verticalScale);
 }
 
@@ -108,6 +110,34 @@ bool HeightMap::RayTestLocal(const RayInfo &ray, float &near,
 	return header->RayTestLocal(ray, near, normal);
 }
 
+bool HeightMap::OcclusionTest(const Transform &trans, const RayInfo &ray) const
+{
+	assert(header);
+	return header->OcclusionTest(trans, ray);
+}
+
+void HeightMap::RayTestAll(const Transform &trans, const RayInfo &ray,
+						   RayHitBuffer &hits) const
+{
+	assert(header);
+	header->RayTestAll(trans, ray, hits);
+}
+
+bool HeightMap::OverlapTest(const Transform &trans,
+							const OverlapVolume &volume) const
+{
+	assert(header);
+	return header->OverlapTest(trans, volume);
+}
+
+uint32_t HeightMap::OverlapAll(const Transform &trans,
+							   const OverlapVolume &volume, uint32_t *ids,
+							   uint32_t maxIds) const
+{
+	assert(header);
+	return header->OverlapAll(trans, volume, ids, maxIds);
+}
+
 bool HeightMap::CylinderTestOnGround(const Transform &trans,
 									 const Cylinder &cyl, glm::vec3 pos,
 									 float &offsetHeight,
@@ -130,9 +160,20 @@ bool HeightMap::CylinderTestMovement(const Transform &trans,
 										movementRay, normal);
 }
 
-bool HeightMap::Update(glm::ivec2 coord, Type value)
+bool HeightMap::SphereTestMovement(const Transform &trans,
+								   float &validMovementFactor,
+								   const Sphere &sph,
+								   const RayInfo &movementRay,
+								   glm::vec3 &normal) const
 {
 	assert(header);
+	return header->SphereTestMovement(trans, validMovementFactor, sph,
+									  movementRay, normal);
+}
+
+bool HeightMap::Update(glm::ivec2 coord, Type value)
+{
+	MakeUnique();
 	return header->Update(coord, value);
 }
 
@@ -144,7 +185,7 @@ HeightMap::Type HeightMap::Get(glm::ivec2 coord) const
 
 bool HeightMap::SetMaterial(glm::ivec2 coord, MaterialType value)
 {
-	assert(header);
+	MakeUnique();
 	return header->SetMaterial(coord, value);
 }
 
@@ -169,7 +210,7 @@ const HeightMap::Type *HeightMap::GetHeights() const
 
 HeightMap::Type *HeightMap::AccessHeights()
 {
-	assert(header);
+	MakeUnique();
 	return header->heights;
 }
 
@@ -181,9 +222,15 @@ const HeightMap::MaterialType *HeightMap::GetMaterial() const
 
 HeightMap::MaterialType *HeightMap::AccessMaterial()
 {
-	assert(header);
+	MakeUnique();
 	return header->material;
 }
 
 bool HeightMap::IsValid() const { return header; }
+
+bool HeightMap::IsShared() const
+{
+	return header &&
+		   header->references.load(std::memory_order_relaxed) > 1;
+}
 } // namespace Collision3D
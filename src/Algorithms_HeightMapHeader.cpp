@@ -9,8 +9,10 @@
 #include <cstdlib>
 
 #include <limits>
+#include <new>
 
 #include "../include/collision3d/CollisionShapes_HeightMapHeader.hpp"
+#include "../include/collision3d/CollisionShapes_Primitives.hpp"
 
 namespace Collision3D
 {
@@ -18,9 +20,6 @@ using namespace spp;
 
 HeightMap_Header *HeightMap_Header::Allocate(glm::ivec2 resolution)
 {
-	HeightMap_Header header;
-	memset(&header, 0, sizeof(HeightMap_Header));
-	header.resolution = resolution;
 	size_t bytes = sizeof(HeightMap_Header);
 	size_t offsetHeight = bytes;
 	bytes += (resolution.x * resolution.y) * sizeof(Type);
@@ -28,12 +27,36 @@ HeightMap_Header *HeightMap_Header::Allocate(glm::ivec2 resolution)
 	bytes += (resolution.x * resolution.y) * sizeof(MaterialType);
 
 	void *ptr = malloc(bytes);
-	HeightMap_Header *ret = new (ptr) HeightMap_Header(header);
+	memset(ptr, 0, sizeof(HeightMap_Header));
+	HeightMap_Header *ret = new (ptr) HeightMap_Header();
+	ret->bytes = bytes;
+	ret->references = 1;
+	ret->resolution = resolution;
 	ret->heights = (Type *)((size_t)ptr + offsetHeight);
 	ret->material = (MaterialType *)((size_t)ptr + offsetMaterial);
 	return ret;
 }
 
+HeightMap_Header *HeightMap_Header::Clone() const
+{
+	HeightMap_Header *ret = Allocate(resolution);
+	ret->size = size;
+	ret->scale = scale;
+	ret->invScale = invScale;
+	ret->maxDh1 = maxDh1;
+	ret->maxDh11 = maxDh11;
+	const size_t count = resolution.x * resolution.y;
+	memcpy(ret->heights, heights, count * sizeof(Type));
+	memcpy(ret->material, material, count * sizeof(MaterialType));
+	return ret;
+}
+
+void HeightMap_Header::Free(HeightMap_Header *header)
+{
+	header->~HeightMap_Header();
+	free(header);
+}
+
 glm::ivec2 HeightMap_Header::ConvertGlobalPosToCoord(const Transform &trans,
 													 glm::vec2 pos2d) const
 {
@@ -135,61 +158,142 @@ bool HeightMap_Header::RayTest(const Transform &trans, const RayInfo &ray,
 bool HeightMap_Header::RayTestLocal(const RayInfo &_ray, float &near,
 									glm::vec3 &normal) const
 {
-	RayInfo ray = _ray;
+	const RayInfo ray = ToGridRay(_ray);
+
+	near = 1.0f;
+
+	if (!RayTestGridAnyDirection(ray, near, normal, nullptr)) {
+		return false;
+	}
+	normal *= invScale;
+	normal = glm::normalize(normal);
+	return true;
+}
+
+void HeightMap_Header::RayTestAll(const Transform &trans, const RayInfo &ray,
+								  RayHitBuffer &hits) const
+{
+	AllHits all{hits, trans.rot};
+	float near = 1.0f;
+	glm::vec3 normal;
+	RayTestGridAnyDirection(ToGridRay(trans.ToLocal(ray)), near, normal, &all);
+}
+
+bool HeightMap_Header::OverlapTest(const Transform &trans,
+								   const OverlapVolume &volume) const
+{
+	uint32_t id;
+	return OverlapAll(trans, volume, &id, 1) != 0;
+}
+
+// Each triangle of cell is extruded down to Y=0 into convex prism
+uint32_t HeightMap_Header::OverlapAll(const Transform &trans,
+									  const OverlapVolume &volume,
+									  uint32_t *ids, uint32_t maxIds) const
+{
+	const OverlapVolume local = volume.ToLocal(trans);
+	const spp::Aabb aabb = local.GetAabb();
+	if (maxIds == 0 || aabb.max.y < 0.0f) {
+		return 0;
+	}
+
+	const int x0 = glm::max<int>(floor(aabb.min.x * invScale.x), 0);
+	const int z0 = glm::max<int>(floor(aabb.min.z * invScale.z), 0);
+	const int x1 =
+		glm::min<int>(floor(aabb.max.x * invScale.x), resolution.x - 2);
+	const int z1 =
+		glm::min<int>(floor(aabb.max.z * invScale.z), resolution.y - 2);
+
+	uint32_t found = 0;
+	for (int z = z0; z <= z1; ++z) {
+		for (int x = x0; x <= x1; ++x) {
+			const size_t id = Id<false>({x, z});
+			const float h00 = heights[id] * scale.y;
+			const float h10 = heights[id + 1] * scale.y;
+			const float h01 = heights[id + resolution.x] * scale.y;
+			const float h11 = heights[id + resolution.x + 1] * scale.y;
+			const float maxy = glm::max(glm::max(h00, h01), glm::max(h10, h11));
+			if (maxy < aabb.min.y) {
+				continue;
+			}
+
+			const float x0f = x * scale.x, x1f = (x + 1) * scale.x;
+			const float z0f = z * scale.z, z1f = (z + 1) * scale.z;
+			const glm::vec3 upper[6] = {{x0f, 0, z0f}, {x0f, 0, z1f},
+										{x1f, 0, z1f}, {x0f, h00, z0f},
+										{x0f, h01, z1f}, {x1f, h11, z1f}};
+			const glm::vec3 lower[6] = {{x0f, 0, z0f}, {x1f, 0, z0f},
+										{x1f, 0, z1f}, {x0f, h00, z0f},
+										{x1f, h10, z0f}, {x1f, h11, z1f}};
+			if (OverlapTestConvex(upper, 6, 0.0f, local) ||
+				OverlapTestConvex(lower, 6, 0.0f, local)) {
+				ids[found++] = (uint32_t)id;
+				if (found >= maxIds) {
+					return found;
+				}
+			}
+		}
+	}
+	return found;
+}
+
+RayInfo HeightMap_Header::ToGridRay(const RayInfo &localRay) const
+{
+	RayInfo ray = localRay;
 
-	ray.dir *= scale;
-	ray.dir *= scale;
+	ray.dir *= invScale;
 	ray.length = glm::length(ray.dir);
 	ray.start *= invScale;
 	ray.end *= invScale;
 	ray.dirNormalized = ray.dir / ray.length;
 
 	assert(glm::distance(ray.end, ray.start + ray.dir) < 0.001f);
+	return ray;
+}
 
-	near = 1.0f;
-
+bool HeightMap_Header::RayTestGridAnyDirection(const RayInfo &ray, float &near,
+											   glm::vec3 &normal,
+											   AllHits *all) const
+{
 	if (ray.dir.x > 0) {
 		if (ray.dir.z > 0) {
-			if (!RayTestGrid<1, 1>(ray, near, normal))
-				return false;
+			return RayTestGrid<1, 1>(ray, near, normal, all);
 		} else if (ray.dir.z == 0) {
-			if (!RayTestGrid<1, 0>(ray, near, normal))
-				return false;
+			return RayTestGrid<1, 0>(ray, near, normal, all);
 		} else {
-			if (!RayTestGrid<1, -1>(ray, near, normal))
-				return false;
+			return RayTestGrid<1, -1>(ray, near, normal, all);
 		}
 	} else if (ray.dir.x == 0) {
 		if (ray.dir.z > 0) {
-			if (!RayTestGrid<0, 1>(ray, near, normal))
-				return false;
+			return RayTestGrid<0, 1>(ray, near, normal, all);
 		} else if (ray.dir.z == 0) {
-			if (!RayTestGrid<0, 0>(ray, near, normal))
-				return false;
+			return RayTestGrid<0, 0>(ray, near, normal, all);
 		} else {
-			if (!RayTestGrid<0, -1>(ray, near, normal))
-				return false;
+			return RayTestGrid<0, -1>(ray, near, normal, all);
 		}
 	} else {
 		if (ray.dir.z > 0) {
-			if (!RayTestGrid<-1, 1>(ray, near, normal))
-				return false;
+			return RayTestGrid<-1, 1>(ray, near, normal, all);
 		} else if (ray.dir.z == 0) {
-			if (!RayTestGrid<-1, 0>(ray, near, normal))
-				return false;
+			return RayTestGrid<-1, 0>(ray, near, normal, all);
 		} else {
-			if (!RayTestGrid<-1, -1>(ray, near, normal))
-				return false;
+			return RayTestGrid<-1, -1>(ray, near, normal, all);
 		}
 	}
-	normal *= scale;
-	normal = glm::normalize(normal);
-	return true;
+}
+
+// Cells are visited in order along ray, so the first hit is also the nearest
+bool HeightMap_Header::OcclusionTest(const Transform &trans,
+									 const RayInfo &ray) const
+{
+	float near;
+	glm::vec3 normal;
+	return RayTestLocal(trans.ToLocal(ray), near, normal);
 }
 
 template <int DIR_SIGN_X, int DIR_SIGN_Z>
 bool HeightMap_Header::RayTestGrid(const RayInfo &ray, float &near,
-								   glm::vec3 &normal) const
+								   glm::vec3 &normal, AllHits *all) const
 {
 	float dx = ray.dir.x;
 	float dz = ray.dir.z;
@@ -230,12 +334,12 @@ bool HeightMap_Header::RayTestGrid(const RayInfo &ray, float &near,
 	bool stopIterating = false;
 	if (n == 0) {
 		return RayTestCell<DIR_SIGN_X, DIR_SIGN_Z>(ray, near, normal, x, z,
-												   stopIterating);
+												   stopIterating, all);
 	}
 
 	for (; n > 0; --n) {
 		if (RayTestCell<DIR_SIGN_X, DIR_SIGN_Z>(ray, near, normal, x, z,
-												stopIterating)) {
+												stopIterating, all)) {
 			return true;
 		}
 		if (stopIterating) {
@@ -256,7 +360,7 @@ bool HeightMap_Header::RayTestGrid(const RayInfo &ray, float &near,
 template <int DIR_SIGN_X, int DIR_SIGN_Z>
 bool HeightMap_Header::RayTestCell(const RayInfo &ray, float &near,
 								   glm::vec3 &normal, int x, int z,
-								   bool &stopIterating) const
+								   bool &stopIterating, AllHits *all) const
 {
 	if (!IsValidCell({x, z})) {
 		return false;
@@ -284,10 +388,11 @@ bool HeightMap_Header::RayTestCell(const RayInfo &ray, float &near,
 		float a = (z - ray.start.z) / ray.dir.z;
 		float b = (z + 1 - ray.start.z) / ray.dir.z;
 		t1 = glm::max(t1, glm::min(a, b));
-		t2 = glm::min(t1, glm::max(a, b));
+		t2 = glm::min(t2, glm::max(a, b));
 	}
 
-	if (t1 > 1.001f) {
+	// Cells further along ray can not give hits nearer than full buffer has
+	if (t1 > 1.001f || (all && t1 > all->hits.CutFactor())) {
 		stopIterating = true;
 		return false;
 	}
@@ -303,6 +408,20 @@ bool HeightMap_Header::RayTestCell(const RayInfo &ray, float &near,
 	}
 #endif
 
+	if (all) {
+		float n;
+		glm::vec3 no;
+		if (TriangleRayTest<true>(h00, h01, h11, x, z, ray, n, no)) {
+			all->hits.Add({n, all->rot * glm::normalize(no * invScale),
+						   (uint32_t)id});
+		}
+		if (TriangleRayTest<false>(h00, h10, h11, x, z, ray, n, no)) {
+			all->hits.Add({n, all->rot * glm::normalize(no * invScale),
+						   (uint32_t)id});
+		}
+		return false;
+	}
+
 	bool res = TriangleRayTest<true>(h00, h01, h11, x, z, ray, near, normal);
 	float n;
 	glm::vec3 no;
@@ -344,7 +463,8 @@ bool HeightMap_Header::TriangleRayTest(Type h00, Type hxy, Type h11, int x,
 	const float d = 1.0f / glm::dot(localRay.dir, n);
 	const float t = d * glm::dot(-n, rov0);
 
-	const glm::vec3 hp = localRay.start + localRay.dir * t;
+	// hit point relative to v0
+	const glm::vec3 hp = rov0 + localRay.dir * t;
 
 	if constexpr (TOP_ELSE_DOWN) {
 		if (hp.x < 0.0f || 1.0f < hp.z || (hp.x - hp.z) > 0.0f) {
@@ -361,7 +481,8 @@ bool HeightMap_Header::TriangleRayTest(Type h00, Type hxy, Type h11, int x,
 	}
 
 	near = t;
-	normal = n;
+	// n of lower triangle points down
+	normal = TOP_ELSE_DOWN ? n : -n;
 	return true;
 }
 
@@ -468,6 +589,89 @@ bool HeightMap_Header::CylinderTestMovement(const Transform &trans,
 	}
 }
 
+bool HeightMap_Header::SphereTestMovement(const Transform &trans,
+										  float &validMovementFactor,
+										  const Sphere &sph,
+										  const RayInfo &movementRay,
+										  glm::vec3 &normal) const
+{
+	const float r = sph.radius;
+	const RayInfo ray = trans.ToLocal(movementRay);
+	const glm::vec3 end = ray.start + ray.dir;
+	const glm::vec3 min = glm::min(ray.start, end) - r;
+	const glm::vec3 max = glm::max(ray.start, end) + r;
+
+	const int x0 = glm::max<int>(floor(min.x * invScale.x), 0);
+	const int z0 = glm::max<int>(floor(min.z * invScale.z), 0);
+	const int x1 = glm::min<int>(floor(max.x * invScale.x), resolution.x - 2);
+	const int z1 = glm::min<int>(floor(max.z * invScale.z), resolution.y - 2);
+
+	// cells further from 2d segment than this can not be touched
+	const float cellRadius =
+		r + 0.5f * sqrt(scale.x * scale.x + scale.z * scale.z);
+	const glm::vec2 s2{ray.start.x, ray.start.z};
+	const glm::vec2 d2{ray.dir.x, ray.dir.z};
+	const float dd2 = glm::dot(d2, d2);
+
+	bool res = false;
+	float near = 1.0f;
+	float ne;
+	glm::vec3 no;
+	for (int z = z0; z <= z1; ++z) {
+		for (int x = x0; x <= x1; ++x) {
+			const glm::vec2 center =
+				glm::vec2{x + 0.5f, z + 0.5f} * glm::vec2{scale.x, scale.z};
+			const float f =
+				dd2 > 0.0f
+					? glm::clamp(glm::dot(center - s2, d2) / dd2, 0.0f, 1.0f)
+					: 0.0f;
+			const glm::vec2 dc = s2 + d2 * f - center;
+			if (glm::dot(dc, dc) > cellRadius * cellRadius) {
+				continue;
+			}
+
+			const size_t id = Id<false>({x, z});
+			const float h00 = heights[id] * scale.y;
+			const float h10 = heights[id + 1] * scale.y;
+			const float h01 = heights[id + resolution.x] * scale.y;
+			const float h11 = heights[id + resolution.x + 1] * scale.y;
+			const float miny = glm::min(glm::min(h00, h01), glm::min(h10, h11));
+			const float maxy = glm::max(glm::max(h00, h01), glm::max(h10, h11));
+			if (maxy < min.y || miny > max.y) {
+				continue;
+			}
+
+			const float x0f = x * scale.x, x1f = (x + 1) * scale.x;
+			const float z0f = z * scale.z, z1f = (z + 1) * scale.z;
+			const glm::vec3 v00{x0f, h00, z0f};
+			const glm::vec3 v11{x1f, h11, z1f};
+			if (SweptSphereTestTriangle(v00, {x0f, h01, z1f}, v11, r, ray, ne,
+										no)) {
+				if (res == false || ne < near) {
+					near = ne;
+					normal = no;
+					res = true;
+				}
+			}
+			if (SweptSphereTestTriangle(v00, {x1f, h10, z0f}, v11, r, ray, ne,
+										no)) {
+				if (res == false || ne < near) {
+					near = ne;
+					normal = no;
+					res = true;
+				}
+			}
+		}
+	}
+	if (res) {
+		validMovementFactor = near;
+		normal = trans.rot * normal;
+	} else {
+		validMovementFactor = 1.0f;
+	}
+	return res;
+}
+
 template HeightMap_Header::Type
 HeightMap_Header::Get<true>(glm::ivec2 coord) const;
 template HeightMap_Header::Type
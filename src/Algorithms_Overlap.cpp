@@ -0,0 +1,274 @@
+// This file is part of Collision3D.
+// Copyright (c) 2025 Marek Zalewski aka Drwalin
+// You should have received a copy of the MIT License along with this program.
+
+#include "../include/collision3d/CollisionShapes_Primitives.hpp"
+
+namespace Collision3D
+{
+using namespace spp;
+
+OverlapVolume OverlapVolume::FromAabb(const spp::Aabb &aabb)
+{
+	OverlapVolume v;
+	v.pos = (aabb.min + aabb.max) * 0.5f;
+	v.halfExtents = (aabb.max - aabb.min) * 0.5f;
+	v.radius = 0.0f;
+	v.height = 0.0f;
+	v.rot = {};
+	v.type = BOX;
+	return v;
+}
+
+OverlapVolume OverlapVolume::FromCylinder(const Cylinder &cyl, glm::vec3 pos)
+{
+	OverlapVolume v;
+	v.pos = pos;
+	v.halfExtents = {0, 0, 0};
+	v.radius = cyl.radius;
+	v.height = cyl.height;
+	v.rot = {};
+	v.type = CYLINDER;
+	return v;
+}
+
+OverlapVolume OverlapVolume::FromSphere(const Sphere &sph, glm::vec3 pos)
+{
+	OverlapVolume v;
+	v.pos = pos;
+	v.halfExtents = {0, 0, 0};
+	v.radius = sph.radius;
+	v.height = 0.0f;
+	v.rot = {};
+	v.type = SPHERE;
+	return v;
+}
+
+OverlapVolume OverlapVolume::ToLocal(const Transform &trans) const
+{
+	OverlapVolume v = *this;
+	v.pos = trans.ToLocal(pos);
+	v.rot = rot - trans.rot;
+	return v;
+}
+
+spp::Aabb OverlapVolume::GetAabb() const
+{
+	switch (type) {
+	case BOX: {
+		const glm::vec2 cs = rot.GetVec2();
+		const glm::vec3 e = {
+			glm::abs(cs.x) * halfExtents.x + glm::abs(cs.y) * halfExtents.z,
+			halfExtents.y,
+			glm::abs(cs.y) * halfExtents.x + glm::abs(cs.x) * halfExtents.z};
+		return {pos - e, pos + e};
+	}
+	case CYLINDER:
+		return {pos - glm::vec3{radius, 0, radius},
+				pos + glm::vec3{radius, height, radius}};
+	default:
+		return {pos - radius, pos + radius};
+	}
+}
+
+glm::vec3 OverlapVolume::Support(glm::vec3 dir) const
+{
+	switch (type) {
+	case BOX: {
+		const glm::vec3 d = rot.ToLocal(dir);
+		const glm::vec3 s = {d.x < 0.0f ? -halfExtents.x : halfExtents.x,
+							 d.y < 0.0f ? -halfExtents.y : halfExtents.y,
+							 d.z < 0.0f ? -halfExtents.z : halfExtents.z};
+		return pos + rot * s;
+	}
+	case CYLINDER: {
+		const float len = glm::length(glm::vec2{dir.x, dir.z});
+		const float f = len > 0.0f ? radius / len : 0.0f;
+		return pos + glm::vec3{dir.x * f, dir.y > 0.0f ? height : 0.0f,
+							   dir.z * f};
+	}
+	default: {
+		const float len = glm::length(dir);
+		return len > 0.0f ? pos + dir * (radius / len) : pos;
+	}
+	}
+}
+
+// Boolean GJK, searches for simplex of Minkowski difference A - B enclosing
+// origin. Simplex is stored with the newest point last, directions are kept
+// normalized.
+namespace
+{
+constexpr int GJK_MAX_ITERATIONS = 64;
+
+struct Simplex {
+	glm::vec3 p[4];
+	int count = 0;
+};
+
+// Direction perpendicular to line a-b, towards origin
+inline glm::vec3 LineDirection(glm::vec3 a, glm::vec3 b)
+{
+	const glm::vec3 ab = b - a;
+	return glm::cross(glm::cross(ab, -a), ab);
+}
+
+// Reduces simplex to feature nearest to origin and sets direction towards
+// it. Returns true when origin is enclosed or lies on the simplex.
+bool DoSimplex(Simplex &s, glm::vec3 &d)
+{
+	switch (s.count) {
+	case 2: {
+		const glm::vec3 a = s.p[1], b = s.p[0];
+		if (glm::dot(b - a, -a) > 0.0f) {
+			d = LineDirection(a, b);
+		} else {
+			s.p[0] = a;
+			s.count = 1;
+			d = -a;
+		}
+		break;
+	}
+	case 3: {
+		const glm::vec3 a = s.p[2], b = s.p[1], c = s.p[0];
+		const glm::vec3 ab = b - a, ac = c - a, ao = -a;
+		const glm::vec3 abc = glm::cross(ab, ac);
+		if (glm::dot(glm::cross(abc, ac), ao) > 0.0f) {
+			if (glm::dot(ac, ao) > 0.0f) {
+				s.p[1] = a;
+				s.count = 2;
+				d = LineDirection(a, c);
+			} else if (glm::dot(ab, ao) > 0.0f) {
+				s.p[0] = b;
+				s.p[1] = a;
+				s.count = 2;
+				d = LineDirection(a, b);
+			} else {
+				s.p[0] = a;
+				s.count = 1;
+				d = ao;
+			}
+		} else if (glm::dot(glm::cross(ab, abc), ao) > 0.0f) {
+			if (glm::dot(ab, ao) > 0.0f) {
+				s.p[0] = b;
+				s.p[1] = a;
+				s.count = 2;
+				d = LineDirection(a, b);
+			} else {
+				s.p[0] = a;
+				s.count = 1;
+				d = ao;
+			}
+		} else if (glm::dot(abc, ao) >= 0.0f) {
+			d = abc;
+		} else {
+			s.p[0] = b;
+			s.p[1] = c;
+			d = -abc;
+		}
+		break;
+	}
+	case 4: {
+		const glm::vec3 a = s.p[3];
+		// faces containing a, each with opposite vertex
+		const int faces[3][3] = {{2, 1, 0}, {1, 0, 2}, {0, 2, 1}};
+		for (const auto &f : faces) {
+			const glm::vec3 b = s.p[f[0]], c = s.p[f[1]];
+			glm::vec3 n = glm::cross(b - a, c - a);
+			if (glm::dot(n, s.p[f[2]] - a) > 0.0f) {
+				n = -n;
+			}
+			if (glm::dot(n, -a) > 0.0f) {
+				s.p[0] = c;
+				s.p[1] = b;
+				s.p[2] = a;
+				s.count = 3;
+				return DoSimplex(s, d);
+			}
+		}
+		return true;
+	}
+	}
+	const float len = glm::length(d);
+	if (len < 1e-12f) {
+		return true;
+	}
+	d /= len;
+	return false;
+}
+
+template <typename SA>
+bool GjkOverlap(const SA &supportA, glm::vec3 centerA,
+				const OverlapVolume &volume)
+{
+	auto support = [&](glm::vec3 d) {
+		return supportA(d) - volume.Support(-d);
+	};
+	glm::vec3 d = volume.pos - centerA;
+	if (glm::dot(d, d) < 1e-12f) {
+		d = {1, 0, 0};
+	}
+	d = glm::normalize(d);
+	Simplex s;
+	s.p[0] = support(d);
+	s.count = 1;
+	d = -s.p[0];
+	const float len = glm::length(d);
+	if (len < 1e-12f) {
+		return true;
+	}
+	d /= len;
+	for (int i = 0; i < GJK_MAX_ITERATIONS; ++i) {
+		const glm::vec3 a = support(d);
+		if (glm::dot(a, d) < 0.0f) {
+			return false;
+		}
+		s.p[s.count++] = a;
+		if (DoSimplex(s, d)) {
+			return true;
+		}
+	}
+	// Not converged, rounded shapes nearly touching may need many iterations
+	return true;
+}
+} // namespace
+
+bool OverlapTestConvex(const glm::vec3 *vertices, int verticesCount,
+					   float radius, const OverlapVolume &volume)
+{
+	glm::vec3 center = vertices[0];
+	for (int i = 1; i < verticesCount; ++i) {
+		center += vertices[i];
+	}
+	center /= (float)verticesCount;
+	return GjkOverlap(
+		[&](glm::vec3 d) {
+			glm::vec3 best = vertices[0];
+			float bestDot = glm::dot(best, d);
+			for (int i = 1; i < verticesCount; ++i) {
+				const float dt = glm::dot(vertices[i], d);
+				if (dt > bestDot) {
+					bestDot = dt;
+					best = vertices[i];
+				}
+			}
+			return best + d * radius;
+		},
+		center, volume);
+}
+
+bool OverlapTestCone(float height, float bottomRadius, float topRadius,
+					 const OverlapVolume &volume)
+{
+	return GjkOverlap(
+		[&](glm::vec3 d) {
+			const float len = glm::length(glm::vec2{d.x, d.z});
+			const glm::vec2 u =
+				len > 0.0f ? glm::vec2{d.x, d.z} / len : glm::vec2{0, 0};
+			const glm::vec3 bottom = {u.x * bottomRadius, 0, u.y * bottomRadius};
+			const glm::vec3 top = {u.x * topRadius, height, u.y * topRadius};
+			return glm::dot(bottom, d) > glm::dot(top, d) ? bottom : top;
+		},
+		{0, height * 0.5f, 0}, volume);
+}
+} // namespace Collision3D
@@ -0,0 +1,461 @@
+// This file is part of Collision3D.
+// Copyright (c) 2025 Marek Zalewski aka Drwalin
+// You should have received a copy of the MIT License along with this program.
+
+#include <cstring>
+#include <new>
+
+#include "../include/collision3d/CollisionShapes_AnyOrCompound.hpp"
+
+namespace Collision3D
+{
+using namespace spp;
+
+#define CODE_PACK_DIMS(SHAPE, NAME, INDEX, DEREF)                              \
+	static_assert(sizeof(SHAPE) <= sizeof(dims));                              \
+	memcpy(dims, &primitive.NAME, sizeof(SHAPE));
+
+void PackedPrimitive::Encode(const AnyPrimitive &primitive, glm::vec3 origin,
+							 glm::vec3 invScale)
+{
+	for (int i = 0; i < 3; ++i) {
+		const float q =
+			glm::floor((primitive.pos[i] - origin[i]) * invScale[i] + 0.5f);
+		pos[i] = (int16_t)(glm::clamp(q, 0.0f, 65535.0f) - 32768.0f);
+	}
+
+	float dims[4] = {0, 0, 0, 0};
+	switch (primitive.type) {
+	case AnyPrimitive::INVALID:
+		break;
+		EACH_PRIMITIVE(AnyPrimitive, SWITCH_CASES, CODE_PACK_DIMS);
+	}
+	for (int i = 0; i < 4; ++i) {
+		this->dims[i] = FloatToHalf(dims[i]);
+	}
+
+	typeRot = primitive.rot.value | ((uint16_t)primitive.type << 8);
+}
+
+#define CODE_UNPACK_DIMS(SHAPE, NAME, INDEX, DEREF)                            \
+	memcpy(&p.NAME, dims, sizeof(SHAPE));
+
+AnyPrimitive PackedPrimitive::Decode(glm::vec3 origin, glm::vec3 scale) const
+{
+	AnyPrimitive p;
+	p.type = (AnyPrimitive::Type)(typeRot >> 8);
+	p.rot.value = typeRot & 0xFF;
+	for (int i = 0; i < 3; ++i) {
+		p.pos[i] = origin[i] + (float(pos[i]) + 32768.0f) * scale[i];
+	}
+
+	float dims[4];
+	for (int i = 0; i < 4; ++i) {
+		dims[i] = HalfToFloat(this->dims[i]);
+	}
+	switch (p.type) {
+	case AnyPrimitive::INVALID:
+		break;
+		EACH_PRIMITIVE(AnyPrimitive, SWITCH_CASES, CODE_UNPACK_DIMS);
+	}
+	return p;
+}
+
+PackedCompound::PackedCompound(const CompoundPrimitive &compound,
+							   BvhNodeFormat format, BvhBuilder builder)
+{
+	const uint32_t count = compound.primitives.size;
+	if (count == 0) {
+		return;
+	}
+
+	glm::vec3 min = compound.primitives[0].pos, max = min;
+	for (const auto &p : compound.primitives) {
+		min = glm::min(min, p.pos);
+		max = glm::max(max, p.pos);
+	}
+	origin = min;
+	glm::vec3 invScale;
+	for (int i = 0; i < 3; ++i) {
+		const float ext = max[i] - min[i];
+		scale[i] = ext > 0.0f ? ext / 65535.0f : 1.0f;
+		invScale[i] = 1.0f / scale[i];
+	}
+
+	primitives.resize(count);
+	masks.resize(count);
+	for (uint32_t i = 0; i < count; ++i) {
+		primitives[i].Encode(compound.primitives[i], origin, invScale);
+		masks[i] = compound.primitives[i].layerMask;
+	}
+
+	if (count >= 12) {
+		std::vector<spp::Aabb> aabbs(count);
+		for (uint32_t i = 0; i < count; ++i) {
+			aabbs[i] = Get(i).GetAabb({});
+		}
+		compactBvh = new CompactBvh();
+		compactBvh->Build(aabbs.data(), count, format, builder, masks.data());
+	}
+}
+
+PackedCompound::~PackedCompound()
+{
+	if (compactBvh) {
+		delete compactBvh;
+		compactBvh = nullptr;
+	}
+}
+
+PackedCompound::PackedCompound(PackedCompound &other)
+	: PackedCompound((const PackedCompound &)other)
+{
+}
+
+PackedCompound::PackedCompound(PackedCompound &&other)
+	: primitives(std::move(other.primitives)), masks(std::move(other.masks)),
+	  origin(other.origin), scale(other.scale), compactBvh(other.compactBvh)
+{
+	other.compactBvh = nullptr;
+}
+
+PackedCompound::PackedCompound(const PackedCompound &other)
+	: primitives(other.primitives), masks(other.masks), origin(other.origin),
+	  scale(other.scale)
+{
+	if (other.compactBvh) {
+		compactBvh = new CompactBvh(*other.compactBvh);
+	}
+}
+
+PackedCompound &PackedCompound::operator=(PackedCompound &other)
+{
+	return *this = (const PackedCompound &)other;
+}
+
+PackedCompound &PackedCompound::operator=(PackedCompound &&other)
+{
+	if (this != &other) {
+		this->~PackedCompound();
+		new (this) PackedCompound(std::move(other));
+	}
+	return *this;
+}
+
+PackedCompound &PackedCompound::operator=(const PackedCompound &other)
+{
+	if (this != &other) {
+		this->~PackedCompound();
+		new (this) PackedCompound(other);
+	}
+	return *this;
+}
+
+spp::Aabb PackedCompound::GetAabb(const Transform &trans) const
+{
+	if (compactBvh) {
+		// Rotation is only around y, transforming 4 corners is enough
+		const spp::Aabb local = compactBvh->GetTotalAabb();
+		spp::Aabb aabb = spp::AABB_INVALID;
+		for (int i = 0; i < 4; ++i) {
+			const glm::vec3 corner = {i & 1 ? local.max.x : local.min.x, 0,
+									  i & 2 ? local.max.z : local.min.z};
+			const glm::vec3 p = trans * corner;
+			aabb = aabb + spp::Aabb{p, p};
+		}
+		aabb.min.y = local.min.y + trans.pos.y;
+		aabb.max.y = local.max.y + trans.pos.y;
+		return aabb;
+	}
+	spp::Aabb aabb = spp::AABB_INVALID;
+	for (uint32_t i = 0; i < primitives.size(); ++i) {
+		aabb = aabb + Get(i).GetAabb(trans);
+	}
+	return aabb;
+}
+
+bool PackedCompound::RayTest(const Transform &trans, const RayInfo &ray,
+							 float &near, glm::vec3 &normal) const
+{
+	return RayTest(trans, ray, near, normal, LAYER_MASK_ALL);
+}
+
+bool PackedCompound::RayTestLocal(const RayInfo &ray, float &near,
+								  glm::vec3 &normal) const
+{
+	return RayTestLocal(ray, near, normal, LAYER_MASK_ALL);
+}
+
+bool PackedCompound::OcclusionTest(const Transform &trans,
+								   const RayInfo &ray) const
+{
+	return OcclusionTest(trans, ray, LAYER_MASK_ALL);
+}
+
+bool PackedCompound::OverlapTest(const Transform &trans,
+								 const OverlapVolume &volume) const
+{
+	return OverlapTest(trans, volume, LAYER_MASK_ALL);
+}
+
+bool PackedCompound::CylinderTestOnGround(const Transform &trans,
+										  const Cylinder &cyl, glm::vec3 pos,
+										  float &offsetHeight,
+										  glm::vec3 *onGroundNormal,
+										  bool *isOnEdge) const
+{
+	return CylinderTestOnGround(trans, cyl, pos, offsetHeight, onGroundNormal,
+								isOnEdge, LAYER_MASK_ALL);
+}
+
+bool PackedCompound::CylinderTestMovement(const Transform &trans,
+										  float &validMovementFactor,
+										  const Cylinder &cyl,
+										  const RayInfo &movementRay,
+										  glm::vec3 &normal) const
+{
+	return CylinderTestMovement(trans, validMovementFactor, cyl, movementRay,
+								normal, LAYER_MASK_ALL);
+}
+
+bool PackedCompound::RayTest(const Transform &trans, const RayInfo &ray,
+							 float &near, glm::vec3 &normal,
+							 LayerMask queryMask) const
+{
+	if (RayTestLocal(trans.ToLocal(ray), near, normal, queryMask)) {
+		normal = trans.rot * normal;
+		return true;
+	} else {
+		return false;
+	}
+}
+
+bool PackedCompound::RayTestLocal(const RayInfo &ray, float &near,
+								  glm::vec3 &normal, LayerMask queryMask) const
+{
+	bool res = false;
+	float cutFactor = 1.0f;
+	auto test = [&](uint32_t id, float &cut) -> bool {
+		if ((masks[id] & queryMask) == 0) {
+			return false;
+		}
+		float ne;
+		glm::vec3 no;
+		if (Get(id).RayTestLocal(ray, ne, no)) {
+			if (ne < 0.0f) {
+				ne = 0.0f;
+			}
+			if (ne <= cut) {
+				normal = no;
+				cut = ne;
+				res = true;
+			}
+		}
+		return false;
+	};
+	if (compactBvh) {
+		compactBvh->IntersectRay(ray, cutFactor, test, queryMask);
+	} else {
+		for (uint32_t i = 0; i < primitives.size(); ++i) {
+			test(i, cutFactor);
+		}
+	}
+	near = cutFactor;
+	return res;
+}
+
+bool PackedCompound::OcclusionTest(const Transform &trans,
+								   const RayInfo &ray,
+								   LayerMask queryMask) const
+{
+	const RayInfo localRay = trans.ToLocal(ray);
+	bool res = false;
+	auto test = [&](uint32_t id, float &) -> bool {
+		if ((masks[id] & queryMask) != 0) {
+			res = Get(id).OcclusionTest({}, localRay);
+		}
+		return res;
+	};
+	float cutFactor = 1.0f;
+	if (compactBvh) {
+		compactBvh->IntersectRay(localRay, cutFactor, test, queryMask);
+	} else {
+		for (uint32_t i = 0; i < primitives.size() && !res; ++i) {
+			test(i, cutFactor);
+		}
+	}
+	return res;
+}
+
+void PackedCompound::RayTestAll(const Transform &trans, const RayInfo &ray,
+								RayHitBuffer &hits, LayerMask queryMask) const
+{
+	const RayInfo localRay = trans.ToLocal(ray);
+	auto test = [&](uint32_t id, float &cut) -> bool {
+		if ((masks[id] & queryMask) == 0) {
+			return false;
+		}
+		float ne;
+		glm::vec3 no;
+		if (Get(id).RayTestLocal(localRay, ne, no)) {
+			if (hits.Add({glm::max(ne, 0.0f), trans.rot * no, id})) {
+				cut = hits.CutFactor();
+			}
+		}
+		return false;
+	};
+	float cutFactor = hits.CutFactor();
+	if (compactBvh) {
+		compactBvh->IntersectRay(localRay, cutFactor, test, queryMask);
+	} else {
+		for (uint32_t i = 0; i < primitives.size(); ++i) {
+			test(i, cutFactor);
+		}
+	}
+}
+
+bool PackedCompound::OverlapTest(const Transform &trans,
+								 const OverlapVolume &volume,
+								 LayerMask queryMask) const
+{
+	uint32_t id;
+	return OverlapAll(trans, volume, &id, 1, queryMask) != 0;
+}
+
+uint32_t PackedCompound::OverlapAll(const Transform &trans,
+									const OverlapVolume &volume,
+									uint32_t *ids, uint32_t maxIds,
+									LayerMask queryMask) const
+{
+	const OverlapVolume local = volume.ToLocal(trans);
+	uint32_t found = 0;
+	auto test = [&](uint32_t id) -> bool {
+		if ((masks[id] & queryMask) != 0 && Get(id).OverlapTest({}, local)) {
+			ids[found++] = id;
+		}
+		return found >= maxIds;
+	};
+	if (maxIds == 0) {
+		return 0;
+	} else if (compactBvh) {
+		compactBvh->IntersectAabb(local.GetAabb(), test, queryMask);
+	} else {
+		for (uint32_t i = 0; i < primitives.size() && !test(i); ++i) {
+		}
+	}
+	return found;
+}
+
+bool PackedCompound::CylinderTestOnGround(const Transform &trans,
+										  const Cylinder &cyl, glm::vec3 pos,
+										  float &offsetHeight,
+										  glm::vec3 *onGroundNormal,
+										  bool *isOnEdge,
+										  LayerMask queryMask) const
+{
+	bool res = false;
+	auto test = [&](uint32_t id) -> bool {
+		if ((masks[id] & queryMask) == 0) {
+			return false;
+		}
+		float ofh;
+		if (Get(id).CylinderTestOnGround(trans, cyl, pos, ofh, onGroundNormal,
+										 isOnEdge)) {
+			if (res == false || offsetHeight < ofh) {
+				offsetHeight = ofh;
+				res = true;
+			}
+		}
+		return false;
+	};
+	if (compactBvh) {
+		compactBvh->IntersectAabb(LocalGroundColumn(trans, cyl, pos), test,
+								  queryMask);
+	} else {
+		for (uint32_t i = 0; i < primitives.size(); ++i) {
+			test(i);
+		}
+	}
+	return res;
+}
+
+bool PackedCompound::CylinderTestMovement(const Transform &trans,
+										  float &validMovementFactor,
+										  const Cylinder &cyl,
+										  const RayInfo &movementRay,
+										  glm::vec3 &normal,
+										  LayerMask queryMask) const
+{
+	bool res = false;
+	auto test = [&](uint32_t id) -> bool {
+		if ((masks[id] & queryMask) == 0) {
+			return false;
+		}
+		float vmf;
+		glm::vec3 no;
+		if (Get(id).CylinderTestMovement(trans, vmf, cyl, movementRay, no)) {
+			if (res == false || validMovementFactor > vmf) {
+				validMovementFactor = vmf;
+				normal = no;
+				res = true;
+			}
+		}
+		return false;
+	};
+	if (compactBvh) {
+		compactBvh->IntersectAabb(LocalMovementAabb(trans, cyl, movementRay),
+								  test, queryMask);
+	} else {
+		for (uint32_t i = 0; i < primitives.size(); ++i) {
+			test(i);
+		}
+	}
+	return res;
+}
+
+bool PackedCompound::SphereTestMovement(const Transform &trans,
+										float &validMovementFactor,
+										const Sphere &sph,
+										const RayInfo &movementRay,
+										glm::vec3 &normal) const
+{
+	return SphereTestMovement(trans, validMovementFactor, sph, movementRay,
+							  normal, LAYER_MASK_ALL);
+}
+
+bool PackedCompound::SphereTestMovement(const Transform &trans,
+										float &validMovementFactor,
+										const Sphere &sph,
+										const RayInfo &movementRay,
+										glm::vec3 &normal,
+										LayerMask queryMask) const
+{
+	bool res = false;
+	float cutFactor = 1.0f;
+	auto test = [&](uint32_t id, float &cut) -> bool {
+		if ((masks[id] & queryMask) == 0) {
+			return false;
+		}
+		float vmf;
+		glm::vec3 no;
+		if (Get(id).SphereTestMovement(trans, vmf, sph, movementRay, no)) {
+			if (vmf <= cut) {
+				normal = no;
+				cut = vmf;
+				res = true;
+			}
+		}
+		return false;
+	};
+	if (compactBvh) {
+		compactBvh->IntersectRay(trans.ToLocal(movementRay), cutFactor, test,
+								 queryMask, sph.radius);
+	} else {
+		for (uint32_t i = 0; i < primitives.size(); ++i) {
+			test(i, cutFactor);
+		}
+	}
+	validMovementFactor = cutFactor;
+	return res;
+}
+} // namespace Collision3D
@@ -0,0 +1,257 @@
+// This file is part of Collision3D.
+// Copyright (c) 2025 Marek Zalewski aka Drwalin
+// You should have received a copy of the MIT License along with this program.
+
+#include "../include/collision3d/CollisionShapes_AnyOrCompound.hpp"
+
+namespace Collision3D
+{
+using namespace spp;
+
+// Ray enters aabb at factor in [0, cutFactor] or starts inside of it
+static inline bool RayEntersAabb(const spp::Aabb &aabb, const RayInfo &ray,
+								 float cutFactor)
+{
+	const glm::vec3 t0 = (aabb.min - ray.start) * ray.invDir;
+	const glm::vec3 t1 = (aabb.max - ray.start) * ray.invDir;
+	const float tNear = glm::maxcomp(glm::min(t0, t1));
+	const float tFar = glm::mincomp(glm::max(t0, t1));
+	return tNear <= tFar && tFar >= 0.0f && tNear <= cutFactor;
+}
+
+spp::Aabb PrimitiveSpan::GetAabb(const Transform &trans) const
+{
+	spp::Aabb aabb = spp::AABB_INVALID;
+	for (const auto &s : *this) {
+		aabb = aabb + s.GetAabb(trans);
+	}
+	return aabb;
+}
+
+bool PrimitiveSpan::RayTest(const Transform &trans, const RayInfo &ray,
+							float &near, glm::vec3 &normal) const
+{
+	return RayTest(trans, ray, near, normal, LAYER_MASK_ALL);
+}
+
+bool PrimitiveSpan::RayTestLocal(const RayInfo &ray, float &near,
+								 glm::vec3 &normal) const
+{
+	return RayTestLocal(ray, near, normal, LAYER_MASK_ALL);
+}
+
+bool PrimitiveSpan::OcclusionTest(const Transform &trans,
+								  const RayInfo &ray) const
+{
+	return OcclusionTest(trans, ray, LAYER_MASK_ALL);
+}
+
+bool PrimitiveSpan::OverlapTest(const Transform &trans,
+								const OverlapVolume &volume) const
+{
+	return OverlapTest(trans, volume, LAYER_MASK_ALL);
+}
+
+bool PrimitiveSpan::CylinderTestOnGround(const Transform &trans,
+										 const Cylinder &cyl, glm::vec3 pos,
+										 float &offsetHeight,
+										 glm::vec3 *onGroundNormal,
+										 bool *isOnEdge) const
+{
+	return CylinderTestOnGround(trans, cyl, pos, offsetHeight, onGroundNormal,
+								isOnEdge, LAYER_MASK_ALL);
+}
+
+bool PrimitiveSpan::CylinderTestMovement(const Transform &trans,
+										 float &validMovementFactor,
+										 const Cylinder &cyl,
+										 const RayInfo &movementRay,
+										 glm::vec3 &normal) const
+{
+	return CylinderTestMovement(trans, validMovementFactor, cyl, movementRay,
+								normal, LAYER_MASK_ALL);
+}
+
+bool PrimitiveSpan::RayTest(const Transform &trans, const RayInfo &ray,
+							float &near, glm::vec3 &normal,
+							LayerMask queryMask) const
+{
+	if (RayTestLocal(trans.ToLocal(ray), near, normal, queryMask)) {
+		normal = trans.rot * normal;
+		return true;
+	} else {
+		return false;
+	}
+}
+
+bool PrimitiveSpan::RayTestLocal(const RayInfo &ray, float &near,
+								 glm::vec3 &normal, LayerMask queryMask) const
+{
+	bool res = false;
+	float ne;
+	glm::vec3 no;
+	for (uint32_t i = 0; i < count; ++i) {
+		if (aabbs && !RayEntersAabb(aabbs[i], ray, res ? near : 1.0f)) {
+			continue;
+		}
+		if (data[i].RayTestLocal(ray, ne, no, queryMask)) {
+			if (res) {
+				if (near > ne) {
+					near = ne;
+					normal = no;
+				}
+			} else {
+				near = ne;
+				normal = no;
+				res = true;
+			}
+		}
+	}
+	return res;
+}
+
+bool PrimitiveSpan::OcclusionTest(const Transform &trans,
+								  const RayInfo &ray,
+								  LayerMask queryMask) const
+{
+	for (const auto &s : *this) {
+		if (s.OcclusionTest(trans, ray, queryMask)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void PrimitiveSpan::RayTestAll(const Transform &trans, const RayInfo &ray,
+							   RayHitBuffer &hits, LayerMask queryMask) const
+{
+	const RayInfo localRay = trans.ToLocal(ray);
+	float ne;
+	glm::vec3 no;
+	for (uint32_t i = 0; i < count; ++i) {
+		if (aabbs && !RayEntersAabb(aabbs[i], localRay, hits.CutFactor())) {
+			continue;
+		}
+		if (data[i].RayTestLocal(localRay, ne, no, queryMask)) {
+			hits.Add({glm::max(ne, 0.0f), trans.rot * no, i});
+		}
+	}
+}
+
+bool PrimitiveSpan::OverlapTest(const Transform &trans,
+								const OverlapVolume &volume,
+								LayerMask queryMask) const
+{
+	uint32_t id;
+	return OverlapAll(trans, volume, &id, 1, queryMask) != 0;
+}
+
+uint32_t PrimitiveSpan::OverlapAll(const Transform &trans,
+								   const OverlapVolume &volume, uint32_t *ids,
+								   uint32_t maxIds, LayerMask queryMask) const
+{
+	const OverlapVolume local = volume.ToLocal(trans);
+	const spp::Aabb aabb = local.GetAabb();
+	uint32_t found = 0;
+	for (uint32_t i = 0; i < count && found < maxIds; ++i) {
+		if (aabbs && !aabbs[i].HasIntersection(aabb)) {
+			continue;
+		}
+		if (data[i].OverlapTest({}, local, queryMask)) {
+			ids[found++] = i;
+		}
+	}
+	return found;
+}
+
+bool PrimitiveSpan::CylinderTestOnGround(const Transform &trans,
+										 const Cylinder &cyl, glm::vec3 pos,
+										 float &offsetHeight,
+										 glm::vec3 *onGroundNormal,
+										 bool *isOnEdge,
+										 LayerMask queryMask) const
+{
+	bool res = false;
+	float ofh;
+	for (const auto &s : *this) {
+		if (s.CylinderTestOnGround(trans, cyl, pos, ofh, onGroundNormal,
+								   isOnEdge, queryMask)) {
+			if (res) {
+				if (offsetHeight < ofh) {
+					offsetHeight = ofh;
+				}
+			} else {
+				offsetHeight = ofh;
+				res = true;
+			}
+		}
+	}
+	return res;
+}
+
+bool PrimitiveSpan::CylinderTestMovement(const Transform &trans,
+										 float &validMovementFactor,
+										 const Cylinder &cyl,
+										 const RayInfo &movementRay,
+										 glm::vec3 &normal,
+										 LayerMask queryMask) const
+{
+	bool res = false;
+	float vmf;
+	glm::vec3 no;
+	for (const auto &s : *this) {
+		if (s.CylinderTestMovement(trans, vmf, cyl, movementRay, no,
+								   queryMask)) {
+			if (res) {
+				if (validMovementFactor > vmf) {
+					validMovementFactor = vmf;
+					normal = no;
+				}
+			} else {
+				validMovementFactor = vmf;
+				normal = no;
+				res = true;
+			}
+		}
+	}
+	return res;
+}
+
+bool PrimitiveSpan::SphereTestMovement(const Transform &trans,
+									   float &validMovementFactor,
+									   const Sphere &sph,
+									   const RayInfo &movementRay,
+									   glm::vec3 &normal) const
+{
+	return SphereTestMovement(trans, validMovementFactor, sph, movementRay,
+							  normal, LAYER_MASK_ALL);
+}
+
+bool PrimitiveSpan::SphereTestMovement(const Transform &trans,
+									   float &validMovementFactor,
+									   const Sphere &sph,
+									   const RayInfo &movementRay,
+									   glm::vec3 &normal,
+									   LayerMask queryMask) const
+{
+	bool res = false;
+	float vmf;
+	glm::vec3 no;
+	for (const auto &s : *this) {
+		if (s.SphereTestMovement(trans, vmf, sph, movementRay, no,
+								 queryMask)) {
+			if (res) {
+				if (validMovementFactor > vmf) {
+					validMovementFactor = vmf;
+					normal = no;
+				}
+			} else {
+				validMovementFactor = vmf;
+				normal = no;
+				res = true;
+			}
+		}
+	}
+	return res;
+}
+} // namespace Collision3D
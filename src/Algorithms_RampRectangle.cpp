@@ -13,7 +13,7 @@ spp::Aabb RampRectangle::GetAabb(const Transform &trans) const
 	const float h = fabs(halfHeightSkewness) + halfThickness;
 	Transform t = trans;
 	t.pos.y -= h;
-	return VertBox{{halfWidth, h, halfDepth}}.GetAabb(trans);
+	return VertBox{{halfWidth, h, halfDepth}}.GetAabb(t);
 }
 
 bool RampRectangle::RayTest(const Transform &trans, const RayInfo &ray,
@@ -30,68 +30,40 @@ bool RampRectangle::RayTest(const Transform &trans, const RayInfo &ray,
 bool RampRectangle::RayTestLocal(const RayInfo &ray, float &near,
 								 glm::vec3 &normal) const
 {
-	const glm::vec3 non{0, halfDepth, -halfHeightSkewness};
-	const glm::vec3 no = non;
-	const glm::vec3 n[6] = {{0, 0, -1}, {0, 0, 1}, {1, 0, 0},
-							{-1, 0, 0}, no,		   -no};
+	// Planes -z, +z, +x, -x, top, bottom and two padding planes
+	const glm::vec3 no =
+		glm::normalize(glm::vec3{0, halfDepth, -halfHeightSkewness});
 	const float ofn = halfThickness * no.y;
-	const float offs[6] = {halfDepth, halfDepth, halfWidth,
-						   halfWidth, ofn,		 ofn};
-	int frontNormalId = -1, backNormalId = -1;
-
-	near = -1e9f;
-	float far = 1e9f;
-
-	for (int i = 0; i < 6; ++i) {
-		if (TestPlaneIterational(n[i], offs[i], ray, near, far, frontNormalId,
-								 backNormalId, i) == false) {
-			return false;
-		}
-	}
-
-	if (far < 0.0f) {
-		return false;
-	}
+	const float nx[8] = {0, 0, 1, -1, 0, 0, 0, 0};
+	const float ny[8] = {0, 0, 0, 0, no.y, -no.y, 0, 0};
+	const float nz[8] = {-1, 1, 0, 0, no.z, -no.z, 0, 0};
+	const float offs[8] = {halfDepth, halfDepth, halfWidth,
+						   halfWidth, ofn,		 ofn,
+						   CONVEX_SOA_PAD_OFFSET, CONVEX_SOA_PAD_OFFSET};
+	static_assert(8 % CONVEX_SOA_WIDTH == 0);
+	return RayTestConvexSoA(nx, ny, nz, offs, 8, ray, near, normal);
+}
 
-	if (far < near) {
-		return false;
-	}
+bool RampRectangle::OcclusionTest(const Transform &trans,
+								  const RayInfo &ray) const
+{
+	float near;
+	glm::vec3 normal;
+	return RayTestLocal(trans.ToLocal(ray), near, normal);
+}
 
-	if (near < 0.0f) {
-		/* is inside*/
-		near = 0.0f;
-		normal = -ray.dirNormalized;
-		/* find shortest way outside */
-		float d = glm::dot(ray.start, n[0]) - offs[0];
-		assert(d <= 0.0f);
-		for (int i = 1; i < 6; ++i) {
-			const float d2 = glm::dot(ray.start, n[i]) - offs[i];
-			assert(d2 <= 0.0f);
-			if (d > d2) {
-				d = d2;
-				normal = n[i];
-			}
-		}
-		return true;
-	} else if (near >= 0.0f) {
-		/* outside, hitting front face */
-		if (near <= 1.0f) {
-			normal = n[frontNormalId];
-			return true; // frontface
-		} else {
-			return false;
-		}
-	} else {
-		if (far < near) {
-			/* inside, hitting back face */
-			normal = n[backNormalId];
-			near = 0.0f; // near = far;
-			return true; // backface
-		} else {
-			/* inside, but back face beyond tmax */
-			return false; // missed
-		}
+bool RampRectangle::OverlapTest(const Transform &trans,
+								const OverlapVolume &volume) const
+{
+	glm::vec3 vertices[8];
+	for (int i = 0; i < 8; ++i) {
+		const float zs = i & 4 ? 1.0f : -1.0f;
+		vertices[i] = {i & 1 ? halfWidth : -halfWidth,
+					   halfHeightSkewness * zs +
+						   (i & 2 ? halfThickness : -halfThickness),
+					   halfDepth * zs};
 	}
+	return OverlapTestConvex(vertices, 8, 0.0f, volume.ToLocal(trans));
 }
 
 bool RampRectangle::CylinderTestOnGround(const Transform &trans,
@@ -100,7 +72,8 @@ bool RampRectangle::CylinderTestOnGround(const Transform &trans,
 										 glm::vec3 *onGroundNormal,
 										 bool *isOnEdge) const
 {
-	if (fabs(halfHeightSkewness) > halfDepth) {
+	const glm::vec3 normal = {0, halfDepth, -halfHeightSkewness};
+	if (IsGroundNormal(normal) == false) {
 		return false;
 	}
 
@@ -119,7 +92,7 @@ bool RampRectangle::CylinderTestOnGround(const Transform &trans,
 	offsetHeight = localPos.y - y;
 
 	if (onGroundNormal) {
-		*onGroundNormal = glm::vec3(0, halfDepth, -halfHeightSkewness);
+		*onGroundNormal = normal;
 	}
 
 	if (isOnEdge) {
@@ -146,4 +119,34 @@ bool RampRectangle::CylinderTestMovement(const Transform &_trans,
 	trans.pos.y -= h2;
 	return tmp.RayTest(trans, movementRay, validMovementFactor, normal);
 }
+
+bool RampRectangle::SphereTestMovement(const Transform &trans,
+									   float &validMovementFactor,
+									   const Sphere &sph,
+									   const RayInfo &movementRay,
+									   glm::vec3 &normal) const
+{
+	const glm::vec3 no =
+		glm::normalize(glm::vec3{0, halfDepth, -halfHeightSkewness});
+	const glm::vec3 n[6] = {{0, 0, -1}, {0, 0, 1}, {1, 0, 0},
+							{-1, 0, 0}, no,		   -no};
+	const float ofn = halfThickness * no.y;
+	const float offs[6] = {halfDepth, halfDepth, halfWidth,
+						   halfWidth, ofn,		 ofn};
+	glm::vec3 vertices[8];
+	for (int i = 0; i < 8; ++i) {
+		const float zs = i & 4 ? 1.0f : -1.0f;
+		vertices[i] = {i & 1 ? halfWidth : -halfWidth,
+					   halfHeightSkewness * zs +
+						   (i & 2 ? halfThickness : -halfThickness),
+					   halfDepth * zs};
+	}
+	if (SweptSphereTestConvex(n, offs, 6, vertices, 8, HEXAHEDRON_EDGES, 12,
+							  sph.radius, trans.ToLocal(movementRay),
+							  validMovementFactor, normal)) {
+		normal = trans.rot * normal;
+		return true;
+	}
+	return false;
+}
 } // namespace Collision3D
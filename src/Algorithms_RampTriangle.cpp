@@ -0,0 +1,242 @@
+// This file is part of Collision3D.
+// Copyright (c) 2025 Marek Zalewski aka Drwalin
+// You should have received a copy of the MIT License along with this program.
+
+#include "../include/collision3d/CollisionShapes_Primitives.hpp"
+
+namespace Collision3D
+{
+using namespace spp;
+
+static constexpr int RAMP_TRIANGLE_PLANES = 5;
+static constexpr int RAMP_TRIANGLE_MOVEMENT_PLANES = 19;
+
+static void RampTriangleVertices(glm::vec3 p3, float halfThickness,
+								 glm::vec3 *vertices)
+{
+	const glm::vec3 t{0, halfThickness, 0};
+	const glm::vec3 v[3] = {{-1, 0, 0}, {1, 0, 0}, p3};
+	for (int i = 0; i < 3; ++i) {
+		vertices[i] = v[i] - t;
+		vertices[i + 3] = v[i] + t;
+	}
+}
+
+// Unit planes of prism: top, bottom and three vertical sides
+static void RampTrianglePlanes(glm::vec3 p3, float halfThickness,
+							   glm::vec3 *normals, float *offsets)
+{
+	const glm::vec3 n = glm::normalize(glm::vec3{0, p3.z, -p3.y});
+	normals[0] = n;
+	offsets[0] = halfThickness * n.y;
+	normals[1] = -n;
+	offsets[1] = halfThickness * n.y;
+
+	const glm::vec2 v[3] = {{-1, 0}, {1, 0}, {p3.x, p3.z}};
+	for (int i = 0; i < 3; ++i) {
+		const glm::vec2 a = v[i];
+		const glm::vec2 b = v[(i + 1) % 3];
+		glm::vec2 e = glm::normalize(glm::vec2{b.y - a.y, a.x - b.x});
+		if (glm::dot(e, v[(i + 2) % 3] - a) > 0.0f) {
+			e = -e;
+		}
+		normals[2 + i] = {e.x, 0, e.y};
+		offsets[2 + i] = glm::dot(e, a);
+	}
+}
+
+// Planes of Minkowski sum of prism and square base prism of cylinder
+// [-r, r] x [-h, 0] x [-r, r], so ray of cylinder base can be tested. Sum of
+// convex polyhedra is bounded by face normals of both and cross products of
+// their edges, only two slanted edges of triangle give new ones. Offsets
+// are sums of support functions.
+static void RampTriangleMovementPlanes(glm::vec3 p3, float halfThickness,
+									   float r, float h, glm::vec3 *normals,
+									   float *offsets)
+{
+	RampTrianglePlanes(p3, halfThickness, normals, offsets);
+	int count = RAMP_TRIANGLE_PLANES;
+	const glm::vec3 axes[3] = {{1, 0, 0}, {0, 1, 0}, {0, 0, 1}};
+	for (const glm::vec3 &axis : axes) {
+		normals[count++] = axis;
+		normals[count++] = -axis;
+	}
+	const glm::vec3 edges[2] = {p3 - glm::vec3{1, 0, 0},
+								glm::vec3{-1, 0, 0} - p3};
+	for (const glm::vec3 &e : edges) {
+		for (const glm::vec3 axis : {axes[0], axes[2]}) {
+			const glm::vec3 n = glm::cross(e, axis);
+			normals[count++] = n;
+			normals[count++] = -n;
+		}
+	}
+	assert(count == RAMP_TRIANGLE_MOVEMENT_PLANES);
+
+	glm::vec3 vertices[6];
+	RampTriangleVertices(p3, halfThickness, vertices);
+	for (int i = 0; i < count; ++i) {
+		const glm::vec3 n = normals[i];
+		float support = glm::dot(n, vertices[0]);
+		for (int j = 1; j < 6; ++j) {
+			support = glm::max(support, glm::dot(n, vertices[j]));
+		}
+		offsets[i] = support + r * (fabs(n.x) + fabs(n.z)) +
+					 (n.y < 0.0f ? -n.y * h : 0.0f);
+	}
+}
+
+// Nearest point of triangle to p in 2D
+static glm::vec2 ClosestPointOnTriangle(glm::vec2 p, const glm::vec2 *v)
+{
+	bool inside = true;
+	float best = 1e30f;
+	glm::vec2 res = p;
+	for (int i = 0; i < 3; ++i) {
+		const glm::vec2 a = v[i];
+		const glm::vec2 b = v[(i + 1) % 3];
+		const glm::vec2 o = v[(i + 2) % 3];
+		const glm::vec2 e = b - a;
+		const float side = e.x * (p.y - a.y) - e.y * (p.x - a.x);
+		const float sideO = e.x * (o.y - a.y) - e.y * (o.x - a.x);
+		if (side * sideO < 0.0f) {
+			inside = false;
+		}
+		const float ee = glm::dot(e, e);
+		const float f =
+			ee > 0.0f ? glm::clamp(glm::dot(p - a, e) / ee, 0.0f, 1.0f) : 0.0f;
+		const glm::vec2 q = a + e * f;
+		const float d = glm::dot(p - q, p - q);
+		if (d < best) {
+			best = d;
+			res = q;
+		}
+	}
+	return inside ? p : res;
+}
+
+spp::Aabb RampTriangle::GetAabb(const Transform &trans) const
+{
+	glm::vec3 vertices[6];
+	RampTriangleVertices(p3, halfThickness, vertices);
+	glm::vec3 min = trans * vertices[0], max = min;
+	for (int i = 1; i < 6; ++i) {
+		const glm::vec3 v = trans * vertices[i];
+		min = glm::min(min, v);
+		max = glm::max(max, v);
+	}
+	return {min, max};
+}
+
+bool RampTriangle::RayTest(const Transform &trans, const RayInfo &ray,
+						   float &near, glm::vec3 &normal) const
+{
+	if (RayTestLocal(trans.ToLocal(ray), near, normal)) {
+		normal = trans.rot * normal;
+		return true;
+	} else {
+		return false;
+	}
+}
+
+bool RampTriangle::RayTestLocal(const RayInfo &ray, float &near,
+								glm::vec3 &normal) const
+{
+	glm::vec3 n[RAMP_TRIANGLE_PLANES];
+	float offs[RAMP_TRIANGLE_PLANES];
+	RampTrianglePlanes(p3, halfThickness, n, offs);
+	return RayTestConvex(n, offs, RAMP_TRIANGLE_PLANES, ray, near, normal);
+}
+
+bool RampTriangle::OcclusionTest(const Transform &trans,
+								 const RayInfo &ray) const
+{
+	float near;
+	glm::vec3 normal;
+	return RayTestLocal(trans.ToLocal(ray), near, normal);
+}
+
+bool RampTriangle::OverlapTest(const Transform &trans,
+							   const OverlapVolume &volume) const
+{
+	glm::vec3 vertices[6];
+	RampTriangleVertices(p3, halfThickness, vertices);
+	return OverlapTestConvex(vertices, 6, 0.0f, volume.ToLocal(trans));
+}
+
+bool RampTriangle::CylinderTestOnGround(const Transform &trans,
+										const Cylinder &cyl, glm::vec3 pos,
+										float &offsetHeight,
+										glm::vec3 *onGroundNormal,
+										bool *isOnEdge) const
+{
+	if (IsGroundNormal({0, p3.z, -p3.y}) == false) {
+		return false;
+	}
+
+	const glm::vec3 localPos = trans.ToLocal(pos);
+	const glm::vec2 v[3] = {{-1, 0}, {1, 0}, {p3.x, p3.z}};
+	const glm::vec2 p{localPos.x, localPos.z};
+	const glm::vec2 q = ClosestPointOnTriangle(p, v);
+	const float dist = glm::distance(p, q);
+
+	if (dist > cyl.radius + ON_EDGE_FACTOR) {
+		return false;
+	}
+
+	const float y = (p3.y * q.y) / p3.z + halfThickness;
+	offsetHeight = localPos.y - y;
+
+	if (onGroundNormal) {
+		*onGroundNormal =
+			trans.rot * glm::normalize(glm::vec3{0, p3.z, -p3.y});
+	}
+
+	if (isOnEdge) {
+		if (dist > cyl.radius) {
+			*isOnEdge = true;
+		}
+	}
+
+	return true;
+}
+
+bool RampTriangle::CylinderTestMovement(const Transform &trans,
+										float &validMovementFactor,
+										const Cylinder &cyl,
+										const RayInfo &movementRay,
+										glm::vec3 &normal) const
+{
+	// Cylinder is treated as square base prism, like by RampRectangle
+	glm::vec3 n[RAMP_TRIANGLE_MOVEMENT_PLANES];
+	float offs[RAMP_TRIANGLE_MOVEMENT_PLANES];
+	RampTriangleMovementPlanes(p3, halfThickness, cyl.radius, cyl.height, n,
+							   offs);
+	if (RayTestConvex(n, offs, RAMP_TRIANGLE_MOVEMENT_PLANES,
+					  trans.ToLocal(movementRay), validMovementFactor,
+					  normal)) {
+		normal = trans.rot * normal;
+		return true;
+	}
+	return false;
+}
+
+bool RampTriangle::SphereTestMovement(const Transform &trans,
+									  float &validMovementFactor,
+									  const Sphere &sph,
+									  const RayInfo &movementRay,
+									  glm::vec3 &normal) const
+{
+	glm::vec3 n[RAMP_TRIANGLE_PLANES];
+	float offs[RAMP_TRIANGLE_PLANES];
+	RampTrianglePlanes(p3, halfThickness, n, offs);
+	glm::vec3 vertices[6];
+	RampTriangleVertices(p3, halfThickness, vertices);
+	if (SweptSphereTestConvex(n, offs, RAMP_TRIANGLE_PLANES, vertices, 6,
+							  TRIANGULAR_PRISM_EDGES, 9, sph.radius, trans.ToLocal(movementRay),
+							  validMovementFactor, normal)) {
+		normal = trans.rot * normal;
+		return true;
+	}
+	return false;
+}
+} // namespace Collision3D
@@ -0,0 +1,164 @@
+// This file is part of Collision3D.
+// Copyright (c) 2025 Marek Zalewski aka Drwalin
+// You should have received a copy of the MIT License along with this program.
+
+#include "../include/collision3d/CollisionShapes_AnyOrCompound.hpp"
+
+namespace Collision3D
+{
+using namespace spp;
+
+bool SmallCompound::Add(const AnyPrimitive &primitive)
+{
+	if (count >= CAPACITY) {
+		return false;
+	}
+	primitives[count] = primitive;
+	++count;
+	return true;
+}
+
+AnyShape CreateCompoundShape(CompoundPrimitive &&compound, Transform trans)
+{
+	if (compound.primitives.size <= SmallCompound::CAPACITY) {
+		SmallCompound small;
+		for (const auto &p : compound.primitives) {
+			small.Add(p);
+		}
+		return AnyShape(std::move(small), trans);
+	}
+	return AnyShape(std::move(compound), trans);
+}
+
+spp::Aabb SmallCompound::GetAabb(const Transform &trans) const
+{
+	return Span().GetAabb(trans);
+}
+
+bool SmallCompound::RayTest(const Transform &trans, const RayInfo &ray,
+							float &near, glm::vec3 &normal) const
+{
+	return Span().RayTest(trans, ray, near, normal);
+}
+
+bool SmallCompound::RayTestLocal(const RayInfo &ray, float &near,
+								 glm::vec3 &normal) const
+{
+	return Span().RayTestLocal(ray, near, normal);
+}
+
+bool SmallCompound::OcclusionTest(const Transform &trans,
+								  const RayInfo &ray) const
+{
+	return Span().OcclusionTest(trans, ray);
+}
+
+bool SmallCompound::OverlapTest(const Transform &trans,
+								const OverlapVolume &volume) const
+{
+	return Span().OverlapTest(trans, volume);
+}
+
+bool SmallCompound::CylinderTestOnGround(const Transform &trans,
+										 const Cylinder &cyl, glm::vec3 pos,
+										 float &offsetHeight,
+										 glm::vec3 *onGroundNormal,
+										 bool *isOnEdge) const
+{
+	return Span().CylinderTestOnGround(trans, cyl, pos, offsetHeight,
+									   onGroundNormal, isOnEdge);
+}
+
+bool SmallCompound::CylinderTestMovement(const Transform &trans,
+										 float &validMovementFactor,
+										 const Cylinder &cyl,
+										 const RayInfo &movementRay,
+										 glm::vec3 &normal) const
+{
+	return Span().CylinderTestMovement(trans, validMovementFactor, cyl,
+									   movementRay, normal);
+}
+
+bool SmallCompound::RayTest(const Transform &trans, const RayInfo &ray,
+							float &near, glm::vec3 &normal,
+							LayerMask queryMask) const
+{
+	return Span().RayTest(trans, ray, near, normal, queryMask);
+}
+
+bool SmallCompound::RayTestLocal(const RayInfo &ray, float &near,
+								 glm::vec3 &normal, LayerMask queryMask) const
+{
+	return Span().RayTestLocal(ray, near, normal, queryMask);
+}
+
+bool SmallCompound::OcclusionTest(const Transform &trans,
+								  const RayInfo &ray,
+								  LayerMask queryMask) const
+{
+	return Span().OcclusionTest(trans, ray, queryMask);
+}
+
+void SmallCompound::RayTestAll(const Transform &trans, const RayInfo &ray,
+							   RayHitBuffer &hits, LayerMask queryMask) const
+{
+	Span().RayTestAll(trans, ray, hits, queryMask);
+}
+
+bool SmallCompound::OverlapTest(const Transform &trans,
+								const OverlapVolume &volume,
+								LayerMask queryMask) const
+{
+	return Span().OverlapTest(trans, volume, queryMask);
+}
+
+uint32_t SmallCompound::OverlapAll(const Transform &trans,
+								   const OverlapVolume &volume, uint32_t *ids,
+								   uint32_t maxIds, LayerMask queryMask) const
+{
+	return Span().OverlapAll(trans, volume, ids, maxIds, queryMask);
+}
+
+bool SmallCompound::CylinderTestOnGround(const Transform &trans,
+										 const Cylinder &cyl, glm::vec3 pos,
+										 float &offsetHeight,
+										 glm::vec3 *onGroundNormal,
+										 bool *isOnEdge,
+										 LayerMask queryMask) const
+{
+	return Span().CylinderTestOnGround(trans, cyl, pos, offsetHeight,
+									   onGroundNormal, isOnEdge, queryMask);
+}
+
+bool SmallCompound::CylinderTestMovement(const Transform &trans,
+										 float &validMovementFactor,
+										 const Cylinder &cyl,
+										 const RayInfo &movementRay,
+										 glm::vec3 &normal,
+										 LayerMask queryMask) const
+{
+	return Span().CylinderTestMovement(trans, validMovementFactor, cyl,
+									   movementRay, normal, queryMask);
+}
+
+bool SmallCompound::SphereTestMovement(const Transform &trans,
+									   float &validMovementFactor,
+									   const Sphere &sph,
+									   const RayInfo &movementRay,
+									   glm::vec3 &normal) const
+{
+	return Span().SphereTestMovement(trans, validMovementFactor, sph,
+									 movementRay, normal);
+}
+
+bool SmallCompound::SphereTestMovement(const Transform &trans,
+									   float &validMovementFactor,
+									   const Sphere &sph,
+									   const RayInfo &movementRay,
+									   glm::vec3 &normal,
+									   LayerMask queryMask) const
+{
+	return Span().SphereTestMovement(trans, validMovementFactor, sph,
+									 movementRay, normal, queryMask);
+}
+} // namespace Collision3D
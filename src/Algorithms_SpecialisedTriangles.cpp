@@ -0,0 +1,288 @@
+// This file is part of Collision3D.
+// Copyright (c) 2025 Marek Zalewski aka Drwalin
+// You should have received a copy of the MIT License along with this program.
+
+#include "../include/collision3d/CollisionShapes_Primitives.hpp"
+#include "../include/collision3d/SpecialisedCollisionShapes.hpp"
+
+namespace Collision3D
+{
+using namespace spp;
+
+// Fixed angles make all horizontal directions constant. Slanted edges have
+// outward normals (+-SIDE_X, 0, SIDE_Z) in XZ, third vertex is at depth
+// DEPTH * edge.
+template <typename T> struct TriangleConstants;
+
+template <> struct TriangleConstants<Triangle60> {
+	static constexpr float DEPTH = 0.8660254037844386f;
+	static constexpr float SIDE_X = 0.8660254037844386f;
+	static constexpr float SIDE_Z = 0.5f;
+};
+
+template <> struct TriangleConstants<Triangle90_45> {
+	static constexpr float DEPTH = 0.5f;
+	static constexpr float SIDE_X = 0.7071067811865476f;
+	static constexpr float SIDE_Z = 0.7071067811865476f;
+};
+
+static constexpr int TRIANGLE_MOVEMENT_PLANES = 14;
+
+template <typename T> struct SpecialisedTriangle {
+	using C = TriangleConstants<T>;
+
+	float halfEdge;
+	float depth;
+	float height;
+	// Offset of slanted edge planes
+	float sideOffset;
+	// Unit normal of upper side, x = 0
+	glm::vec3 n;
+
+	inline SpecialisedTriangle(const T &shape)
+		: halfEdge(shape.edge * 0.5f), depth(shape.edge * C::DEPTH),
+		  height(shape.vertexHeight), sideOffset(C::SIDE_X * halfEdge),
+		  n(glm::normalize(glm::vec3{0, depth, -height}))
+	{
+	}
+
+	inline void Vertices(glm::vec3 *v) const
+	{
+		v[0] = {-halfEdge, 0, 0};
+		v[1] = {halfEdge, 0, 0};
+		v[2] = {0, height, depth};
+	}
+
+	inline bool IsInside2D(float x, float z) const
+	{
+		return z >= 0.0f && C::SIDE_X * glm::abs(x) + C::SIDE_Z * z <= sideOffset;
+	}
+
+	spp::Aabb GetAabb(const Transform &trans) const
+	{
+		glm::vec3 v[3];
+		Vertices(v);
+		const glm::vec3 a = trans * v[0];
+		const glm::vec3 b = trans * v[1];
+		const glm::vec3 c = trans * v[2];
+		return {glm::min(a, glm::min(b, c)), glm::max(a, glm::max(b, c))};
+	}
+
+	bool RayTestLocal(const RayInfo &ray, float &near, glm::vec3 &normal) const
+	{
+		// Plane passes through origin
+		const float vd = glm::dot(ray.dir, n);
+		if (vd == 0.0f) {
+			return false;
+		}
+		const float t = -glm::dot(ray.start, n) / vd;
+		if (t < 0.0f || t > 1.0f) {
+			return false;
+		}
+		const glm::vec3 p = ray.start + ray.dir * t;
+		if (IsInside2D(p.x, p.z) == false) {
+			return false;
+		}
+		near = t;
+		normal = vd < 0.0f ? n : -n;
+		return true;
+	}
+
+	bool CylinderTestOnGround(const Transform &trans, const Cylinder &cyl,
+							  glm::vec3 pos, float &offsetHeight,
+							  glm::vec3 *onGroundNormal, bool *isOnEdge) const
+	{
+		if (IsGroundNormal({0, depth, -height}) == false) {
+			return false;
+		}
+
+		const glm::vec3 localPos = trans.ToLocal(pos);
+		float x = localPos.x, z = localPos.z;
+		if (IsInside2D(x, z) == false) {
+			// nearest point on edges
+			glm::vec3 v[3];
+			Vertices(v);
+			float best = 1e30f;
+			for (int i = 0; i < 3; ++i) {
+				const glm::vec2 a{v[i].x, v[i].z};
+				const glm::vec2 e = glm::vec2{v[(i + 1) % 3].x, v[(i + 1) % 3].z} - a;
+				const glm::vec2 p{localPos.x, localPos.z};
+				const float f =
+					glm::clamp(glm::dot(p - a, e) / glm::dot(e, e), 0.0f, 1.0f);
+				const glm::vec2 q = a + e * f;
+				const float d = glm::dot(p - q, p - q);
+				if (d < best) {
+					best = d;
+					x = q.x;
+					z = q.y;
+				}
+			}
+		}
+		const float dx = localPos.x - x, dz = localPos.z - z;
+		const float dist = sqrt(dx * dx + dz * dz);
+
+		if (dist > cyl.radius + ON_EDGE_FACTOR) {
+			return false;
+		}
+
+		offsetHeight = localPos.y - (height * z) / depth;
+
+		if (onGroundNormal) {
+			*onGroundNormal = trans.rot * n;
+		}
+
+		if (isOnEdge) {
+			if (dist > cyl.radius) {
+				*isOnEdge = true;
+			}
+		}
+
+		return true;
+	}
+
+	// Exact Minkowski sum with square base prism [-r, r] x [-h, 0] x [-r, r]
+	// of cylinder. Only crosses of slanted edges with z axis add normals
+	// (+-vertexHeight, halfEdge, 0) to faces of both shapes.
+	bool CylinderTestMovement(const Transform &trans,
+							  float &validMovementFactor, const Cylinder &cyl,
+							  const RayInfo &movementRay,
+							  glm::vec3 &normal) const
+	{
+		const float r = cyl.radius;
+		const float h = cyl.height;
+		const float sideSupport = r * (C::SIDE_X + C::SIDE_Z);
+		const glm::vec3 normals[TRIANGLE_MOVEMENT_PLANES] = {
+			n,
+			-n,
+			{C::SIDE_X, 0, C::SIDE_Z},
+			{-C::SIDE_X, 0, C::SIDE_Z},
+			{0, 0, -1},
+			{1, 0, 0},
+			{-1, 0, 0},
+			{0, 1, 0},
+			{0, -1, 0},
+			{0, 0, 1},
+			{height, halfEdge, 0},
+			{-height, halfEdge, 0},
+			{height, -halfEdge, 0},
+			{-height, -halfEdge, 0}};
+		// support of triangle and box in all four edge cross directions,
+		// without vertical part of box
+		const float hx = (halfEdge + r) * glm::abs(height);
+		const float offsets[TRIANGLE_MOVEMENT_PLANES] = {
+			r * glm::abs(n.z) + (n.y < 0.0f ? -n.y * h : 0.0f),
+			r * glm::abs(n.z) + (n.y > 0.0f ? n.y * h : 0.0f),
+			sideOffset + sideSupport,
+			sideOffset + sideSupport,
+			r,
+			halfEdge + r,
+			halfEdge + r,
+			glm::max(height, 0.0f),
+			glm::max(-height, 0.0f) + h,
+			depth + r,
+			hx,
+			hx,
+			hx + halfEdge * h,
+			hx + halfEdge * h};
+		if (RayTestConvex(normals, offsets, TRIANGLE_MOVEMENT_PLANES,
+						  trans.ToLocal(movementRay), validMovementFactor,
+						  normal)) {
+			normal = trans.rot * normal;
+			return true;
+		}
+		return false;
+	}
+
+	bool OverlapTest(const Transform &trans, const OverlapVolume &volume) const
+	{
+		glm::vec3 v[3];
+		Vertices(v);
+		return OverlapTestConvex(v, 3, 0.0f, volume.ToLocal(trans));
+	}
+
+	bool SphereTestMovement(const Transform &trans, float &validMovementFactor,
+							const Sphere &sph, const RayInfo &movementRay,
+							glm::vec3 &normal) const
+	{
+		glm::vec3 v[3];
+		Vertices(v);
+		if (SweptSphereTestTriangle(v[0], v[1], v[2], sph.radius,
+									trans.ToLocal(movementRay),
+									validMovementFactor, normal)) {
+			normal = trans.rot * normal;
+			return true;
+		}
+		return false;
+	}
+};
+
+#define DEFINE_SPECIALISED_TRIANGLE_METHODS(SHAPE)                             \
+	spp::Aabb SHAPE::GetAabb(const Transform &trans) const                     \
+	{                                                                          \
+		return SpecialisedTriangle<SHAPE>(*this).GetAabb(trans);               \
+	}                                                                          \
+                                                                               \
+	bool SHAPE::RayTest(const Transform &trans, const RayInfo &ray,            \
+						float &near, glm::vec3 &normal) const                  \
+	{                                                                          \
+		if (RayTestLocal(trans.ToLocal(ray), near, normal)) {                  \
+			normal = trans.rot * normal;                                       \
+			return true;                                                       \
+		} else {                                                               \
+			return false;                                                      \
+		}                                                                      \
+	}                                                                          \
+                                                                               \
+	bool SHAPE::RayTestLocal(const RayInfo &ray, float &near,                  \
+							 glm::vec3 &normal) const                          \
+	{                                                                          \
+		return SpecialisedTriangle<SHAPE>(*this).RayTestLocal(ray, near,       \
+															  normal);         \
+	}                                                                          \
+                                                                               \
+	bool SHAPE::OcclusionTest(const Transform &trans, const RayInfo &ray)      \
+		const                                                                  \
+	{                                                                          \
+		float near;                                                            \
+		glm::vec3 normal;                                                      \
+		return RayTestLocal(trans.ToLocal(ray), near, normal);                 \
+	}                                                                          \
+                                                                               \
+	bool SHAPE::OverlapTest(const Transform &trans,                            \
+							const OverlapVolume &volume) const                 \
+	{                                                                          \
+		return SpecialisedTriangle<SHAPE>(*this).OverlapTest(trans, volume);   \
+	}                                                                          \
+                                                                               \
+	bool SHAPE::CylinderTestOnGround(const Transform &trans,                   \
+									 const Cylinder &cyl, glm::vec3 pos,       \
+									 float &offsetHeight,                      \
+									 glm::vec3 *onGroundNormal,                \
+									 bool *isOnEdge) const                     \
+	{                                                                          \
+		return SpecialisedTriangle<SHAPE>(*this).CylinderTestOnGround(         \
+			trans, cyl, pos, offsetHeight, onGroundNormal, isOnEdge);          \
+	}                                                                          \
+                                                                               \
+	bool SHAPE::CylinderTestMovement(                                          \
+		const Transform &trans, float &validMovementFactor,                    \
+		const Cylinder &cyl, const RayInfo &movementRay, glm::vec3 &normal)    \
+		const                                                                  \
+	{                                                                          \
+		return SpecialisedTriangle<SHAPE>(*this).CylinderTestMovement(         \
+			trans, validMovementFactor, cyl, movementRay, normal);             \
+	}                                                                          \
+                                                                               \
+	bool SHAPE::SphereTestMovement(                                            \
+		const Transform &trans, float &validMovementFactor, const Sphere &sph, \
+		const RayInfo &movementRay, glm::vec3 &normal) const                   \
+	{                                                                          \
+		return SpecialisedTriangle<SHAPE>(*this).SphereTestMovement(           \
+			trans, validMovementFactor, sph, movementRay, normal);             \
+	}
+
+DEFINE_SPECIALISED_TRIANGLE_METHODS(Triangle60)
+DEFINE_SPECIALISED_TRIANGLE_METHODS(Triangle90_45)
+
+#undef DEFINE_SPECIALISED_TRIANGLE_METHODS
+} // namespace Collision3D
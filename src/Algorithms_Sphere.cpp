@@ -46,81 +46,49 @@ bool Sphere::RayTestLocal(const RayInfo &ray, float &near,
 	return sphereIntersect(ray, {}, radius, near, normal);
 }
 
+// Segment of ray passes within radius of center
+bool Sphere::OcclusionTest(const Transform &trans, const RayInfo &ray) const
+{
+	const glm::vec3 oc = trans.pos - ray.start;
+	const float dd = glm::dot(ray.dir, ray.dir);
+	const float t =
+		dd > 0.0f ? glm::clamp(glm::dot(oc, ray.dir) / dd, 0.0f, 1.0f) : 0.0f;
+	const glm::vec3 d = oc - ray.dir * t;
+	return glm::dot(d, d) <= radius * radius;
+}
+
+bool Sphere::OverlapTest(const Transform &trans,
+						 const OverlapVolume &volume) const
+{
+	const glm::vec3 center = {0, 0, 0};
+	return OverlapTestConvex(&center, 1, radius, volume.ToLocal(trans));
+}
+
 bool Sphere::CylinderTestOnGround(const Transform &trans, const Cylinder &cyl,
 								  glm::vec3 pos, float &offsetHeight,
 								  glm::vec3 *onGroundNormal,
 								  bool *isOnEdge) const
 {
-	return false;
-	assert(!"Spheres only have ray tes, no movement test.");
-	/*
+	// Base disc of cylinder rests on the highest point of sphere under it
 	const glm::vec3 localPos = pos - trans.pos;
-	const glm::vec3 localPos2d = {localPos.x, 0.0f, localPos.z};
-	const float r2 = glm::length2(localPos2d);
-	if (r2 > radius * radius) {
+	const glm::vec2 localPos2d = {localPos.x, localPos.z};
+	const float len = glm::length(localPos2d);
+	const float d = len > cyl.radius ? len - cyl.radius : 0.0f;
+	if (d > radius) {
 		return false;
 	}
 
-	const float y = sqrt(r2 + localPos.y * localPos.y);
+	const float y = sqrt(radius * radius - d * d);
 	offsetHeight = localPos.y - y;
 
 	if (onGroundNormal) {
-		*onGroundNormal = glm::vec3{localPos2d.x, y, localPos2d.z} / radius;
+		const glm::vec2 h =
+			len > 0.0000001f ? localPos2d * (d / len) : glm::vec2{0, 0};
+		*onGroundNormal = glm::vec3{h.x, y, h.y} / radius;
 	}
 
 	return true;
-	*/
-}
-
-/*
-inline bool CapIntersect(glm::vec3 ro, glm::vec3 rd, glm::vec3 pa, float height,
-				   float radius, float &near, glm::vec3 &normal)
-{
-	const glm::vec3 pb = pa + glm::vec3{0.0f, height, 0.0f};
-	const glm::vec3 ba = pb - pa;
-	const glm::vec3 oa = ro - pa;
-	const float baba = glm::dot(ba, ba);
-	const float bard = glm::dot(ba, rd);
-	const float baoa = glm::dot(ba, oa);
-	const float rdoa = glm::dot(rd, oa);
-	const float oaoa = glm::dot(oa, oa);
-	const float a = baba - bard * bard;
-	float b = baba * rdoa - baoa * bard;
-	float c = baba * oaoa - baoa * baoa - radius * radius * baba;
-	float h = b * b - a * c;
-	if (h >= 0.0f) {
-		const float t = (-b - sqrt(h)) / a;
-		const float y = baoa + t * bard;
-		// body
-		if (y > 0.0f && y < baba) {
-			near = t;
-		} else {
-			// caps
-			const glm::vec3 oc = (y <= 0.0f) ? oa : ro - pb;
-			b = glm::dot(rd, oc);
-			c = glm::dot(oc, oc) - radius * radius;
-			h = b * b - c;
-			if (h > 0.0f) {
-				near = -b - sqrt(h);
-			}
-		}
-
-		if (t > 1.0f) {
-			// hit is too far
-			return false;
-		} else if (t < 0.0f) {
-			// origin may be inside
-			assert(!"Unimplemented");
-			return true;
-		} else {
-			// hit is correct
-			assert(!"Unimplemented");
-			return true;
-		}
-	}
-	return false;
 }
-*/
 
 bool Sphere::CylinderTestMovement(const Transform &trans,
 								  float &validMovementFactor,
@@ -128,7 +96,21 @@ bool Sphere::CylinderTestMovement(const Transform &trans,
 								  const RayInfo &movementRay,
 								  glm::vec3 &normal) const
 {
-	return false;
-	assert(!"Spheres only have ray tes, no movement test.");
+	// Base of cylinder against sphere is ray against cylinder hanging below
+	// sphere center, rounded by sphere radius
+	RayInfo ray = movementRay;
+	ray.start -= trans.pos - glm::vec3{0, cyl.height, 0};
+	return SweptSphereTestCylinder(cyl.height, cyl.radius, radius, ray,
+								   validMovementFactor, normal);
+}
+
+bool Sphere::SphereTestMovement(const Transform &trans,
+								float &validMovementFactor,
+								const Sphere &sph,
+								const RayInfo &movementRay,
+								glm::vec3 &normal) const
+{
+	return SweptSphereTestPoint(trans.pos, radius + sph.radius,
+								movementRay, validMovementFactor, normal);
 }
 } // namespace Collision3D
@@ -0,0 +1,449 @@
+// This file is part of Collision3D.
+// Copyright (c) 2025 Marek Zalewski aka Drwalin
+// You should have received a copy of the MIT License along with this program.
+
+#include "../include/collision3d/CollisionAlgorithms.hpp"
+
+namespace Collision3D
+{
+using namespace spp;
+
+// Tolerance of contact point lying on a face
+static constexpr float FACE_EPSILON = 0.0001f;
+// Bisection steps for roots of polynomials, each halves interval in double
+// precision, 64 steps reach below float resolution of any factor in [0, 1]
+static constexpr int ROOT_ITERATIONS = 64;
+
+static double EvalPolynomial(const double *c, int degree, double t)
+{
+	double v = c[degree];
+	for (int i = degree - 1; i >= 0; --i) {
+		v = v * t + c[i];
+	}
+	return v;
+}
+
+// Root of polynomial monotonic in [a, b] with values of opposite signs
+static double BisectRoot(const double *c, int degree, double a, double b)
+{
+	const bool rising = EvalPolynomial(c, degree, a) < 0.0;
+	for (int i = 0; i < ROOT_ITERATIONS; ++i) {
+		const double m = (a + b) * 0.5;
+		if ((EvalPolynomial(c, degree, m) < 0.0) == rising) {
+			a = m;
+		} else {
+			b = m;
+		}
+	}
+	return b;
+}
+
+// Sorted roots of polynomial c[0] + c[1] t + ... in [a, b]. Roots of
+// derivative split range into monotonic intervals, each holds at most one
+// root, so none can be skipped like with iterative stepping.
+static int PolynomialRoots(const double *c, int degree, double a, double b,
+						   double *roots)
+{
+	if (degree == 1) {
+		if (c[1] == 0.0) {
+			return 0;
+		}
+		const double t = -c[0] / c[1];
+		roots[0] = t;
+		return t >= a && t <= b ? 1 : 0;
+	}
+	double derivative[4];
+	for (int i = 1; i <= degree; ++i) {
+		derivative[i - 1] = c[i] * i;
+	}
+	double points[6];
+	points[0] = a;
+	int count = 1 + PolynomialRoots(derivative, degree - 1, a, b, points + 1);
+	points[count++] = b;
+
+	int rootsCount = 0;
+	double prev = EvalPolynomial(c, degree, a);
+	if (prev == 0.0) {
+		roots[rootsCount++] = a;
+	}
+	for (int i = 1; i < count; ++i) {
+		const double v = EvalPolynomial(c, degree, points[i]);
+		if (v == 0.0) {
+			roots[rootsCount++] = points[i];
+		} else if ((prev < 0.0) != (v < 0.0) && prev != 0.0) {
+			roots[rootsCount++] = BisectRoot(c, degree, points[i - 1], points[i]);
+		}
+		prev = v;
+	}
+	return rootsCount;
+}
+
+// First factor in [t0, t1] at which ray touches torus around horizontal
+// circle of radius R at height 0 with tube radius r. Touching points are
+// roots of (|p|^2 + R^2 - r^2)^2 - 4 R^2 (p.x^2 + p.z^2), which is positive
+// outside of tube, so first root after outside start is the contact. Minima
+// touching zero are found as roots of derivative.
+static bool RayTorusFirstContact(glm::vec3 start, glm::vec3 dir, double R,
+								 double r, double t0, double t1, double &t)
+{
+	const double s[3] = {start.x, start.y, start.z};
+	const double d[3] = {dir.x, dir.y, dir.z};
+	const double a2 = d[0] * d[0] + d[2] * d[2];
+	const double a1 = 2.0 * (s[0] * d[0] + s[2] * d[2]);
+	const double a0 = s[0] * s[0] + s[2] * s[2];
+	const double A = a2 + d[1] * d[1];
+	const double B = a1 + 2.0 * s[1] * d[1];
+	const double C = a0 + s[1] * s[1] + R * R - r * r;
+	const double RR4 = 4.0 * R * R;
+	const double c[5] = {C * C - RR4 * a0, 2.0 * B * C - RR4 * a1,
+						 B * B + 2.0 * A * C - RR4 * a2, 2.0 * A * B, A * A};
+	if (A == 0.0) {
+		return false;
+	}
+	double derivative[4] = {c[1], 2.0 * c[2], 3.0 * c[3], 4.0 * c[4]};
+	double points[5];
+	points[0] = t0;
+	int count = 1 + PolynomialRoots(derivative, 3, t0, t1, points + 1);
+	points[count++] = t1;
+	for (int i = 0; i < count; ++i) {
+		const double v = EvalPolynomial(c, 4, points[i]);
+		if (v <= 0.0) {
+			t = i == 0 ? points[0] : BisectRoot(c, 4, points[i - 1], points[i]);
+			return true;
+		}
+	}
+	return false;
+}
+
+bool SweptSphereTestPoint(glm::vec3 point, float radius, const RayInfo &ray,
+						  float &near, glm::vec3 &normal)
+{
+	const glm::vec3 m = ray.start - point;
+	const float c = glm::dot(m, m) - radius * radius;
+	if (c <= 0.0f) {
+		near = 0.0f;
+		const float len = glm::length(m);
+		normal = len > 0.0000001f ? m / len : glm::vec3{0, 1, 0};
+		return true;
+	}
+	const float a = glm::dot(ray.dir, ray.dir);
+	const float b = glm::dot(m, ray.dir);
+	if (b >= 0.0f || a == 0.0f) {
+		return false;
+	}
+	const float h = b * b - a * c;
+	if (h < 0.0f) {
+		return false;
+	}
+	const float t = (-b - sqrt(h)) / a;
+	if (t > 1.0f) {
+		return false;
+	}
+	near = t;
+	normal = (m + ray.dir * t) / radius;
+	return true;
+}
+
+bool SweptSphereTestSegment(glm::vec3 a, glm::vec3 b, float radius,
+							const RayInfo &ray, float &near,
+							glm::vec3 &normal)
+{
+	// Infinite cylinder around segment, terms are scaled by ee
+	const glm::vec3 e = b - a;
+	const glm::vec3 m = ray.start - a;
+	const float ee = glm::dot(e, e);
+	if (ee == 0.0f) {
+		return SweptSphereTestPoint(a, radius, ray, near, normal);
+	}
+	const float me = glm::dot(m, e);
+	const float de = glm::dot(ray.dir, e);
+	const float c = ee * glm::dot(m, m) - me * me - radius * radius * ee;
+	if (c <= 0.0f) {
+		// start is inside of infinite cylinder
+		if (me < 0.0f || me > ee) {
+			return false;
+		}
+		near = 0.0f;
+		const glm::vec3 out = m - e * (me / ee);
+		const float len = glm::length(out);
+		normal = len > 0.0000001f ? out / len : glm::vec3{0, 1, 0};
+		return true;
+	}
+	const float A = ee * glm::dot(ray.dir, ray.dir) - de * de;
+	const float B = ee * glm::dot(m, ray.dir) - me * de;
+	if (A <= 0.0f || B >= 0.0f) {
+		return false;
+	}
+	const float h = B * B - A * c;
+	if (h < 0.0f) {
+		return false;
+	}
+	const float t = (-B - sqrt(h)) / A;
+	if (t > 1.0f) {
+		return false;
+	}
+	const float u = me + t * de;
+	if (u < 0.0f || u > ee) {
+		return false;
+	}
+	near = t;
+	normal = (m + ray.dir * t - e * (u / ee)) / radius;
+	return true;
+}
+
+// Minkowski sum of polyhedron and sphere is union of faces moved by radius,
+// cylinders around edges and spheres around vertices. Each of them gives
+// only real contacts, so the earliest one is the first contact.
+bool SweptSphereTestConvex(const glm::vec3 *normals, const float *offsets,
+						   int planesCount, const glm::vec3 *vertices,
+						   int verticesCount, const uint8_t (*edges)[2],
+						   int edgesCount, float radius, const RayInfo &ray,
+						   float &near, glm::vec3 &normal)
+{
+	int maxId = 0;
+	float maxDist = glm::dot(ray.start, normals[0]) - offsets[0];
+	for (int i = 1; i < planesCount; ++i) {
+		const float dist = glm::dot(ray.start, normals[i]) - offsets[i];
+		if (dist > maxDist) {
+			maxDist = dist;
+			maxId = i;
+		}
+	}
+	if (maxDist <= 0.0f) {
+		// center is inside
+		near = 0.0f;
+		normal = normals[maxId];
+		return true;
+	}
+	if (maxDist > radius + glm::length(ray.dir)) {
+		return false;
+	}
+
+	bool res = false;
+	for (int i = 0; i < planesCount; ++i) {
+		const glm::vec3 n = normals[i];
+		const float dist = glm::dot(ray.start, n) - offsets[i];
+		float t;
+		if (dist < 0.0f) {
+			continue;
+		} else if (dist <= radius) {
+			t = 0.0f;
+		} else {
+			const float vd = glm::dot(ray.dir, n);
+			if (vd >= 0.0f) {
+				continue;
+			}
+			t = (radius - dist) / vd;
+			if (t > 1.0f || (res && t >= near)) {
+				continue;
+			}
+		}
+		const glm::vec3 q = ray.start + ray.dir * t - n * (dist + t * glm::dot(ray.dir, n));
+		bool onFace = true;
+		for (int j = 0; j < planesCount; ++j) {
+			if (j != i && glm::dot(q, normals[j]) > offsets[j] + FACE_EPSILON) {
+				onFace = false;
+				break;
+			}
+		}
+		if (onFace) {
+			near = t;
+			normal = n;
+			res = true;
+			if (t == 0.0f) {
+				return true;
+			}
+		}
+	}
+
+	float ne;
+	glm::vec3 no;
+	for (int i = 0; i < edgesCount; ++i) {
+		if (SweptSphereTestSegment(vertices[edges[i][0]],
+								   vertices[edges[i][1]], radius, ray, ne,
+								   no)) {
+			if (res == false || ne < near) {
+				near = ne;
+				normal = no;
+				res = true;
+			}
+		}
+	}
+	for (int i = 0; i < verticesCount; ++i) {
+		if (SweptSphereTestPoint(vertices[i], radius, ray, ne, no)) {
+			if (res == false || ne < near) {
+				near = ne;
+				normal = no;
+				res = true;
+			}
+		}
+	}
+	return res;
+}
+
+bool SweptSphereTestTriangle(glm::vec3 a, glm::vec3 b, glm::vec3 c,
+							 float radius, const RayInfo &ray, float &near,
+							 glm::vec3 &normal)
+{
+	const glm::vec3 vertices[3] = {a, b, c};
+	glm::vec3 n = glm::cross(b - a, c - a);
+	const float len = glm::length(n);
+	if (len == 0.0f) {
+		// degenerate, only edges
+		bool res = false;
+		float ne;
+		glm::vec3 no;
+		for (int i = 0; i < 3; ++i) {
+			if (SweptSphereTestSegment(vertices[TRIANGLE_EDGES[i][0]],
+									   vertices[TRIANGLE_EDGES[i][1]], radius,
+									   ray, ne, no)) {
+				if (res == false || ne < near) {
+					near = ne;
+					normal = no;
+					res = true;
+				}
+			}
+		}
+		return res;
+	}
+	n /= len;
+
+	// two sides of triangle and planes through edges
+	glm::vec3 normals[5] = {n, -n};
+	float offsets[5] = {glm::dot(n, a), -glm::dot(n, a)};
+	for (int i = 0; i < 3; ++i) {
+		const glm::vec3 p = vertices[TRIANGLE_EDGES[i][0]];
+		const glm::vec3 q = vertices[TRIANGLE_EDGES[i][1]];
+		const glm::vec3 side = glm::normalize(glm::cross(q - p, n));
+		const float s = glm::dot(side, vertices[(i + 2) % 3] - p) > 0.0f ? -1.0f
+																		: 1.0f;
+		normals[2 + i] = side * s;
+		offsets[2 + i] = glm::dot(normals[2 + i], p);
+	}
+	return SweptSphereTestConvex(normals, offsets, 5, vertices, 3,
+								 TRIANGLE_EDGES, 3, radius, ray, near, normal);
+}
+
+bool SweptSphereTestCylinder(float height, float cylinderRadius, float radius,
+							 const RayInfo &ray, float &near,
+							 glm::vec3 &normal)
+{
+	const glm::vec3 s = ray.start;
+	const glm::vec3 d = ray.dir;
+	const float R = cylinderRadius;
+	const float rho = sqrt(s.x * s.x + s.z * s.z);
+	const glm::vec3 horizontal =
+		rho > 0.0000001f ? glm::vec3{s.x / rho, 0, s.z / rho}
+						 : glm::vec3{1, 0, 0};
+
+	// overlap at start
+	{
+		const float dx = rho - R;
+		const float dy = s.y < 0.0f ? s.y : (s.y > height ? s.y - height : 0.0f);
+		if (dx <= 0.0f && dy == 0.0f) {
+			near = 0.0f;
+			const float side = R - rho, bottom = s.y, top = height - s.y;
+			if (side <= bottom && side <= top) {
+				normal = horizontal;
+			} else {
+				normal = {0, top < bottom ? 1.0f : -1.0f, 0};
+			}
+			return true;
+		}
+		const float hx = dx > 0.0f ? dx : 0.0f;
+		if (hx * hx + dy * dy <= radius * radius) {
+			near = 0.0f;
+			normal = glm::normalize(horizontal * hx + glm::vec3{0, dy, 0});
+			return true;
+		}
+	}
+
+	bool res = false;
+
+	// side
+	{
+		const float Rr = R + radius;
+		const float a = d.x * d.x + d.z * d.z;
+		const float b = s.x * d.x + s.z * d.z;
+		const float c = rho * rho - Rr * Rr;
+		if (a > 0.0f && b < 0.0f && c > 0.0f) {
+			const float h = b * b - a * c;
+			if (h >= 0.0f) {
+				const float t = (-b - sqrt(h)) / a;
+				const glm::vec3 p = s + d * t;
+				if (t <= 1.0f && p.y >= 0.0f && p.y <= height) {
+					near = t;
+					normal = glm::vec3{p.x, 0, p.z} / Rr;
+					res = true;
+				}
+			}
+		}
+	}
+
+	// caps
+	{
+		float t = 2.0f;
+		float ny = 0.0f;
+		if (d.y < 0.0f && s.y > height + radius) {
+			t = (height + radius - s.y) / d.y;
+			ny = 1.0f;
+		} else if (d.y > 0.0f && s.y < -radius) {
+			t = (-radius - s.y) / d.y;
+			ny = -1.0f;
+		}
+		if (t <= 1.0f && (res == false || t < near)) {
+			const glm::vec3 p = s + d * t;
+			if (p.x * p.x + p.z * p.z <= R * R) {
+				near = t;
+				normal = {0, ny, 0};
+				res = true;
+			}
+		}
+	}
+
+	// rims, tori around both edge circles of cylinder
+	if (d == glm::vec3{0, 0, 0}) {
+		return res;
+	}
+	const float rims[2] = {0.0f, height};
+	if (R <= 0.0f) {
+		// rims are points, quartic would only touch zero at contact
+		for (const float y0 : rims) {
+			float ne;
+			glm::vec3 no;
+			if (SweptSphereTestPoint({0, y0, 0}, radius, ray, ne, no)) {
+				if (res == false || ne < near) {
+					near = ne;
+					normal = no;
+					res = true;
+				}
+			}
+		}
+		return res;
+	}
+	for (const float y0 : rims) {
+		float t0 = 0.0f, t1 = res ? near : 1.0f;
+		if (d.y != 0.0f) {
+			const float a = (y0 - radius - s.y) / d.y;
+			const float b = (y0 + radius - s.y) / d.y;
+			t0 = glm::max(t0, glm::min(a, b));
+			t1 = glm::min(t1, glm::max(a, b));
+		} else if (fabs(s.y - y0) > radius) {
+			continue;
+		}
+		double t;
+		if (t0 > t1 || !RayTorusFirstContact(s - glm::vec3{0, y0, 0}, d, R,
+											 radius, t0, t1, t)) {
+			continue;
+		}
+		const glm::vec3 p = s + d * (float)t;
+		const float pr = sqrt(p.x * p.x + p.z * p.z);
+		const glm::vec3 h = pr > 0.0000001f ? glm::vec3{p.x / pr, 0, p.z / pr}
+											: glm::vec3{1, 0, 0};
+		near = t;
+		normal = glm::normalize(h * (pr - R) + glm::vec3{0, p.y - y0, 0});
+		res = true;
+	}
+	return res;
+}
+} // namespace Collision3D
@@ -0,0 +1,401 @@
+// This file is part of Collision3D.
+// Copyright (c) 2025 Marek Zalewski aka Drwalin
+// You should have received a copy of the MIT License along with this program.
+
+#include "../include/collision3d/CollisionShapes_AnyOrCompound.hpp"
+
+namespace Collision3D
+{
+using namespace spp;
+
+// Two sided Moller-Trumbore, normal faces ray start
+static bool RayTestTriangle(const glm::vec3 *v, const RayInfo &ray,
+							float &near, glm::vec3 &normal)
+{
+	const glm::vec3 e1 = v[1] - v[0];
+	const glm::vec3 e2 = v[2] - v[0];
+	const glm::vec3 p = glm::cross(ray.dir, e2);
+	const float det = glm::dot(e1, p);
+	if (det == 0.0f) {
+		return false;
+	}
+	const float invDet = 1.0f / det;
+	const glm::vec3 s = ray.start - v[0];
+	const float u = glm::dot(s, p) * invDet;
+	if (u < 0.0f || u > 1.0f) {
+		return false;
+	}
+	const glm::vec3 q = glm::cross(s, e1);
+	const float w = glm::dot(ray.dir, q) * invDet;
+	if (w < 0.0f || u + w > 1.0f) {
+		return false;
+	}
+	const float t = glm::dot(e2, q) * invDet;
+	if (t < 0.0f || t > 1.0f) {
+		return false;
+	}
+	near = t;
+	normal = glm::normalize(glm::cross(e1, e2));
+	if (det < 0.0f) {
+		normal = -normal;
+	}
+	return true;
+}
+
+TriangleMesh::~TriangleMesh() { Release(); }
+
+TriangleMesh::TriangleMesh(TriangleMesh &other)
+	: TriangleMesh((const TriangleMesh &)other)
+{
+}
+
+TriangleMesh::TriangleMesh(TriangleMesh &&other) : data(other.data)
+{
+	other.data = nullptr;
+}
+
+TriangleMesh::TriangleMesh(const TriangleMesh &other) : data(other.data)
+{
+	if (data) {
+		data->references.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+TriangleMesh &TriangleMesh::operator=(TriangleMesh &other)
+{
+	return *this = (const TriangleMesh &)other;
+}
+
+TriangleMesh &TriangleMesh::operator=(TriangleMesh &&other)
+{
+	if (this != &other) {
+		Release();
+		data = other.data;
+		other.data = nullptr;
+	}
+	return *this;
+}
+
+TriangleMesh &TriangleMesh::operator=(const TriangleMesh &other)
+{
+	// Release() clears other.data on self assignment
+	TriangleMesh_Data *shared = other.data;
+	if (shared) {
+		shared->references.fetch_add(1, std::memory_order_relaxed);
+	}
+	Release();
+	data = shared;
+	return *this;
+}
+
+void TriangleMesh::Release()
+{
+	if (data) {
+		if (data->references.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+			delete data;
+		}
+		data = nullptr;
+	}
+}
+
+void TriangleMesh::Build(const glm::vec3 *vertices, uint32_t verticesCount,
+						 const uint32_t *indices, uint32_t trianglesCount,
+						 BvhNodeFormat format, BvhBuilder builder)
+{
+	Release();
+	if (trianglesCount == 0) {
+		return;
+	}
+
+	data = new TriangleMesh_Data();
+	data->vertices.assign(vertices, vertices + verticesCount);
+	data->indices.assign(indices, indices + trianglesCount * 3);
+
+	std::vector<spp::Aabb> aabbs(trianglesCount);
+	glm::vec3 v[3];
+	for (uint32_t i = 0; i < trianglesCount; ++i) {
+		assert(indices[i * 3] < verticesCount);
+		assert(indices[i * 3 + 1] < verticesCount);
+		assert(indices[i * 3 + 2] < verticesCount);
+		GetTriangle(i, v);
+		aabbs[i] = {glm::min(v[0], glm::min(v[1], v[2])),
+					glm::max(v[0], glm::max(v[1], v[2]))};
+	}
+	data->compactBvh.Build(aabbs.data(), trianglesCount, format, builder);
+}
+
+spp::Aabb TriangleMesh::GetAabb(const Transform &trans) const
+{
+	if (data == nullptr) {
+		return spp::AABB_INVALID;
+	}
+	// Rotation is only around y, transforming 4 corners is enough
+	const spp::Aabb local = data->compactBvh.GetTotalAabb();
+	spp::Aabb aabb = spp::AABB_INVALID;
+	for (int i = 0; i < 4; ++i) {
+		const glm::vec3 corner = {i & 1 ? local.max.x : local.min.x, 0,
+								  i & 2 ? local.max.z : local.min.z};
+		const glm::vec3 p = trans * corner;
+		aabb = aabb + spp::Aabb{p, p};
+	}
+	aabb.min.y = local.min.y + trans.pos.y;
+	aabb.max.y = local.max.y + trans.pos.y;
+	return aabb;
+}
+
+bool TriangleMesh::RayTest(const Transform &trans, const RayInfo &ray,
+						   float &near, glm::vec3 &normal) const
+{
+	if (RayTestLocal(trans.ToLocal(ray), near, normal)) {
+		normal = trans.rot * normal;
+		return true;
+	} else {
+		return false;
+	}
+}
+
+bool TriangleMesh::RayTestLocal(const RayInfo &ray, float &near,
+								glm::vec3 &normal) const
+{
+	if (data == nullptr) {
+		return false;
+	}
+	bool res = false;
+	float cutFactor = 1.0f;
+	data->compactBvh.IntersectRay(ray, cutFactor, [&](uint32_t id, float &cut) {
+		glm::vec3 v[3];
+		GetTriangle(id, v);
+		float ne;
+		glm::vec3 no;
+		if (RayTestTriangle(v, ray, ne, no)) {
+			if (ne <= cut) {
+				normal = no;
+				cut = ne;
+				res = true;
+			}
+		}
+		return false;
+	});
+	near = cutFactor;
+	return res;
+}
+
+bool TriangleMesh::OcclusionTest(const Transform &trans,
+								 const RayInfo &ray) const
+{
+	if (data == nullptr) {
+		return false;
+	}
+	const RayInfo localRay = trans.ToLocal(ray);
+	bool res = false;
+	float cutFactor = 1.0f;
+	data->compactBvh.IntersectRay(
+		localRay, cutFactor, [&](uint32_t id, float &) {
+			glm::vec3 v[3];
+			GetTriangle(id, v);
+			float ne;
+			glm::vec3 no;
+			res = RayTestTriangle(v, localRay, ne, no);
+			return res;
+		});
+	return res;
+}
+
+void TriangleMesh::RayTestAll(const Transform &trans, const RayInfo &ray,
+							  RayHitBuffer &hits) const
+{
+	if (data == nullptr) {
+		return;
+	}
+	const RayInfo localRay = trans.ToLocal(ray);
+	float cutFactor = hits.CutFactor();
+	data->compactBvh.IntersectRay(
+		localRay, cutFactor, [&](uint32_t id, float &cut) {
+			glm::vec3 v[3];
+			GetTriangle(id, v);
+			float ne;
+			glm::vec3 no;
+			if (RayTestTriangle(v, localRay, ne, no)) {
+				if (hits.Add({ne, trans.rot * no, id})) {
+					cut = hits.CutFactor();
+				}
+			}
+			return false;
+		});
+}
+
+bool TriangleMesh::OverlapTest(const Transform &trans,
+							   const OverlapVolume &volume) const
+{
+	uint32_t id;
+	return OverlapAll(trans, volume, &id, 1) != 0;
+}
+
+uint32_t TriangleMesh::OverlapAll(const Transform &trans,
+								  const OverlapVolume &volume, uint32_t *ids,
+								  uint32_t maxIds) const
+{
+	if (data == nullptr || maxIds == 0) {
+		return 0;
+	}
+	const OverlapVolume local = volume.ToLocal(trans);
+	uint32_t found = 0;
+	data->compactBvh.IntersectAabb(local.GetAabb(), [&](uint32_t id) {
+		glm::vec3 v[3];
+		GetTriangle(id, v);
+		if (OverlapTestConvex(v, 3, 0.0f, local)) {
+			ids[found++] = id;
+		}
+		return found >= maxIds;
+	});
+	return found;
+}
+
+bool TriangleMesh::CylinderTestOnGround(const Transform &trans,
+										const Cylinder &cyl, glm::vec3 pos,
+										float &offsetHeight,
+										glm::vec3 *onGroundNormal,
+										bool *isOnEdge) const
+{
+	if (data == nullptr) {
+		return false;
+	}
+	const glm::vec3 localPos = trans.ToLocal(pos);
+	const glm::vec2 p{localPos.x, localPos.z};
+	const float r = cyl.radius + ON_EDGE_FACTOR;
+	const spp::Aabb column = LocalGroundColumn(trans, cyl, pos);
+
+	// Same as for compounds, lowest ground under footprint is chosen
+	bool res = false;
+	data->compactBvh.IntersectAabb(column, [&](uint32_t id) {
+		glm::vec3 v[3];
+		GetTriangle(id, v);
+		glm::vec3 n = glm::cross(v[1] - v[0], v[2] - v[0]);
+		if (n.y < 0.0f) {
+			n = -n;
+		}
+		if (IsGroundNormal(n) == false) {
+			return false;
+		}
+
+		// Nearest point of triangle in XZ
+		const glm::vec2 t[3] = {
+			{v[0].x, v[0].z}, {v[1].x, v[1].z}, {v[2].x, v[2].z}};
+		bool inside = true;
+		float best = 1e30f;
+		glm::vec2 q = p;
+		for (int i = 0; i < 3; ++i) {
+			const glm::vec2 a = t[i];
+			const glm::vec2 e = t[(i + 1) % 3] - a;
+			const glm::vec2 o = t[(i + 2) % 3] - a;
+			const float side = e.x * (p.y - a.y) - e.y * (p.x - a.x);
+			if (side * (e.x * o.y - e.y * o.x) < 0.0f) {
+				inside = false;
+			}
+			const float ee = glm::dot(e, e);
+			const float f = ee > 0.0f
+								? glm::clamp(glm::dot(p - a, e) / ee, 0.0f, 1.0f)
+								: 0.0f;
+			const glm::vec2 c = a + e * f;
+			const float d = glm::dot(p - c, p - c);
+			if (d < best) {
+				best = d;
+				q = c;
+			}
+		}
+		if (inside) {
+			q = p;
+		}
+		const float dist = glm::distance(p, q);
+		if (dist > r) {
+			return false;
+		}
+
+		const float y =
+			v[0].y - (n.x * (q.x - v[0].x) + n.z * (q.y - v[0].z)) / n.y;
+		const float ofh = localPos.y - y;
+		if (res == false || offsetHeight < ofh) {
+			offsetHeight = ofh;
+			if (onGroundNormal) {
+				*onGroundNormal = trans.rot * glm::normalize(n);
+			}
+			if (isOnEdge) {
+				*isOnEdge = dist > cyl.radius;
+			}
+			res = true;
+		}
+		return false;
+	});
+	return res;
+}
+
+bool TriangleMesh::CylinderTestMovement(const Transform &trans,
+										float &validMovementFactor,
+										const Cylinder &cyl,
+										const RayInfo &movementRay,
+										glm::vec3 &normal) const
+{
+	if (data == nullptr) {
+		return false;
+	}
+	const RayInfo localRay = trans.ToLocal(movementRay);
+	bool res = false;
+	data->compactBvh.IntersectAabb(
+		LocalMovementAabb(trans, cyl, movementRay), [&](uint32_t id) {
+			glm::vec3 v[3];
+			GetTriangle(id, v);
+			float vmf;
+			glm::vec3 no;
+			if (CylinderTestMovementTriangle(v[0], v[1], v[2], cyl.radius,
+											 cyl.height, localRay, vmf, no)) {
+				if (res == false || validMovementFactor > vmf) {
+					validMovementFactor = vmf;
+					normal = no;
+					res = true;
+				}
+			}
+			return false;
+		});
+	if (res) {
+		normal = trans.rot * normal;
+	}
+	return res;
+}
+
+bool TriangleMesh::SphereTestMovement(const Transform &trans,
+									  float &validMovementFactor,
+									  const Sphere &sph,
+									  const RayInfo &movementRay,
+									  glm::vec3 &normal) const
+{
+	if (data == nullptr) {
+		return false;
+	}
+	const RayInfo localRay = trans.ToLocal(movementRay);
+	bool res = false;
+	float cutFactor = 1.0f;
+	data->compactBvh.IntersectRay(
+		localRay, cutFactor,
+		[&](uint32_t id, float &cut) {
+			glm::vec3 v[3];
+			GetTriangle(id, v);
+			float vmf;
+			glm::vec3 no;
+			if (SweptSphereTestTriangle(v[0], v[1], v[2], sph.radius, localRay,
+										vmf, no)) {
+				if (vmf <= cut) {
+					normal = no;
+					cut = vmf;
+					res = true;
+				}
+			}
+			return false;
+		},
+		LAYER_MASK_ALL, sph.radius);
+	if (res) {
+		validMovementFactor = cutFactor;
+		normal = trans.rot * normal;
+	}
+	return res;
+}
+} // namespace Collision3D
@@ -8,128 +8,24 @@ namespace Collision3D
 {
 using namespace spp;
 
-spp::Aabb VertBox::GetAabb(const Transform &trans) const
+bool VertBox::OcclusionTest(const Transform &trans, const RayInfo &ray) const
 {
-	Rotation rot = trans.rot;
-	if (rot.value >= 120) {
-		rot.value -= 120;
-	}
-
-	glm::vec3 min = trans.pos, max = trans.pos;
-	max.y += halfExtents.y * 2.0f;
-
-	const glm::vec2 x = rot * glm::vec2{halfExtents.x, 0};
-	const glm::vec2 z = rot * glm::vec2{0, halfExtents.z};
-
-	const glm::vec2 a = glm::abs(x + z);
-	const glm::vec2 b = glm::abs(x - z);
-	const glm::vec2 c = glm::abs(-x + z);
-	const glm::vec2 d = glm::abs(-x - z);
-
-	const glm::vec2 min2 = glm::max(a, glm::max(b, glm::max(c, d)));
-
-	min.x -= min2.x;
-	min.z -= min2.y;
-	max.x += min2.x;
-	max.z += min2.y;
-
-	return {min, max};
+	float near;
+	glm::vec3 normal;
+	// slab test does not limit hit to the ray segment
+	return RayTestLocal(trans.ToLocal(ray), near, normal) && near <= 1.0f;
 }
 
-static inline bool FastRayTest2(const glm::vec3 min, const glm::vec3 max,
-								const RayInfo &ray, float &near,
-								glm::vec3 &normal)
+bool VertBox::OverlapTest(const Transform &trans,
+						  const OverlapVolume &volume) const
 {
-	assert(glm::all(glm::lessThanEqual(min, max)));
-	alignas(16) glm::vec3 bounds[2] = {min, max};
-	alignas(16) glm::vec3 tmin, tmax;
-
-	int normalAxis = 0;
-
-	for (int i = 0; i < 2; ++i) {
-		tmin[i] = (bounds[ray.signs[i]][i] - ray.start[i]) * ray.invDir[i];
-		tmax[i] = (bounds[1 - ray.signs[i]][i] - ray.start[i]) * ray.invDir[i];
-	}
-
-	if ((tmin.x > tmax.y) || (tmin.y > tmax.x))
-		return false;
-
-	if (tmin.y > tmin.x) {
-		tmin.x = tmin.y;
-		normalAxis = 1;
-	}
-
-	if (tmax.y < tmax.x) {
-		tmax.x = tmax.y;
-	}
-
-	for (int i = 2; i < 3; ++i) {
-		tmin[i] = (bounds[ray.signs[i]][i] - ray.start[i]) * ray.invDir[i];
-		tmax[i] = (bounds[1 - ray.signs[i]][i] - ray.start[i]) * ray.invDir[i];
-	}
-
-	if ((tmin.x > tmax.z) || (tmin.z > tmax.x)) {
-		return false;
-	}
-
-	if (tmin.z > tmin.x) {
-		normalAxis = 2;
-		tmin.x = tmin.z;
-	}
-	if (tmax.z < tmax.x) {
-		tmax.x = tmax.z;
+	glm::vec3 vertices[8];
+	for (int i = 0; i < 8; ++i) {
+		vertices[i] = {i & 1 ? halfExtents.x : -halfExtents.x,
+					   i & 2 ? halfExtents.y * 2.0f : 0.0f,
+					   i & 4 ? halfExtents.z : -halfExtents.z};
 	}
-	near = tmin.x;
-	float far = tmax.x;
-
-	if (far < 0.0f)
-		return false;
-
-	if (near > far)
-		return false;
-
-	if (near <= 0.0f) {
-		near = 0.0f;
-
-		const glm::vec3 out[2] = {max - ray.start, min - ray.start};
-		const float o[5] = {out[0].x, out[0].z, out[1].x, out[1].z, out[0].y};
-		int id = 0;
-		for (int i = 1; i < 5; ++i) {
-			if (fabs(o[id]) > fabs(o[i])) {
-				id = i;
-			}
-		}
-		normal = {0, 0, 0};
-		normal[(id % 2) * 2] = (id / 2) ? -1 : 1;
-	} else {
-		normal = {0, 0, 0};
-		normal[normalAxis] = ray.signs[normalAxis] ? 1 : -1;
-		assert(glm::dot(normal, ray.dir) < 0);
-	}
-
-	return true;
-}
-
-bool VertBox::RayTest(const Transform &trans, const RayInfo &ray, float &near,
-					  glm::vec3 &normal) const
-{
-	if (RayTestLocal(trans.ToLocal(ray), near, normal)) {
-		normal = trans.rot * normal;
-		return true;
-	} else {
-		return false;
-	}
-}
-
-bool VertBox::RayTestLocal(const RayInfo &ray, float &near,
-						   glm::vec3 &normal) const
-{
-	glm::vec3 he = halfExtents;
-	glm::vec3 min = -he;
-	glm::vec3 max = he;
-	min.y += halfExtents.y;
-	max.y += halfExtents.y;
-	return FastRayTest2(min, max, ray, near, normal);
+	return OverlapTestConvex(vertices, 8, 0.0f, volume.ToLocal(trans));
 }
 
 bool VertBox::CylinderTestOnGround(const Transform &trans, const Cylinder &cyl,
@@ -164,31 +60,27 @@ void VertBox::CylinderTestOnGroundAssumeCollision2D(const Transform &trans,
 	offsetHeight = pos.y - (halfExtents.y * 2.0f);
 }
 
-bool VertBox::CylinderTestMovement(const Transform &trans,
-								   float &validMovementFactor,
-								   const Cylinder &cyl,
-								   const RayInfo &movementRay,
-								   glm::vec3 &normal) const
+bool VertBox::SphereTestMovement(const Transform &trans,
+								 float &validMovementFactor,
+								 const Sphere &sph,
+								 const RayInfo &movementRay,
+								 glm::vec3 &normal) const
 {
-	RayInfo movementRayLocal = trans.ToLocal(movementRay);
-
-	glm::vec3 he = halfExtents + glm::vec3(cyl.radius, 0, cyl.radius);
-	glm::vec3 min = -he;
-	glm::vec3 max = he;
-	min.y += halfExtents.y;
-	max.y += halfExtents.y;
-	min.y -= cyl.height;
-	if (FastRayTest2(min, max, movementRayLocal, validMovementFactor, normal)) {
-		if (validMovementFactor > 1.0f) {
-			validMovementFactor = 1.0f;
-			return false;
-		}
-		assert(validMovementFactor >= 0.0f);
+	const glm::vec3 he = halfExtents;
+	const glm::vec3 n[6] = {{1, 0, 0},	{-1, 0, 0}, {0, 1, 0},
+							{0, -1, 0}, {0, 0, 1},	{0, 0, -1}};
+	const float offs[6] = {he.x, he.x, he.y * 2.0f, 0.0f, he.z, he.z};
+	glm::vec3 vertices[8];
+	for (int i = 0; i < 8; ++i) {
+		vertices[i] = {i & 1 ? he.x : -he.x, i & 2 ? he.y * 2.0f : 0.0f,
+					   i & 4 ? he.z : -he.z};
+	}
+	if (SweptSphereTestConvex(n, offs, 6, vertices, 8, HEXAHEDRON_EDGES, 12,
+							  sph.radius, trans.ToLocal(movementRay),
+							  validMovementFactor, normal)) {
 		normal = trans.rot * normal;
 		return true;
-	} else {
-		validMovementFactor = 1.0f;
-		return false;
 	}
+	return false;
 }
 } // namespace Collision3D
@@ -0,0 +1,143 @@
+// This file is part of Collision3D.
+// Copyright (c) 2025 Marek Zalewski aka Drwalin
+// You should have received a copy of the MIT License along with this program.
+
+#include "../include/collision3d/CollisionShapes_Primitives.hpp"
+
+namespace Collision3D
+{
+using namespace spp;
+
+spp::Aabb VerticalCapsule::GetAabb(const Transform &trans) const
+{
+	glm::vec3 min = trans.pos - glm::vec3{radius, 0, radius};
+	glm::vec3 max = trans.pos + glm::vec3{radius, height, radius};
+	return {min, max};
+}
+
+// Swept sphere of given radius against axis segment of capsule, ray is
+// relative to origin of capsule
+static bool capsuleIntersect(float height, float capsuleRadius, float radius,
+							 const RayInfo &ray, float &near,
+							 glm::vec3 &normal)
+{
+	const glm::vec3 a = {0, capsuleRadius, 0};
+	const glm::vec3 b = {0, glm::max(height - capsuleRadius, capsuleRadius), 0};
+	bool res = false;
+	float ne;
+	glm::vec3 no;
+	if (SweptSphereTestSegment(a, b, radius, ray, ne, no)) {
+		near = ne;
+		normal = no;
+		res = true;
+	}
+	if (SweptSphereTestPoint(a, radius, ray, ne, no)) {
+		if (res == false || ne < near) {
+			near = ne;
+			normal = no;
+			res = true;
+		}
+	}
+	if (SweptSphereTestPoint(b, radius, ray, ne, no)) {
+		if (res == false || ne < near) {
+			near = ne;
+			normal = no;
+			res = true;
+		}
+	}
+	return res;
+}
+
+bool VerticalCapsule::RayTest(const Transform &trans, const RayInfo &ray,
+							  float &near, glm::vec3 &normal) const
+{
+	RayInfo r = ray;
+	r.start -= trans.pos;
+	return capsuleIntersect(height, radius, radius, r, near, normal);
+}
+
+bool VerticalCapsule::RayTestLocal(const RayInfo &ray, float &near,
+								   glm::vec3 &normal) const
+{
+	return capsuleIntersect(height, radius, radius, ray, near, normal);
+}
+
+bool VerticalCapsule::OcclusionTest(const Transform &trans,
+									const RayInfo &ray) const
+{
+	float near;
+	glm::vec3 normal;
+	return RayTest(trans, ray, near, normal);
+}
+
+// Segment between centers of hemispheres rounded by radius
+bool VerticalCapsule::OverlapTest(const Transform &trans,
+								  const OverlapVolume &volume) const
+{
+	const glm::vec3 segment[2] = {{0, radius, 0},
+								  {0, glm::max(height - radius, radius), 0}};
+	return OverlapTestConvex(segment, 2, radius, volume.ToLocal(trans));
+}
+
+bool VerticalCapsule::CylinderTestOnGround(const Transform &trans,
+										   const Cylinder &cyl, glm::vec3 pos,
+										   float &offsetHeight,
+										   glm::vec3 *onGroundNormal,
+										   bool *isOnEdge) const
+{
+	// Base disc of cylinder rests on the highest point of upper hemisphere
+	const glm::vec3 localPos = pos - trans.pos;
+	const glm::vec2 localPos2d = {localPos.x, localPos.z};
+	const float len = glm::length(localPos2d);
+	const float d = len > cyl.radius ? len - cyl.radius : 0.0f;
+	if (d > radius + ON_EDGE_FACTOR) {
+		return false;
+	}
+
+	const float dc = glm::min(d, radius);
+	const float y = sqrt(radius * radius - dc * dc);
+	const float top = glm::max(height - radius, radius);
+	offsetHeight = localPos.y - top - y;
+
+	if (onGroundNormal) {
+		const glm::vec2 h =
+			len > 0.0000001f ? localPos2d * (dc / len) : glm::vec2{0, 0};
+		*onGroundNormal = glm::vec3{h.x, y, h.y} / radius;
+	}
+
+	if (isOnEdge) {
+		if (d > radius) {
+			*isOnEdge = true;
+		}
+	}
+
+	return true;
+}
+
+// Minkowski sum of axis segment with cylinder is taller cylinder, rounded by
+// capsule radius
+bool VerticalCapsule::CylinderTestMovement(const Transform &trans,
+										   float &validMovementFactor,
+										   const Cylinder &cyl,
+										   const RayInfo &movementRay,
+										   glm::vec3 &normal) const
+{
+	const float segment = glm::max(height - radius * 2.0f, 0.0f);
+	RayInfo ray = movementRay;
+	ray.start -= trans.pos + glm::vec3{0, radius - cyl.height, 0};
+	return SweptSphereTestCylinder(segment + cyl.height, cyl.radius, radius,
+								   ray, validMovementFactor, normal);
+}
+
+bool VerticalCapsule::SphereTestMovement(const Transform &trans,
+										 float &validMovementFactor,
+										 const Sphere &sph,
+										 const RayInfo &movementRay,
+										 glm::vec3 &normal) const
+{
+	RayInfo ray = movementRay;
+	ray.start -= trans.pos;
+	return capsuleIntersect(height, radius, radius + sph.radius, ray,
+							validMovementFactor, normal);
+}
+} // namespace Collision3D
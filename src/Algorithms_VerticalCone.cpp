@@ -0,0 +1,257 @@
+// This file is part of Collision3D.
+// Copyright (c) 2025 Marek Zalewski aka Drwalin
+// You should have received a copy of the MIT License along with this program.
+
+#include "../include/collision3d/CollisionShapes_Primitives.hpp"
+
+namespace Collision3D
+{
+using namespace spp;
+
+spp::Aabb VerticalCone::GetAabb(const Transform &trans) const
+{
+	const float r = glm::max(bottomRadius, topRadius);
+	glm::vec3 min = trans.pos - glm::vec3{r, 0, r};
+	glm::vec3 max = trans.pos + glm::vec3{r, height, r};
+	return {min, max};
+}
+
+// Capped cone from pos up to pos + (0, height, 0), based on iq capped cone
+static bool coneIntersect(const RayInfo &ray, glm::vec3 pos, float height,
+						  float ra, float rb, float &near, glm::vec3 &normal)
+{
+	const glm::vec3 oa = ray.start - pos;
+	const float rr = ra - rb;
+
+	// inside
+	if (oa.y >= 0.0f && oa.y <= height && height > 0.0f) {
+		const float rho = glm::length(glm::vec2{oa.x, oa.z});
+		const float radius = ra - rr * (oa.y / height);
+		if (rho <= radius) {
+			near = 0.0f;
+			const glm::vec3 horizontal =
+				rho > 0.0000001f ? glm::vec3{oa.x / rho, 0, oa.z / rho}
+								 : glm::vec3{1, 0, 0};
+			const float slant = glm::length(glm::vec2{height, rr});
+			const float side = (radius - rho) * height / slant;
+			const float bottom = oa.y, top = height - oa.y;
+			if (side <= bottom && side <= top) {
+				normal = (horizontal * height + glm::vec3{0, rr, 0}) / slant;
+			} else {
+				normal = {0, top < bottom ? 1.0f : -1.0f, 0};
+			}
+			return true;
+		}
+	}
+
+	const glm::vec3 rd = ray.dirNormalized;
+	const glm::vec3 ba = {0, height, 0};
+	const glm::vec3 ob = oa - ba;
+	const float m0 = height * height;
+	const float m1 = oa.y * height;
+	const float m2 = rd.y * height;
+	const float m3 = glm::dot(rd, oa);
+	const float m5 = glm::dot(oa, oa);
+	const float m9 = ob.y * height;
+
+	// caps
+	if (m1 < 0.0f) {
+		const glm::vec3 q = oa * m2 - rd * m1;
+		if (glm::dot(q, q) < ra * ra * m2 * m2) {
+			const float t = -m1 / m2 / ray.length;
+			if (t < 0.0f || t > 1.0f) {
+				return false;
+			}
+			near = t;
+			normal = {0, -1, 0};
+			return true;
+		}
+	} else if (m9 > 0.0f) {
+		const float t = -m9 / m2;
+		const glm::vec3 q = ob + rd * t;
+		if (glm::dot(q, q) < rb * rb) {
+			if (t < 0.0f || t > ray.length) {
+				return false;
+			}
+			near = t / ray.length;
+			normal = {0, 1, 0};
+			return true;
+		}
+	}
+
+	// body
+	const float hy = m0 + rr * rr;
+	const float k2 = m0 * m0 - m2 * m2 * hy;
+	const float k1 = m0 * m0 * m3 - m1 * m2 * hy + m0 * ra * (rr * m2);
+	const float k0 =
+		m0 * m0 * m5 - m1 * m1 * hy + m0 * ra * (rr * m1 * 2.0f - m0 * ra);
+	const float h = k1 * k1 - k2 * k0;
+	if (h < 0.0f) {
+		return false;
+	}
+	const float t = (-k1 - sqrt(h)) / k2;
+	const float y = m1 + t * m2;
+	if (y < 0.0f || y > m0 || t < 0.0f || t > ray.length) {
+		return false;
+	}
+	near = t / ray.length;
+	normal = glm::normalize(m0 * (m0 * (oa + t * rd) + rr * ba * ra) -
+							ba * hy * y);
+	return true;
+}
+
+bool VerticalCone::RayTest(const Transform &trans, const RayInfo &ray,
+						   float &near, glm::vec3 &normal) const
+{
+	return coneIntersect(ray, trans.pos, height, bottomRadius, topRadius, near,
+						 normal);
+}
+
+bool VerticalCone::RayTestLocal(const RayInfo &ray, float &near,
+								glm::vec3 &normal) const
+{
+	return coneIntersect(ray, {}, height, bottomRadius, topRadius, near,
+						 normal);
+}
+
+bool VerticalCone::OcclusionTest(const Transform &trans,
+								 const RayInfo &ray) const
+{
+	float near;
+	glm::vec3 normal;
+	return RayTest(trans, ray, near, normal);
+}
+
+bool VerticalCone::OverlapTest(const Transform &trans,
+							   const OverlapVolume &volume) const
+{
+	return OverlapTestCone(height, bottomRadius, topRadius,
+						   volume.ToLocal(trans));
+}
+
+bool VerticalCone::CylinderTestOnGround(const Transform &trans,
+										const Cylinder &cyl, glm::vec3 pos,
+										float &offsetHeight,
+										glm::vec3 *onGroundNormal,
+										bool *isOnEdge) const
+{
+	// Base disc of cylinder rests on the highest point of cone under it
+	const glm::vec3 localPos = pos - trans.pos;
+	const glm::vec2 localPos2d = {localPos.x, localPos.z};
+	const float len = glm::length(localPos2d);
+	const float d = len > cyl.radius ? len - cyl.radius : 0.0f;
+	const float maxRadius = glm::max(bottomRadius, topRadius);
+	if (d > maxRadius + ON_EDGE_FACTOR) {
+		return false;
+	}
+
+	if (d <= topRadius || topRadius >= bottomRadius) {
+		offsetHeight = localPos.y - height;
+		if (onGroundNormal) {
+			*onGroundNormal = {0, 1, 0};
+		}
+	} else {
+		const float rr = bottomRadius - topRadius;
+		const float dc = glm::min(d, bottomRadius);
+		offsetHeight = localPos.y - height * (bottomRadius - dc) / rr;
+		if (onGroundNormal) {
+			const glm::vec2 h = localPos2d * (height / len);
+			*onGroundNormal = glm::normalize(glm::vec3{h.x, rr, h.y});
+		}
+	}
+
+	if (isOnEdge) {
+		if (d > maxRadius) {
+			*isOnEdge = true;
+		}
+	}
+
+	return true;
+}
+
+// Horizontal slices of Minkowski sum with cylinder are discs of the widest
+// slice of cone over cylinder height, so the sum is cone and cylinder
+// stacked at the wider end of cone.
+bool VerticalCone::CylinderTestMovement(const Transform &trans,
+										float &validMovementFactor,
+										const Cylinder &cyl,
+										const RayInfo &movementRay,
+										glm::vec3 &normal) const
+{
+	const float r = cyl.radius;
+	const float h = cyl.height;
+	const float ra = bottomRadius + r;
+	const float rb = topRadius + r;
+	glm::vec3 conePos = trans.pos;
+	glm::vec3 cylPos = trans.pos - glm::vec3{0, h, 0};
+	Cylinder cyl2 = {h, ra};
+	if (topRadius > bottomRadius) {
+		conePos.y -= h;
+		cylPos.y += height;
+		cyl2.radius = rb;
+	}
+
+	bool res = false;
+	float vmf;
+	glm::vec3 no;
+	if (coneIntersect(movementRay, conePos, height, ra, rb, vmf, no)) {
+		validMovementFactor = vmf;
+		normal = no;
+		res = true;
+	}
+	if (cyl2.RayTest(Transform{cylPos, {}}, movementRay, vmf, no)) {
+		if (res == false || vmf < validMovementFactor) {
+			validMovementFactor = vmf;
+			normal = no;
+			res = true;
+		}
+	}
+	return res;
+}
+
+// Minkowski sum with sphere is union of both cap discs rounded by sphere and
+// cone of lateral side moved by radius along its normal, limited by heights
+// of moved rims.
+bool VerticalCone::SphereTestMovement(const Transform &trans,
+									  float &validMovementFactor,
+									  const Sphere &sph,
+									  const RayInfo &movementRay,
+									  glm::vec3 &normal) const
+{
+	const float r = sph.radius;
+	const float rr = bottomRadius - topRadius;
+	const float slant = glm::length(glm::vec2{height, rr});
+	const float nx = height / slant;
+	const float ny = rr / slant;
+
+	RayInfo ray = movementRay;
+	ray.start -= trans.pos;
+
+	bool res = false;
+	float vmf;
+	glm::vec3 no;
+	if (SweptSphereTestCylinder(0.0f, bottomRadius, r, ray, vmf, no)) {
+		validMovementFactor = vmf;
+		normal = no;
+		res = true;
+	}
+	RayInfo topRay = ray;
+	topRay.start.y -= height;
+	if (SweptSphereTestCylinder(0.0f, topRadius, r, topRay, vmf, no)) {
+		if (res == false || vmf < validMovementFactor) {
+			validMovementFactor = vmf;
+			normal = no;
+			res = true;
+		}
+	}
+	if (coneIntersect(ray, {0, r * ny, 0}, height, bottomRadius + r * nx,
+					  topRadius + r * nx, vmf, no)) {
+		if (res == false || vmf < validMovementFactor) {
+			validMovementFactor = vmf;
+			normal = no;
+			res = true;
+		}
+	}
+	return res;
+}
+} // namespace Collision3D
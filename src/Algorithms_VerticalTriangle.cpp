@@ -0,0 +1,197 @@
+// This file is part of Collision3D.
+// Copyright (c) 2025 Marek Zalewski aka Drwalin
+// You should have received a copy of the MIT License along with this program.
+
+#include "../include/collision3d/CollisionShapes_Primitives.hpp"
+
+namespace Collision3D
+{
+using namespace spp;
+
+static constexpr int VERTICAL_TRIANGLE_PLANES = 9;
+
+static bool PointInTriangle(glm::vec2 p, const glm::vec2 *v)
+{
+	bool neg = false, pos = false;
+	for (int i = 0; i < 3; ++i) {
+		const glm::vec2 a = v[i];
+		const glm::vec2 e = v[(i + 1) % 3] - a;
+		const float side = e.x * (p.y - a.y) - e.y * (p.x - a.x);
+		neg |= side < 0.0f;
+		pos |= side > 0.0f;
+	}
+	return !(neg && pos);
+}
+
+spp::Aabb VerticalTriangle::GetAabb(const Transform &trans) const
+{
+	const glm::vec3 a = trans.pos;
+	const glm::vec3 b = trans * glm::vec3{p1.x, p1.y, 0};
+	const glm::vec3 c = trans * glm::vec3{p2.x, p2.y, 0};
+	return {glm::min(a, glm::min(b, c)), glm::max(a, glm::max(b, c))};
+}
+
+bool VerticalTriangle::RayTest(const Transform &trans, const RayInfo &ray,
+							   float &near, glm::vec3 &normal) const
+{
+	if (RayTestLocal(trans.ToLocal(ray), near, normal)) {
+		normal = trans.rot * normal;
+		return true;
+	} else {
+		return false;
+	}
+}
+
+bool VerticalTriangle::RayTestLocal(const RayInfo &ray, float &near,
+									glm::vec3 &normal) const
+{
+	// Infinitely thin, rays parallel to plane do not hit
+	if (ray.dir.z == 0.0f) {
+		return false;
+	}
+	const float t = -ray.start.z / ray.dir.z;
+	if (t < 0.0f || t > 1.0f) {
+		return false;
+	}
+	const glm::vec2 v[3] = {{0, 0}, p1, p2};
+	const glm::vec2 p{ray.start.x + ray.dir.x * t,
+					  ray.start.y + ray.dir.y * t};
+	if (PointInTriangle(p, v) == false) {
+		return false;
+	}
+	near = t;
+	normal = {0, 0, ray.dir.z > 0.0f ? -1.0f : 1.0f};
+	return true;
+}
+
+bool VerticalTriangle::OcclusionTest(const Transform &trans,
+									 const RayInfo &ray) const
+{
+	float near;
+	glm::vec3 normal;
+	return RayTestLocal(trans.ToLocal(ray), near, normal);
+}
+
+bool VerticalTriangle::OverlapTest(const Transform &trans,
+								   const OverlapVolume &volume) const
+{
+	const glm::vec3 vertices[3] = {
+		{0, 0, 0}, {p1.x, p1.y, 0}, {p2.x, p2.y, 0}};
+	return OverlapTestConvex(vertices, 3, 0.0f, volume.ToLocal(trans));
+}
+
+// Standing on top edge of wall
+bool VerticalTriangle::CylinderTestOnGround(const Transform &trans,
+											const Cylinder &cyl, glm::vec3 pos,
+											float &offsetHeight,
+											glm::vec3 *onGroundNormal,
+											bool *isOnEdge) const
+{
+	const glm::vec3 localPos = trans.ToLocal(pos);
+	if (fabs(localPos.z) > cyl.radius + ON_EDGE_FACTOR) {
+		return false;
+	}
+
+	const glm::vec2 v[3] = {{0, 0}, p1, p2};
+	const float minx = glm::min(0.0f, glm::min(p1.x, p2.x));
+	const float maxx = glm::max(0.0f, glm::max(p1.x, p2.x));
+	const float x0 = glm::max(localPos.x - cyl.radius, minx);
+	const float x1 = glm::min(localPos.x + cyl.radius, maxx);
+	if (x0 > x1 + ON_EDGE_FACTOR) {
+		return false;
+	}
+
+	// Highest point of triangle above footprint, it is either vertex or
+	// crossing of edge with footprint boundary
+	float y = -1e30f;
+	for (int i = 0; i < 3; ++i) {
+		const glm::vec2 a = v[i];
+		const glm::vec2 b = v[(i + 1) % 3];
+		if (a.x >= x0 && a.x <= x1) {
+			y = glm::max(y, a.y);
+		}
+		if (a.x != b.x) {
+			for (const float x : {x0, x1}) {
+				const float f = (x - a.x) / (b.x - a.x);
+				if (f >= 0.0f && f <= 1.0f) {
+					y = glm::max(y, a.y + (b.y - a.y) * f);
+				}
+			}
+		}
+	}
+	if (y == -1e30f) {
+		// footprint only within ON_EDGE_FACTOR from triangle
+		const float x = x0 > maxx ? maxx : minx;
+		for (int i = 0; i < 3; ++i) {
+			if (v[i].x == x) {
+				y = glm::max(y, v[i].y);
+			}
+		}
+	}
+	offsetHeight = localPos.y - y;
+
+	if (onGroundNormal) {
+		*onGroundNormal = {0, 1, 0};
+	}
+
+	if (isOnEdge) {
+		*isOnEdge = true;
+	}
+
+	return true;
+}
+
+// Triangle expanded by square base prism of cylinder, all planes of
+// Minkowski sum of triangle (in z = 0) and box [-r, r] x [-h, 0] x [-r, r]
+bool VerticalTriangle::CylinderTestMovement(const Transform &trans,
+											float &validMovementFactor,
+											const Cylinder &cyl,
+											const RayInfo &movementRay,
+											glm::vec3 &normal) const
+{
+	const float r = cyl.radius;
+	const float h = cyl.height;
+	const glm::vec2 v[3] = {{0, 0}, p1, p2};
+	const glm::vec2 min = glm::min(v[0], glm::min(v[1], v[2]));
+	const glm::vec2 max = glm::max(v[0], glm::max(v[1], v[2]));
+
+	glm::vec3 n[VERTICAL_TRIANGLE_PLANES] = {
+		{0, 0, 1}, {0, 0, -1}, {1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}};
+	float offs[VERTICAL_TRIANGLE_PLANES] = {r, r, max.x + r, r - min.x, max.y,
+											h - min.y};
+	for (int i = 0; i < 3; ++i) {
+		const glm::vec2 a = v[i];
+		const glm::vec2 b = v[(i + 1) % 3];
+		glm::vec2 e{b.y - a.y, a.x - b.x};
+		if (glm::dot(e, v[(i + 2) % 3] - a) > 0.0f) {
+			e = -e;
+		}
+		n[6 + i] = {e.x, e.y, 0};
+		offs[6 + i] = glm::dot(e, a) + r * fabs(e.x) +
+					  (e.y < 0.0f ? -e.y * h : 0.0f);
+	}
+
+	if (RayTestConvex(n, offs, VERTICAL_TRIANGLE_PLANES,
+					  trans.ToLocal(movementRay), validMovementFactor,
+					  normal)) {
+		normal = trans.rot * normal;
+		return true;
+	}
+	return false;
+}
+
+bool VerticalTriangle::SphereTestMovement(const Transform &trans,
+										  float &validMovementFactor,
+										  const Sphere &sph,
+										  const RayInfo &movementRay,
+										  glm::vec3 &normal) const
+{
+	if (SweptSphereTestTriangle({0, 0, 0}, {p1.x, p1.y, 0}, {p2.x, p2.y, 0},
+								sph.radius, trans.ToLocal(movementRay),
+								validMovementFactor, normal)) {
+		normal = trans.rot * normal;
+		return true;
+	}
+	return false;
+}
+} // namespace Collision3D
@@ -0,0 +1,53 @@
+// This file is part of Collision3D.
+// Copyright (c) 2025 Marek Zalewski aka Drwalin
+// You should have received a copy of the MIT License along with this program.
+
+#pragma once
+
+#include "../include/collision3d/BatchTransform.hpp"
+
+namespace Collision3D
+{
+// Vector part of batch kernels. Each function processes leading elements in
+// multiples of its lane count and returns how many were processed, the
+// caller finishes the rest with scalar code. Kernels are compiled once per
+// instruction set in BatchKernels_*.cpp, entries are nullptr when compiler
+// did not enable that instruction set.
+struct BatchKernelTable {
+	uint32_t (*rotatePoints)(const Rotation *rotations, ConstVec3SoA in,
+							 Vec3SoA out, uint32_t count);
+	uint32_t (*toLocalPoints)(const Transform *transforms, ConstVec3SoA in,
+							  Vec3SoA out, uint32_t count);
+	// Rays of quarter turn transforms are not written, caller uses exact
+	// Transform::ToLocal for them
+	uint32_t (*transformRays)(const Transform *transforms,
+							  const RayInfo *rays, RayInfo *out,
+							  uint32_t count);
+	uint32_t (*cylinderAabbs)(const Cylinder *shapes,
+							  const Transform *transforms, AabbSoA out,
+							  uint32_t count);
+	uint32_t (*vertBoxAabbs)(const VertBox *shapes,
+							 const Transform *transforms, AabbSoA out,
+							 uint32_t count);
+	// Appends indices of hit aabbs to hitIds at hitsCount
+	uint32_t (*rayAabbs)(const RayInfo &ray, float cutFactor, AabbSoA aabbs,
+						 uint32_t count, uint32_t *hitIds,
+						 uint32_t &hitsCount);
+};
+
+namespace BatchKernels_Sse42
+{
+extern const BatchKernelTable table;
+}
+namespace BatchKernels_Avx2
+{
+extern const BatchKernelTable table;
+}
+namespace BatchKernels_Avx512
+{
+extern const BatchKernelTable table;
+}
+
+// Table selected by GetSimdIsa()/SetSimdIsa(), nullptr for scalar
+const BatchKernelTable *GetBatchKernels();
+} // namespace Collision3D
@@ -0,0 +1,7 @@
+// This file is part of Collision3D.
+// Copyright (c) 2025 Marek Zalewski aka Drwalin
+// You should have received a copy of the MIT License along with this program.
+
+// Compiled with AVX-512 flags, see CMakeLists.txt
+#define BATCH_KERNELS_NAMESPACE BatchKernels_Avx512
+#include "BatchKernels_Impl.hpp"
@@ -0,0 +1,458 @@
+// This file is part of Collision3D.
+// Copyright (c) 2025 Marek Zalewski aka Drwalin
+// You should have received a copy of the MIT License along with this program.
+
+// Included once by each BatchKernels_*.cpp with BATCH_KERNELS_NAMESPACE
+// defined. The including file is compiled with instruction set flags, so
+// nothing here may call inline functions of shared headers, otherwise linker
+// could pick their vectorised copy for generic code.
+
+#include <cstddef>
+
+// MSVC has no SSE4.2 switch and never defines __SSE4_2__, its intrinsics are
+// usable without flags. BatchKernels_Sse42.cpp defines BATCH_KERNELS_SSE4_2.
+#if defined(__SSE4_2__) ||                                                     \
+	(defined(BATCH_KERNELS_SSE4_2) && defined(_MSC_VER) &&                     \
+	 (defined(_M_X64) || defined(_M_IX86)))
+#define BATCH_KERNELS_SSE4_2_AVAILABLE
+#endif
+
+#if defined(BATCH_KERNELS_SSE4_2_AVAILABLE) || defined(__AVX2__) ||           \
+	defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+#include "BatchKernels.hpp"
+
+namespace Collision3D
+{
+namespace BATCH_KERNELS_NAMESPACE
+{
+#if defined(__AVX512F__)
+#define BATCH_KERNELS_ENABLED
+namespace
+{
+constexpr uint32_t LANES = 16;
+using Vf = __m512;
+using Vi = __m512i;
+using Mask = __mmask16;
+
+inline Vf Add(Vf a, Vf b) { return _mm512_add_ps(a, b); }
+inline Vf Sub(Vf a, Vf b) { return _mm512_sub_ps(a, b); }
+inline Vf Mul(Vf a, Vf b) { return _mm512_mul_ps(a, b); }
+inline Vf Div(Vf a, Vf b) { return _mm512_div_ps(a, b); }
+inline Vf Min(Vf a, Vf b) { return _mm512_min_ps(a, b); }
+inline Vf Max(Vf a, Vf b) { return _mm512_max_ps(a, b); }
+inline Vf Abs(Vf a) { return _mm512_abs_ps(a); }
+inline Vf Set1(float v) { return _mm512_set1_ps(v); }
+inline Vf LoadF(const float *p) { return _mm512_loadu_ps(p); }
+inline void StoreF(float *p, Vf v) { _mm512_storeu_ps(p, v); }
+inline Mask CmpEq(Vf a, Vf b) { return _mm512_cmp_ps_mask(a, b, _CMP_EQ_OQ); }
+inline Mask CmpLt(Vf a, Vf b) { return _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ); }
+inline Mask CmpLe(Vf a, Vf b) { return _mm512_cmp_ps_mask(a, b, _CMP_LE_OQ); }
+inline Mask And(Mask a, Mask b) { return a & b; }
+inline uint32_t Bits(Mask m) { return m; }
+inline Vf Select(Mask m, Vf ifFalse, Vf ifTrue)
+{
+	return _mm512_mask_blend_ps(m, ifFalse, ifTrue);
+}
+inline Vi LoadI(const int32_t *p) { return _mm512_load_si512(p); }
+inline Mask CmpEqI(Vi a, int32_t b)
+{
+	return _mm512_cmpeq_epi32_mask(a, _mm512_set1_epi32(b));
+}
+inline Vf GatherTable(const float *table, const int32_t *idx)
+{
+	return _mm512_i32gather_ps(LoadI(idx), table, 4);
+}
+inline Vf GatherStride(const float *base, int stride)
+{
+	const __m512i idx = _mm512_mullo_epi32(
+		_mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14,
+						  15),
+		_mm512_set1_epi32(stride));
+	return _mm512_i32gather_ps(idx, base, 4);
+}
+} // namespace
+#elif defined(__AVX2__)
+#define BATCH_KERNELS_ENABLED
+namespace
+{
+constexpr uint32_t LANES = 8;
+using Vf = __m256;
+using Vi = __m256i;
+using Mask = __m256;
+
+inline Vf Add(Vf a, Vf b) { return _mm256_add_ps(a, b); }
+inline Vf Sub(Vf a, Vf b) { return _mm256_sub_ps(a, b); }
+inline Vf Mul(Vf a, Vf b) { return _mm256_mul_ps(a, b); }
+inline Vf Div(Vf a, Vf b) { return _mm256_div_ps(a, b); }
+inline Vf Min(Vf a, Vf b) { return _mm256_min_ps(a, b); }
+inline Vf Max(Vf a, Vf b) { return _mm256_max_ps(a, b); }
+inline Vf Abs(Vf a)
+{
+	return _mm256_and_ps(a, _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF)));
+}
+inline Vf Set1(float v) { return _mm256_set1_ps(v); }
+inline Vf LoadF(const float *p) { return _mm256_loadu_ps(p); }
+inline void StoreF(float *p, Vf v) { _mm256_storeu_ps(p, v); }
+inline Mask CmpEq(Vf a, Vf b) { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+inline Mask CmpLt(Vf a, Vf b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+inline Mask CmpLe(Vf a, Vf b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+inline Mask And(Mask a, Mask b) { return _mm256_and_ps(a, b); }
+inline uint32_t Bits(Mask m) { return _mm256_movemask_ps(m); }
+inline Vf Select(Mask m, Vf ifFalse, Vf ifTrue)
+{
+	return _mm256_blendv_ps(ifFalse, ifTrue, m);
+}
+inline Vi LoadI(const int32_t *p) { return _mm256_load_si256((const Vi *)p); }
+inline Mask CmpEqI(Vi a, int32_t b)
+{
+	return _mm256_castsi256_ps(_mm256_cmpeq_epi32(a, _mm256_set1_epi32(b)));
+}
+inline Vf GatherTable(const float *table, const int32_t *idx)
+{
+	return _mm256_i32gather_ps(table, LoadI(idx), 4);
+}
+inline Vf GatherStride(const float *base, int stride)
+{
+	const __m256i idx = _mm256_mullo_epi32(
+		_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(stride));
+	return _mm256_i32gather_ps(base, idx, 4);
+}
+} // namespace
+#elif defined(BATCH_KERNELS_SSE4_2_AVAILABLE)
+#define BATCH_KERNELS_ENABLED
+namespace
+{
+// No gathers, lanes are loaded with scalar loads
+constexpr uint32_t LANES = 4;
+using Vf = __m128;
+using Vi = __m128i;
+using Mask = __m128;
+
+inline Vf Add(Vf a, Vf b) { return _mm_add_ps(a, b); }
+inline Vf Sub(Vf a, Vf b) { return _mm_sub_ps(a, b); }
+inline Vf Mul(Vf a, Vf b) { return _mm_mul_ps(a, b); }
+inline Vf Div(Vf a, Vf b) { return _mm_div_ps(a, b); }
+inline Vf Min(Vf a, Vf b) { return _mm_min_ps(a, b); }
+inline Vf Max(Vf a, Vf b) { return _mm_max_ps(a, b); }
+inline Vf Abs(Vf a)
+{
+	return _mm_and_ps(a, _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF)));
+}
+inline Vf Set1(float v) { return _mm_set1_ps(v); }
+inline Vf LoadF(const float *p) { return _mm_loadu_ps(p); }
+inline void StoreF(float *p, Vf v) { _mm_storeu_ps(p, v); }
+inline Mask CmpEq(Vf a, Vf b) { return _mm_cmpeq_ps(a, b); }
+inline Mask CmpLt(Vf a, Vf b) { return _mm_cmplt_ps(a, b); }
+inline Mask CmpLe(Vf a, Vf b) { return _mm_cmple_ps(a, b); }
+inline Mask And(Mask a, Mask b) { return _mm_and_ps(a, b); }
+inline uint32_t Bits(Mask m) { return _mm_movemask_ps(m); }
+inline Vf Select(Mask m, Vf ifFalse, Vf ifTrue)
+{
+	return _mm_blendv_ps(ifFalse, ifTrue, m);
+}
+inline Vi LoadI(const int32_t *p) { return _mm_load_si128((const Vi *)p); }
+inline Mask CmpEqI(Vi a, int32_t b)
+{
+	return _mm_castsi128_ps(_mm_cmpeq_epi32(a, _mm_set1_epi32(b)));
+}
+inline Vf GatherTable(const float *table, const int32_t *idx)
+{
+	return _mm_setr_ps(table[idx[0]], table[idx[1]], table[idx[2]],
+					   table[idx[3]]);
+}
+inline Vf GatherStride(const float *base, int stride)
+{
+	return _mm_setr_ps(base[0], base[stride], base[2 * stride],
+					   base[3 * stride]);
+}
+} // namespace
+#endif
+
+#if defined(BATCH_KERNELS_ENABLED)
+namespace
+{
+static_assert(sizeof(glm::vec2) == 2 * sizeof(float));
+
+struct Rot {
+	Vf c;
+	Vf s;
+};
+
+// idx holds doubled rotation values in range [0, 240]
+inline Rot GatherRotation(const int32_t *idx)
+{
+	const float *table = (const float *)Rotation::vecs;
+	return {GatherTable(table, idx), GatherTable(table + 1, idx)};
+}
+
+// x' = c*x + s*z, z' = -s*x + c*z, same as Rotation::operator*
+inline void Rotate(const Rot &r, Vf &x, Vf &z)
+{
+	const Vf nx = Add(Mul(r.c, x), Mul(r.s, z));
+	const Vf nz = Sub(Mul(r.c, z), Mul(r.s, x));
+	x = nx;
+	z = nz;
+}
+
+// Loads float at byte offset of LANES consecutive structs
+template <typename T>
+inline Vf GatherMember(const T *base, size_t offset)
+{
+	static_assert(sizeof(T) % sizeof(float) == 0);
+	return GatherStride((const float *)((const uint8_t *)base + offset),
+						sizeof(T) / sizeof(float));
+}
+
+inline Vf InvDir(Vf dir)
+{
+	return Select(CmpEq(dir, Set1(0.0f)), Div(Set1(1.0f), dir), Set1(1e18f));
+}
+
+inline void StoreAabbs(AabbSoA out, uint32_t i, Vf minX, Vf minY, Vf minZ,
+					   Vf maxX, Vf maxY, Vf maxZ)
+{
+	StoreF(out.min.x + i, minX);
+	StoreF(out.min.y + i, minY);
+	StoreF(out.min.z + i, minZ);
+	StoreF(out.max.x + i, maxX);
+	StoreF(out.max.y + i, maxY);
+	StoreF(out.max.z + i, maxZ);
+}
+
+// Inverse of Transform::rot, 0 maps to 240 which holds the same cos/sin
+inline void InverseRotations(const Transform *t, int32_t *idx)
+{
+	for (uint32_t l = 0; l < LANES; ++l) {
+		idx[l] = (240 - t[l].rot.value) * 2;
+	}
+}
+
+uint32_t RotatePoints(const Rotation *rotations, ConstVec3SoA in, Vec3SoA out,
+					  uint32_t count)
+{
+	uint32_t i = 0;
+	for (; i + LANES <= count; i += LANES) {
+		alignas(64) int32_t idx[LANES];
+		for (uint32_t l = 0; l < LANES; ++l) {
+			idx[l] = rotations[i + l].value * 2;
+		}
+		const Rot r = GatherRotation(idx);
+		Vf x = LoadF(in.x + i);
+		Vf z = LoadF(in.z + i);
+		Rotate(r, x, z);
+		StoreF(out.x + i, x);
+		StoreF(out.y + i, LoadF(in.y + i));
+		StoreF(out.z + i, z);
+	}
+	return i;
+}
+
+uint32_t ToLocalPoints(const Transform *transforms, ConstVec3SoA in,
+					   Vec3SoA out, uint32_t count)
+{
+	const size_t pos = offsetof(Transform, pos);
+	uint32_t i = 0;
+	for (; i + LANES <= count; i += LANES) {
+		const Transform *t = transforms + i;
+		alignas(64) int32_t idx[LANES];
+		InverseRotations(t, idx);
+		const Rot r = GatherRotation(idx);
+		Vf x = Sub(LoadF(in.x + i), GatherMember(t, pos));
+		const Vf y = Sub(LoadF(in.y + i), GatherMember(t, pos + 4));
+		Vf z = Sub(LoadF(in.z + i), GatherMember(t, pos + 8));
+		Rotate(r, x, z);
+		StoreF(out.x + i, x);
+		StoreF(out.y + i, y);
+		StoreF(out.z + i, z);
+	}
+	return i;
+}
+
+uint32_t TransformRays(const Transform *transforms, const RayInfo *rays,
+					   RayInfo *out, uint32_t count)
+{
+	const size_t pos = offsetof(Transform, pos);
+	const size_t start = offsetof(RayInfo, start);
+	const size_t dir = offsetof(RayInfo, dir);
+	const size_t dirN = offsetof(RayInfo, dirNormalized);
+	uint32_t i = 0;
+	for (; i + LANES <= count; i += LANES) {
+		const Transform *t = transforms + i;
+		const RayInfo *r = rays + i;
+		alignas(64) int32_t idx[LANES];
+		InverseRotations(t, idx);
+		const Rot rot = GatherRotation(idx);
+
+		Vf sx = Sub(GatherMember(r, start), GatherMember(t, pos));
+		const Vf sy = Sub(GatherMember(r, start + 4), GatherMember(t, pos + 4));
+		Vf sz = Sub(GatherMember(r, start + 8), GatherMember(t, pos + 8));
+		Rotate(rot, sx, sz);
+
+		Vf dx = GatherMember(r, dir);
+		const Vf dy = GatherMember(r, dir + 4);
+		Vf dz = GatherMember(r, dir + 8);
+		Rotate(rot, dx, dz);
+
+		Vf nx = GatherMember(r, dirN);
+		Vf nz = GatherMember(r, dirN + 8);
+		Rotate(rot, nx, nz);
+
+		const Vf ix = InvDir(dx);
+		const Vf iz = InvDir(dz);
+		const uint32_t signX = Bits(CmpLt(ix, Set1(0.0f)));
+		const uint32_t signZ = Bits(CmpLt(iz, Set1(0.0f)));
+
+		alignas(64) float v[12][LANES];
+		StoreF(v[0], sx);
+		StoreF(v[1], sy);
+		StoreF(v[2], sz);
+		StoreF(v[3], dx);
+		StoreF(v[4], dz);
+		StoreF(v[5], nx);
+		StoreF(v[6], nz);
+		StoreF(v[7], ix);
+		StoreF(v[8], iz);
+		StoreF(v[9], Add(sx, dx));
+		StoreF(v[10], Add(sy, dy));
+		StoreF(v[11], Add(sz, dz));
+
+		// Written back lane by lane, members of RayInfo are interleaved
+		for (uint32_t l = 0; l < LANES; ++l) {
+			if (t[l].rot.value % 60 == 0) {
+				continue;
+			}
+			RayInfo &o = out[i + l];
+			o = r[l];
+			o.start.x = v[0][l];
+			o.start.y = v[1][l];
+			o.start.z = v[2][l];
+			o.dir.x = v[3][l];
+			o.dir.z = v[4][l];
+			o.dirNormalized.x = v[5][l];
+			o.dirNormalized.z = v[6][l];
+			o.invDir.x = v[7][l];
+			o.invDir.z = v[8][l];
+			o.signs[0] = (signX >> l) & 1;
+			o.signs[2] = (signZ >> l) & 1;
+			o.end.x = v[9][l];
+			o.end.y = v[10][l];
+			o.end.z = v[11][l];
+		}
+	}
+	return i;
+}
+
+uint32_t CylinderAabbs(const Cylinder *shapes, const Transform *transforms,
+					   AabbSoA out, uint32_t count)
+{
+	const size_t pos = offsetof(Transform, pos);
+	uint32_t i = 0;
+	for (; i + LANES <= count; i += LANES) {
+		const Transform *t = transforms + i;
+		const Cylinder *c = shapes + i;
+		const Vf x = GatherMember(t, pos);
+		const Vf y = GatherMember(t, pos + 4);
+		const Vf z = GatherMember(t, pos + 8);
+		const Vf r = GatherMember(c, offsetof(Cylinder, radius));
+		const Vf h = GatherMember(c, offsetof(Cylinder, height));
+		StoreAabbs(out, i, Sub(x, r), y, Sub(z, r), Add(x, r), Add(y, h),
+				   Add(z, r));
+	}
+	return i;
+}
+
+uint32_t VertBoxAabbs(const VertBox *shapes, const Transform *transforms,
+					  AabbSoA out, uint32_t count)
+{
+	const size_t pos = offsetof(Transform, pos);
+	const size_t he = offsetof(VertBox, halfExtents);
+	uint32_t i = 0;
+	for (; i + LANES <= count; i += LANES) {
+		const Transform *t = transforms + i;
+		const VertBox *b = shapes + i;
+
+		// Same as VertBox::GetAabb, half turn does not change extents and
+		// quarter turns use exact 0 and 1 instead of table values
+		alignas(64) int32_t values[LANES];
+		alignas(64) int32_t idx[LANES];
+		for (uint32_t l = 0; l < LANES; ++l) {
+			const int v = t[l].rot.value;
+			values[l] = v >= 120 ? v - 120 : v;
+			idx[l] = values[l] * 2;
+		}
+		const Vi v = LoadI(values);
+		const Rot rot = GatherRotation(idx);
+		const Mask zeroTurn = CmpEqI(v, 0);
+		const Mask quarterTurn = CmpEqI(v, 60);
+		const Vf c = Select(zeroTurn,
+							Select(quarterTurn, Abs(rot.c), Set1(0.0f)),
+							Set1(1.0f));
+		const Vf s = Select(zeroTurn,
+							Select(quarterTurn, Abs(rot.s), Set1(1.0f)),
+							Set1(0.0f));
+
+		const Vf hx = GatherMember(b, he);
+		const Vf hy = GatherMember(b, he + 4);
+		const Vf hz = GatherMember(b, he + 8);
+		const Vf ex = Add(Mul(c, hx), Mul(s, hz));
+		const Vf ez = Add(Mul(s, hx), Mul(c, hz));
+
+		const Vf x = GatherMember(t, pos);
+		const Vf y = GatherMember(t, pos + 4);
+		const Vf z = GatherMember(t, pos + 8);
+		StoreAabbs(out, i, Sub(x, ex), y, Sub(z, ez), Add(x, ex),
+				   Add(y, Add(hy, hy)), Add(z, ez));
+	}
+	return i;
+}
+
+// Slab test of single ray against LANES aabbs at once
+uint32_t RayAabbs(const RayInfo &ray, float cutFactor, AabbSoA aabbs,
+				  uint32_t count, uint32_t *hitIds, uint32_t &hitsCount)
+{
+	const Vf sx = Set1(ray.start.x);
+	const Vf sy = Set1(ray.start.y);
+	const Vf sz = Set1(ray.start.z);
+	const Vf ix = Set1(ray.invDir.x);
+	const Vf iy = Set1(ray.invDir.y);
+	const Vf iz = Set1(ray.invDir.z);
+	const Vf cut = Set1(cutFactor);
+	const Vf zero = Set1(0.0f);
+	uint32_t i = 0;
+	for (; i + LANES <= count; i += LANES) {
+		const Vf ax = Mul(Sub(LoadF(aabbs.min.x + i), sx), ix);
+		const Vf ay = Mul(Sub(LoadF(aabbs.min.y + i), sy), iy);
+		const Vf az = Mul(Sub(LoadF(aabbs.min.z + i), sz), iz);
+		const Vf bx = Mul(Sub(LoadF(aabbs.max.x + i), sx), ix);
+		const Vf by = Mul(Sub(LoadF(aabbs.max.y + i), sy), iy);
+		const Vf bz = Mul(Sub(LoadF(aabbs.max.z + i), sz), iz);
+		const Vf tNear = Max(Max(Min(ax, bx), Min(ay, by)), Min(az, bz));
+		const Vf tFar = Min(Min(Max(ax, bx), Max(ay, by)), Max(az, bz));
+		const uint32_t bits = Bits(And(
+			And(CmpLe(tNear, tFar), CmpLe(zero, tFar)), CmpLe(tNear, cut)));
+		if (bits) {
+			for (uint32_t l = 0; l < LANES; ++l) {
+				if ((bits >> l) & 1) {
+					hitIds[hitsCount++] = i + l;
+				}
+			}
+		}
+	}
+	return i;
+}
+} // namespace
+
+const BatchKernelTable table = {RotatePoints,  ToLocalPoints, TransformRays,
+								CylinderAabbs, VertBoxAabbs,  RayAabbs};
+#else
+const BatchKernelTable table = {nullptr, nullptr, nullptr,
+								nullptr, nullptr, nullptr};
+#endif
+
+#undef BATCH_KERNELS_ENABLED
+#undef BATCH_KERNELS_SSE4_2_AVAILABLE
+} // namespace BATCH_KERNELS_NAMESPACE
+} // namespace Collision3D
@@ -0,0 +1,8 @@
+// This file is part of Collision3D.
+// Copyright (c) 2025 Marek Zalewski aka Drwalin
+// You should have received a copy of the MIT License along with this program.
+
+// Compiled with SSE4.2 flags, see CMakeLists.txt
+#define BATCH_KERNELS_NAMESPACE BatchKernels_Sse42
+#define BATCH_KERNELS_SSE4_2
+#include "BatchKernels_Impl.hpp"
@@ -0,0 +1,549 @@
+// This file is part of Collision3D.
+// Copyright (c) 2025 Marek Zalewski aka Drwalin
+// You should have received a copy of the MIT License along with this program.
+
+#include <cstring>
+#include <cstdlib>
+
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+#include "../include/collision3d/CompactBvh.hpp"
+
+namespace Collision3D
+{
+namespace
+{
+struct BuildItem {
+	spp::Aabb aabb;
+	glm::vec3 center;
+	uint32_t id;
+	LayerMask mask;
+};
+
+float Area(const spp::Aabb &aabb)
+{
+	const glm::vec3 e = aabb.max - aabb.min;
+	return e.x * e.y + e.y * e.z + e.z * e.x;
+}
+
+using NodeList = std::vector<CompactBvhNode<float>>;
+
+// Workers persist between builds, so rebuilds don't pay for thread creation.
+// Waiting thread runs queued jobs itself, nested subtrees never leave all
+// workers blocked.
+class BuildPool
+{
+public:
+	struct Job {
+		std::function<void()> run;
+		// guarded by mutex
+		bool done = false;
+	};
+
+	// Workers are joined at exit
+	static BuildPool &Get()
+	{
+		static BuildPool pool;
+		return pool;
+	}
+
+	bool HasWorkers() const { return workers.empty() == false; }
+
+	void Push(Job *job)
+	{
+		{
+			std::lock_guard lock(mutex);
+			queue.push_back(job);
+		}
+		workCv.notify_one();
+	}
+
+	// Sleeps only when queue is empty, job is then run by other thread,
+	// which never waits for this one.
+	void Wait(Job *job)
+	{
+		std::unique_lock lock(mutex);
+		while (job->done == false) {
+			if (queue.empty()) {
+				doneCv.wait(lock);
+				continue;
+			}
+			Job *other = queue.back();
+			queue.pop_back();
+			lock.unlock();
+			Run(other);
+			lock.lock();
+		}
+	}
+
+private:
+	BuildPool()
+	{
+		const int count =
+			std::max((int)std::thread::hardware_concurrency() - 1, 0);
+		workers.reserve(count);
+		for (int i = 0; i < count; ++i) {
+			workers.emplace_back([this]() { Work(); });
+		}
+	}
+
+	~BuildPool()
+	{
+		{
+			std::lock_guard lock(mutex);
+			stop = true;
+		}
+		workCv.notify_all();
+		for (std::thread &worker : workers) {
+			worker.join();
+		}
+	}
+
+	void Run(Job *job)
+	{
+		job->run();
+		{
+			std::lock_guard lock(mutex);
+			job->done = true;
+		}
+		doneCv.notify_all();
+	}
+
+	void Work()
+	{
+		std::unique_lock lock(mutex);
+		while (true) {
+			workCv.wait(lock,
+						[this]() { return stop || queue.empty() == false; });
+			if (queue.empty()) {
+				return;
+			}
+			Job *job = queue.back();
+			queue.pop_back();
+			lock.unlock();
+			Run(job);
+			lock.lock();
+		}
+	}
+
+	std::mutex mutex;
+	std::condition_variable workCv;
+	std::condition_variable doneCv;
+	std::vector<Job *> queue;
+	std::vector<std::thread> workers;
+	bool stop = false;
+};
+
+struct Builder {
+	std::vector<BuildItem> items;
+	BvhBuilder type;
+
+	// Appends subtree to nodes. Indices of internal nodes are relative to
+	// nodes[0], leaf indices are absolute offsets into items.
+	void BuildNode(uint32_t begin, uint32_t end, uint32_t depth,
+				   NodeList &nodes)
+	{
+		const uint32_t nodeId = nodes.size();
+		nodes.push_back({});
+
+		spp::Aabb aabb = items[begin].aabb;
+		spp::Aabb centers = {items[begin].center, items[begin].center};
+		for (uint32_t i = begin + 1; i < end; ++i) {
+			aabb = aabb + items[i].aabb;
+			centers = centers + spp::Aabb{items[i].center, items[i].center};
+		}
+		for (int i = 0; i < 3; ++i) {
+			nodes[nodeId].min[i] = aabb.min[i];
+			nodes[nodeId].max[i] = aabb.max[i];
+		}
+
+		uint32_t mid = 0;
+		bool leaf = end - begin <= CompactBvh::MAX_LEAF_ITEMS ||
+					depth + 1 >= CompactBvh::MAX_DEPTH;
+		if (leaf == false) {
+			// Median split in lower half of depth limit keeps leaves small
+			// even for degenerate SAH splits
+			if (type == BvhBuilder::BINNED_SAH &&
+				depth < CompactBvh::MAX_DEPTH / 2) {
+				mid = SplitSah(begin, end, aabb, centers, leaf);
+			} else {
+				mid = SplitMedian(begin, end, centers);
+			}
+		}
+		if (leaf) {
+			assert(end - begin <= CompactBvhNode<float>::MAX_COUNT);
+			nodes[nodeId].index = begin;
+			nodes[nodeId].count = end - begin;
+			nodes[nodeId].mask = 0;
+			for (uint32_t i = begin; i < end; ++i) {
+				nodes[nodeId].mask |= items[i].mask;
+			}
+			return;
+		}
+
+		if (end - begin >= CompactBvh::PARALLEL_MIN_ITEMS &&
+			BuildPool::Get().HasWorkers()) {
+			NodeList first;
+			BuildPool::Job job;
+			job.run = [&]() { BuildNode(begin, mid, depth + 1, first); };
+			BuildPool::Get().Push(&job);
+			NodeList second;
+			BuildNode(mid, end, depth + 1, second);
+			BuildPool::Get().Wait(&job);
+			Append(nodes, first);
+			nodes[nodeId].index = nodes.size();
+			Append(nodes, second);
+		} else {
+			BuildNode(begin, mid, depth + 1, nodes);
+			nodes[nodeId].index = nodes.size();
+			BuildNode(mid, end, depth + 1, nodes);
+		}
+		nodes[nodeId].count = 0;
+		nodes[nodeId].mask =
+			nodes[nodeId + 1].mask | nodes[nodes[nodeId].index].mask;
+	}
+
+	static void Append(NodeList &nodes, const NodeList &sub)
+	{
+		const uint32_t offset = nodes.size();
+		for (CompactBvhNode<float> n : sub) {
+			if (n.count == 0) {
+				n.index += offset;
+			}
+			nodes.push_back(n);
+		}
+	}
+
+	static int LongestAxis(const spp::Aabb &aabb)
+	{
+		const glm::vec3 ext = aabb.max - aabb.min;
+		int axis = 0;
+		if (ext.y > ext[axis]) {
+			axis = 1;
+		}
+		if (ext.z > ext[axis]) {
+			axis = 2;
+		}
+		return axis;
+	}
+
+	uint32_t SplitMedian(uint32_t begin, uint32_t end,
+						 const spp::Aabb &centers)
+	{
+		const int axis = LongestAxis(centers);
+		const uint32_t mid = (begin + end) / 2;
+		std::nth_element(items.begin() + begin, items.begin() + mid,
+						 items.begin() + end,
+						 [axis](const BuildItem &a, const BuildItem &b) {
+							 return a.center[axis] < b.center[axis];
+						 });
+		return mid;
+	}
+
+	uint32_t SplitSah(uint32_t begin, uint32_t end, const spp::Aabb &aabb,
+					  const spp::Aabb &centers, bool &leaf)
+	{
+		constexpr uint32_t BINS = CompactBvh::SAH_BINS;
+		const uint32_t count = end - begin;
+
+		float bestCost = std::numeric_limits<float>::max();
+		int bestAxis = -1;
+		uint32_t bestBin = 0;
+
+		for (int axis = 0; axis < 3; ++axis) {
+			const float cmin = centers.min[axis];
+			const float ext = centers.max[axis] - cmin;
+			if (ext <= 0.0f) {
+				continue;
+			}
+			const float binScale = BINS / ext;
+
+			spp::Aabb bounds[BINS];
+			uint32_t counts[BINS] = {0};
+			for (uint32_t i = 0; i < BINS; ++i) {
+				bounds[i] = spp::AABB_INVALID;
+			}
+			for (uint32_t i = begin; i < end; ++i) {
+				const uint32_t b = glm::min<uint32_t>(
+					(items[i].center[axis] - cmin) * binScale, BINS - 1);
+				bounds[b] = bounds[b] + items[i].aabb;
+				++counts[b];
+			}
+
+			float rightArea[BINS];
+			uint32_t rightCount[BINS];
+			spp::Aabb acc = spp::AABB_INVALID;
+			uint32_t accCount = 0;
+			for (uint32_t i = BINS - 1; i > 0; --i) {
+				acc = acc + bounds[i];
+				accCount += counts[i];
+				rightArea[i] = accCount ? Area(acc) : 0.0f;
+				rightCount[i] = accCount;
+			}
+
+			acc = spp::AABB_INVALID;
+			accCount = 0;
+			for (uint32_t i = 0; i + 1 < BINS; ++i) {
+				acc = acc + bounds[i];
+				accCount += counts[i];
+				if (accCount == 0 || rightCount[i + 1] == 0) {
+					continue;
+				}
+				const float cost = accCount * Area(acc) +
+								   rightCount[i + 1] * rightArea[i + 1];
+				if (cost < bestCost) {
+					bestCost = cost;
+					bestAxis = axis;
+					bestBin = i + 1;
+				}
+			}
+		}
+
+		if (bestAxis < 0) {
+			// all centers are in the same point
+			if (count <= CompactBvh::MAX_SAH_LEAF_ITEMS) {
+				leaf = true;
+				return 0;
+			}
+			return (begin + end) / 2;
+		}
+
+		// traversal cost relative to single item test
+		const float area = Area(aabb);
+		const float splitCost = 0.5f + bestCost / glm::max(area, 1e-20f);
+		if (count <= CompactBvh::MAX_SAH_LEAF_ITEMS && splitCost >= count) {
+			leaf = true;
+			return 0;
+		}
+
+		const float cmin = centers.min[bestAxis];
+		const float binScale = BINS / (centers.max[bestAxis] - cmin);
+		auto it = std::partition(
+			items.begin() + begin, items.begin() + end,
+			[=](const BuildItem &item) {
+				return glm::min<uint32_t>((item.center[bestAxis] - cmin) *
+											  binScale,
+										  BINS - 1) < bestBin;
+			});
+		const uint32_t mid = it - items.begin();
+		if (mid == begin || mid == end) {
+			return SplitMedian(begin, end, centers);
+		}
+		return mid;
+	}
+};
+
+template <typename T>
+void *Store(const CompactBvh &bvh, const Builder &builder,
+			const NodeList &src)
+{
+	const size_t nodesBytes = src.size() * sizeof(CompactBvhNode<T>);
+	const size_t itemsBytes = builder.items.size() * sizeof(uint32_t);
+	void *data = malloc(nodesBytes + itemsBytes);
+
+	CompactBvhNode<T> *nodes = (CompactBvhNode<T> *)data;
+	for (size_t i = 0; i < src.size(); ++i) {
+		const spp::Aabb aabb = {{src[i].min[0], src[i].min[1], src[i].min[2]},
+								{src[i].max[0], src[i].max[1], src[i].max[2]}};
+		bvh.EncodeBounds(aabb, nodes[i]);
+		nodes[i].index = src[i].index;
+		nodes[i].count = src[i].count;
+		nodes[i].mask = src[i].mask;
+	}
+
+	uint32_t *items = (uint32_t *)((uint8_t *)data + nodesBytes);
+	for (size_t i = 0; i < builder.items.size(); ++i) {
+		items[i] = builder.items[i].id;
+	}
+	return data;
+}
+
+size_t NodeSize(BvhNodeFormat format)
+{
+	switch (format) {
+	case BvhNodeFormat::FLOAT:
+		return sizeof(CompactBvhNode<float>);
+	case BvhNodeFormat::QUANTIZED_16:
+		return sizeof(CompactBvhNode<uint16_t>);
+	case BvhNodeFormat::QUANTIZED_8:
+		return sizeof(CompactBvhNode<uint8_t>);
+	}
+	return 0;
+}
+
+} // namespace
+
+CompactBvh::~CompactBvh() { Clear(); }
+
+CompactBvh::CompactBvh(const CompactBvh &other) { *this = other; }
+
+CompactBvh::CompactBvh(CompactBvh &&other) { *this = std::move(other); }
+
+CompactBvh &CompactBvh::operator=(const CompactBvh &other)
+{
+	if (this == &other) {
+		return *this;
+	}
+	Clear();
+	totalAabb = other.totalAabb;
+	scale = other.scale;
+	invScale = other.invScale;
+	nodesCount = other.nodesCount;
+	itemsCount = other.itemsCount;
+	format = other.format;
+	builder = other.builder;
+	buildCost = other.buildCost;
+	refitParents = other.refitParents;
+	refitLeaves = other.refitLeaves;
+	refitChangedSinceCheck = other.refitChangedSinceCheck;
+	if (other.data) {
+		const size_t bytes = GetMemoryUsage() - sizeof(CompactBvh);
+		data = malloc(bytes);
+		memcpy(data, other.data, bytes);
+	}
+	return *this;
+}
+
+CompactBvh &CompactBvh::operator=(CompactBvh &&other)
+{
+	if (this == &other) {
+		return *this;
+	}
+	Clear();
+	totalAabb = other.totalAabb;
+	scale = other.scale;
+	invScale = other.invScale;
+	nodesCount = other.nodesCount;
+	itemsCount = other.itemsCount;
+	format = other.format;
+	builder = other.builder;
+	buildCost = other.buildCost;
+	refitParents = std::move(other.refitParents);
+	refitLeaves = std::move(other.refitLeaves);
+	refitChangedSinceCheck = other.refitChangedSinceCheck;
+	data = other.data;
+	other.data = nullptr;
+	other.nodesCount = 0;
+	other.itemsCount = 0;
+	return *this;
+}
+
+void CompactBvh::Clear()
+{
+	if (data) {
+		free(data);
+		data = nullptr;
+	}
+	nodesCount = 0;
+	itemsCount = 0;
+	totalAabb = spp::AABB_INVALID;
+	refitParents.clear();
+	refitLeaves.clear();
+	refitChangedSinceCheck = 0;
+}
+
+size_t CompactBvh::GetMemoryUsage() const
+{
+	return sizeof(CompactBvh) + nodesCount * NodeSize(format) +
+		   itemsCount * sizeof(uint32_t);
+}
+
+void CompactBvh::Build(const spp::Aabb *aabbs, uint32_t count,
+					   BvhNodeFormat format, BvhBuilder builderType,
+					   const LayerMask *masks)
+{
+	Clear();
+	this->format = format;
+	this->builder = builderType;
+	if (count == 0) {
+		return;
+	}
+
+	Builder state;
+	state.type = builderType;
+	state.items.resize(count);
+	for (uint32_t i = 0; i < count; ++i) {
+		state.items[i] = {aabbs[i], (aabbs[i].min + aabbs[i].max) * 0.5f, i,
+						  masks ? masks[i] : LAYER_MASK_ALL};
+	}
+	NodeList nodes;
+	nodes.reserve(count * 2);
+	state.BuildNode(0, count, 0, nodes);
+
+	totalAabb.min = {nodes[0].min[0], nodes[0].min[1], nodes[0].min[2]};
+	totalAabb.max = {nodes[0].max[0], nodes[0].max[1], nodes[0].max[2]};
+
+	// Index and count of quantized nodes are narrower, trees that don't fit
+	// in them are stored as float
+	if (format != BvhNodeFormat::FLOAT) {
+		using Q = CompactBvhNode<uint8_t>;
+		bool fits = nodes.size() <= Q::MAX_INDEX && count <= Q::MAX_INDEX;
+		for (uint32_t i = 0; fits && i < nodes.size(); ++i) {
+			fits = nodes[i].count <= Q::MAX_COUNT;
+		}
+		if (fits == false) {
+			format = BvhNodeFormat::FLOAT;
+			this->format = format;
+		}
+	}
+
+	SetFrame(totalAabb);
+
+	nodesCount = nodes.size();
+	itemsCount = count;
+
+	switch (format) {
+	case BvhNodeFormat::FLOAT:
+		data = Store<float>(*this, state, nodes);
+		break;
+	case BvhNodeFormat::QUANTIZED_16:
+		data = Store<uint16_t>(*this, state, nodes);
+		break;
+	case BvhNodeFormat::QUANTIZED_8:
+		data = Store<uint8_t>(*this, state, nodes);
+		break;
+	}
+	buildCost = ComputeCost();
+}
+
+void CompactBvh::SetFrame(const spp::Aabb &aabb)
+{
+	totalAabb = aabb;
+	float qmax = 1.0f;
+	switch (format) {
+	case BvhNodeFormat::FLOAT:
+		return;
+	case BvhNodeFormat::QUANTIZED_16:
+		qmax = std::numeric_limits<uint16_t>::max();
+		break;
+	case BvhNodeFormat::QUANTIZED_8:
+		qmax = std::numeric_limits<uint8_t>::max();
+		break;
+	}
+	const glm::vec3 ext = totalAabb.max - totalAabb.min;
+	for (int i = 0; i < 3; ++i) {
+		// slightly enlarged so that qmax covers whole extent after rounding
+		scale[i] = ext[i] > 0.0f ? (ext[i] / qmax) * 1.0001f : 1.0f;
+		invScale[i] = 1.0f / scale[i];
+	}
+}
+
+float CompactBvh::ComputeCost() const
+{
+	switch (format) {
+	case BvhNodeFormat::FLOAT:
+		return ComputeCostImpl<float>();
+	case BvhNodeFormat::QUANTIZED_16:
+		return ComputeCostImpl<uint16_t>();
+	case BvhNodeFormat::QUANTIZED_8:
+		return ComputeCostImpl<uint8_t>();
+	}
+	return 0.0f;
+}
+} // namespace Collision3D